@@ -242,6 +242,9 @@ enum
 /*! User PSKEY to store HFP configuration */
 #define PS_HFP_CONFIG           (1)
 
+/*! User PSKEY to store idle power statistics */
+#define PS_POWER_IDLE           (2)
+
 /*! Application task data */
 typedef struct appTaskData
 {
@@ -18,6 +18,7 @@
 #include <kalimba_standard_messages.h>
 #include <ps.h>
 #include <audio.h>
+#include <vm.h>
 #include <string.h>
 
 #include "av_headset.h"
@@ -53,6 +54,8 @@ a2dp-->a2dp:A2DP_INTERNAL_MEDIA_START_REQ
 
 /* Local Function Prototypes */
 static void appA2dpSetState(avInstanceTaskData *theInst, avA2dpState a2dp_state);
+static void appA2dpHandleInternalA2dpSuspendRequest(avInstanceTaskData *theInst,
+                                                    const AV_INTERNAL_A2DP_SUSPEND_MEDIA_REQ_T *req);
 
 /*! \brief Convert from Sink SEID to Source SEID
     \param seid The sink seid to convert
@@ -68,7 +71,7 @@ uint8 appA2dpConvertSeidFromSinkToSource(uint8 seid)
         case AV_SEID_SBC_SNK:
             return AV_SEID_SBC_MONO_TWS_SRC;
         case AV_SEID_AAC_SNK:
-            return appConfigAACStereoForwarding() ?
+            return appAvAacForwardingIsPassthrough() ?
                     AV_SEID_AAC_STEREO_TWS_SRC :
                     AV_SEID_SBC_MONO_TWS_SRC;
         case AV_SEID_APTX_SNK:
@@ -155,6 +158,133 @@ void appA2dpSetDefaultAttributes(appDeviceAttributes *attributes)
     attributes->a2dp_volume = (appConfigDefaultVolumedB() - appConfigMinVolumedB()) * 127 / rangeDb;
 }
 
+/*! \brief Get the SEID cached for a handset
+
+    The cached SEID is only valid if the endpoint capabilities have not
+    changed since it was cached.
+
+    \param theInst The AV instance
+    \return The cached SEID, AV_SEID_INVALID if there is none.
+*/
+static uint8 appA2dpGetCachedSeid(avInstanceTaskData *theInst)
+{
+    avTaskData *theAv = appGetAv();
+    appDeviceAttributes attributes;
+
+    if (appConfigA2dpSeidCacheEnabled() &&
+        appDeviceFindBdAddrAttributes(&theInst->bd_addr, &attributes) &&
+        appA2dpIsSeidNonTwsSink(attributes.a2dp_cached_seid) &&
+        (attributes.a2dp_caps_version == appAvCapsVersion()))
+    {
+        DEBUG_LOGF("appA2dpGetCachedSeid(%p), hit, seid %u", (void *)theInst, attributes.a2dp_cached_seid);
+        theAv->seid_cache_hits += 1;
+        return (uint8)attributes.a2dp_cached_seid;
+    }
+
+    DEBUG_LOGF("appA2dpGetCachedSeid(%p), miss", (void *)theInst);
+    theAv->seid_cache_misses += 1;
+    return AV_SEID_INVALID;
+}
+
+/*! \brief Cache the SEID of the media channel opened to a handset
+
+    \param theInst The AV instance
+    \param seid    SEID to cache, AV_SEID_INVALID to clear the cache.
+*/
+static void appA2dpSetCachedSeid(avInstanceTaskData *theInst, uint8 seid)
+{
+    appDeviceAttributes attributes;
+    uint16 caps_version = appAvCapsVersion();
+
+    if (!appConfigA2dpSeidCacheEnabled() || !appDeviceIsHandset(&theInst->bd_addr))
+        return;
+
+    /* Only write to PS if the cached SEID has changed */
+    if (appDeviceFindBdAddrAttributes(&theInst->bd_addr, &attributes) &&
+        ((attributes.a2dp_cached_seid != seid) || (attributes.a2dp_caps_version != caps_version)))
+    {
+        DEBUG_LOGF("appA2dpSetCachedSeid(%p), seid %u, version 0x%x", (void *)theInst, seid, caps_version);
+        attributes.a2dp_cached_seid = seid;
+        attributes.a2dp_caps_version = caps_version;
+        appDeviceSetAttributes(&theInst->bd_addr, &attributes);
+    }
+}
+
+/*! \brief Choose the output latency for audio from a device
+
+    Handsets whose recent streams needed robust forwarding to the peer are
+    played with extra buffering, otherwise handsets marked as needing low
+    latency are played with low latency.  The TWS slave follows the time to
+    play set by the master.
+*/
+static kymeraLatencyMode appA2dpSelectLatencyMode(avInstanceTaskData *theInst)
+{
+    appDeviceAttributes attributes;
+
+    if (!appDeviceIsHandset(&theInst->bd_addr) ||
+        !appDeviceFindBdAddrAttributes(&theInst->bd_addr, &attributes))
+        return KYMERA_LATENCY_NORMAL;
+
+    if (attributes.a2dp_congestion >= appConfigA2dpRobustLatencyCongestion())
+        return KYMERA_LATENCY_ROBUST;
+    if (attributes.a2dp_low_latency)
+        return KYMERA_LATENCY_LOW;
+
+    return KYMERA_LATENCY_NORMAL;
+}
+
+/*! \brief Update the handset's history of streams that needed robust forwarding */
+static void appA2dpUpdateCongestionHistory(avInstanceTaskData *theInst)
+{
+    appDeviceAttributes attributes;
+
+    if (appDeviceIsHandset(&theInst->bd_addr) &&
+        appDeviceFindBdAddrAttributes(&theInst->bd_addr, &attributes))
+    {
+        uint8 congestion = attributes.a2dp_congestion;
+
+        if (appKymeraA2dpForwardingWasRobust())
+        {
+            if (congestion < appConfigA2dpCongestionMax())
+                congestion++;
+        }
+        else if (congestion)
+            congestion--;
+
+        /* Only write to PS if the history has changed */
+        if (congestion != attributes.a2dp_congestion)
+        {
+            DEBUG_LOGF("appA2dpUpdateCongestionHistory(%p), congestion %u", (void *)theInst, congestion);
+            attributes.a2dp_congestion = congestion;
+            appDeviceSetAttributes(&theInst->bd_addr, &attributes);
+        }
+    }
+}
+
+/*! \brief Mark a handset's content as needing low latency audio
+
+    Takes effect from the next time audio from the handset starts.
+
+    \param bd_addr     Address of the handset
+    \param low_latency TRUE for low latency, e.g. gaming, FALSE for normal latency
+
+    \return TRUE if the handset is known.
+*/
+bool appA2dpSetLowLatency(const bdaddr *bd_addr, bool low_latency)
+{
+    appDeviceAttributes attributes;
+
+    if (!appDeviceIsHandset(bd_addr) || !appDeviceFindBdAddrAttributes(bd_addr, &attributes))
+        return FALSE;
+
+    if (attributes.a2dp_low_latency != low_latency)
+    {
+        attributes.a2dp_low_latency = low_latency;
+        appDeviceSetAttributes(bd_addr, &attributes);
+    }
+    return TRUE;
+}
+
 /*! \brief Start audio, sending a delay report if supported. */
 static void appA2dpStartAudio(avInstanceTaskData *theInst)
 {
@@ -165,15 +295,17 @@ static void appA2dpStartAudio(avInstanceTaskData *theInst)
     if (codec_settings)
     {
         bool is_sink_non_tws_codec = appA2dpIsSinkNonTwsCodec(theInst);
+        kymeraLatencyMode latency_mode = appA2dpSelectLatencyMode(theInst);
         appA2dpSetKymeraLockBit(theInst);
         appKymeraA2dpStart(&theInst->av_task, codec_settings, appAvVolumeGet(),
-            is_sink_non_tws_codec ? MESSAGES_FROM_SYNC_IND_TO_A2DP_START_REQ : 0);
+            is_sink_non_tws_codec ? MESSAGES_FROM_SYNC_IND_TO_A2DP_START_REQ : 0,
+            latency_mode);
         if (is_sink_non_tws_codec && codec_settings->codecData.latency_reporting)
         {
             /* Send delay report to audio source if it supports it.  Delay report
                units are 1/10ms, so multiply latency by 10 */
             A2dpMediaAvSyncDelayRequest(theInst->a2dp.device_id, theInst->a2dp.current_seid,
-                                        TWS_STANDARD_LATENCY_MS * 10);
+                                        appKymeraA2dpLatencyMs(latency_mode) * 10);
         }
         free(codec_settings);
     }
@@ -189,6 +321,151 @@ static void appA2dpStopAudio(avInstanceTaskData *theInst)
     appKymeraA2dpStop(NULL, theInst->a2dp.current_seid, StreamSourceFromSink(theInst->a2dp.media_sink));
 }
 
+/*! Upper limits in milliseconds of the A2DP start histogram buckets, the
+    last bucket holds everything above the final limit */
+static const uint16 a2dp_start_histogram_limits[A2DP_START_HISTOGRAM_BUCKETS - 1] =
+{
+    50, 100, 200, 500, 1000
+};
+
+/*! \brief Find the start statistics for a device, optionally allocating an entry.
+    \param bd_addr  Address of the device.
+    \param create   Set to allocate an entry if the device has none, replacing the
+                    entry with the fewest starts if the table is full.
+    \return Pointer to the statistics, or NULL if not found and create is FALSE.
+*/
+static a2dpStartStats *appA2dpFindStartStats(const bdaddr *bd_addr, bool create)
+{
+    avTaskData *theAv = appGetAv();
+    a2dpStartStats *oldest = NULL;
+    int index;
+
+    for (index = 0; index < A2DP_START_STATS_DEVICES; index++)
+    {
+        a2dpStartStats *stats = &theAv->a2dp_start_stats[index];
+
+        if (BdaddrIsSame(&stats->bd_addr, bd_addr))
+            return stats;
+
+        if (!oldest || (stats->phase[A2DP_START_PHASE_START_IND].count <
+                        oldest->phase[A2DP_START_PHASE_START_IND].count))
+            oldest = stats;
+    }
+
+    if (!create)
+        return NULL;
+
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->bd_addr = *bd_addr;
+    return oldest;
+}
+
+/*! \brief Complete the start trace, folding it into the device's statistics. */
+static void appA2dpStartTraceComplete(avInstanceTaskData *theInst)
+{
+    a2dpStartTrace *trace = &theInst->a2dp.start_trace;
+    a2dpStartStats *stats;
+    int phase;
+
+    if (!trace->active)
+        return;
+
+    trace->active = FALSE;
+
+    DEBUG_LOGF("appA2dpStartTraceComplete(%p) stream %d, sync_ind %u, peer_req %u, sync_res %u, rsp %u, cfm %u, kymera %u",
+               (void *)theInst, trace->stream_id,
+               trace->phase_ms[A2DP_START_PHASE_SYNC_IND],
+               trace->phase_ms[A2DP_START_PHASE_PEER_START_REQ],
+               trace->phase_ms[A2DP_START_PHASE_SYNC_RES],
+               trace->phase_ms[A2DP_START_PHASE_START_RSP],
+               trace->phase_ms[A2DP_START_PHASE_START_CFM],
+               trace->phase_ms[A2DP_START_PHASE_KYMERA_CFM]);
+
+    stats = appA2dpFindStartStats(&theInst->bd_addr, TRUE);
+    for (phase = 0; phase < A2DP_START_PHASE_COUNT; phase++)
+    {
+        a2dpStartPhaseStats *phase_stats = &stats->phase[phase];
+        const uint16 phase_ms = trace->phase_ms[phase];
+        int bucket;
+
+        /* Phases not reached are not included */
+        if (!phase_ms || (phase_stats->count == 0xFFFF))
+            continue;
+
+        if (!phase_stats->count || (phase_ms < phase_stats->min_ms))
+            phase_stats->min_ms = phase_ms;
+        if (phase_ms > phase_stats->max_ms)
+            phase_stats->max_ms = phase_ms;
+        phase_stats->total_ms += phase_ms;
+        phase_stats->count++;
+
+        for (bucket = 0; bucket < A2DP_START_HISTOGRAM_BUCKETS - 1; bucket++)
+            if (phase_ms < a2dp_start_histogram_limits[bucket])
+                break;
+        if (phase_stats->histogram[bucket] < 0xFF)
+            phase_stats->histogram[bucket]++;
+    }
+}
+
+/*! \brief Start tracing a remotely initiated media start. */
+static void appA2dpStartTraceBegin(avInstanceTaskData *theInst, uint8 stream_id)
+{
+    a2dpStartTrace *trace = &theInst->a2dp.start_trace;
+
+    /* Fold any previous start that never fully completed */
+    appA2dpStartTraceComplete(theInst);
+
+    memset(trace, 0, sizeof(*trace));
+    trace->start_ms = VmGetClock();
+    trace->stream_id = stream_id;
+    trace->active = TRUE;
+
+    /* Zero means 'not reached', so the start indication itself is recorded as 1ms */
+    trace->phase_ms[A2DP_START_PHASE_START_IND] = 1;
+}
+
+/*! \brief Record the time a phase of the traced media start was reached.
+
+    The trace completes when both the A2DP library and kymera have confirmed
+    the start.
+
+    \param theInst  Instance being traced, may be NULL.
+    \param phase    The phase reached.
+*/
+static void appA2dpStartTraceMark(avInstanceTaskData *theInst, a2dpStartPhase phase)
+{
+    a2dpStartTrace *trace;
+
+    if (!theInst)
+        return;
+
+    trace = &theInst->a2dp.start_trace;
+    if (trace->active && !trace->phase_ms[phase])
+    {
+        uint32 elapsed = VmGetClock() - trace->start_ms;
+        trace->phase_ms[phase] = (elapsed > 0xFFFF) ? 0xFFFF : (elapsed ? (uint16)elapsed : 1);
+
+        if (trace->phase_ms[A2DP_START_PHASE_START_CFM] && trace->phase_ms[A2DP_START_PHASE_KYMERA_CFM])
+            appA2dpStartTraceComplete(theInst);
+    }
+}
+
+/*! \brief Get the A2DP media start statistics for a device.
+    \param bd_addr  Address of the device.
+    \param stats    Set to the device's statistics.
+    \return TRUE if statistics exist for the device.
+*/
+bool appA2dpGetStartStats(const bdaddr *bd_addr, a2dpStartStats *stats)
+{
+    const a2dpStartStats *found = appA2dpFindStartStats(bd_addr, FALSE);
+    if (found)
+    {
+        *stats = *found;
+        return TRUE;
+    }
+    return FALSE;
+}
+
 /*! \brief Send a sync indication to the other instance if this instance is the
            (non-TWS) sink. This function is always called on entry to a '_SYNC'
            state, but can be called for other reasons (e.g. on codec reconfigure). */
@@ -199,7 +476,7 @@ static void appA2dpInstSyncSendInd(avInstanceTaskData *theInst, a2dpInstSyncReas
     uint8 sync_id = theInst->a2dp.sync_counter++;
     if (appA2dpIsSinkNonTwsCodec(theInst))
     {
-        avInstanceTaskData *theOtherInst = appAvInstanceFindA2dpState(theInst, 0, 0);
+        avInstanceTaskData *theOtherInst = appAvInstanceFindPeer(theInst);
         if (theOtherInst)
         {
             DEBUG_LOGF("appA2dpInstSyncSendInd(%p) reason=%d", theInst, reason);
@@ -535,6 +812,147 @@ static void appA2dpExitDisconnectingMedia(avInstanceTaskData *theInst)
     appA2dpClearTransitionLockBit(theInst);
 }
 
+/*! \brief Match the peer forwarding media channel to a handset
+
+    The source instance forwarding to the peer keeps the SEID of the handset
+    it was opened for. If the handset being switched to uses a different
+    codec, close the forwarding media channel, it is reopened with the
+    matching SEID by the sync indication sent when the handset resumes.
+*/
+static void appA2dpSwitchPeerSeid(avInstanceTaskData *theInst)
+{
+    avInstanceTaskData *thePeerInst = appAvInstanceFindPeer(theInst);
+    uint8 source_seid = appA2dpConvertSeidFromSinkToSource(theInst->a2dp.current_seid);
+
+    if (thePeerInst &&
+        ((appA2dpGetState(thePeerInst) & A2DP_STATE_MASK_CONNECTED_MEDIA) == A2DP_STATE_MASK_CONNECTED_MEDIA) &&
+        !appA2dpIsSeidTwsSink(thePeerInst->a2dp.current_seid) &&
+        (thePeerInst->a2dp.current_seid != source_seid))
+    {
+        DEBUG_LOGF("appA2dpSwitchPeerSeid(%p), peer %p seid %u, handset seid %u",
+                   (void *)theInst, (void *)thePeerInst, thePeerInst->a2dp.current_seid, source_seid);
+        MessageCancelFirst(&thePeerInst->av_task, AV_INTERNAL_A2DP_DISCONNECT_MEDIA_REQ);
+        MessageSendConditionally(&thePeerInst->av_task, AV_INTERNAL_A2DP_DISCONNECT_MEDIA_REQ,
+                                 NULL, &appA2dpGetLock(thePeerInst));
+    }
+}
+
+/*! \brief Switch audio to another handset
+
+    Called when a handset stops streaming. Another handset that is streaming,
+    but muted, is resumed so its audio plays without reconnecting. Handsets
+    that were switched away from and are no longer streaming can play again
+    when they next start.
+*/
+static void appA2dpHandsetStreamingStopped(avInstanceTaskData *theInst)
+{
+    avTaskData *theAv = appGetAv();
+
+    for (int instance = 0; instance < AV_MAX_NUM_INSTANCES; instance++)
+    {
+        avInstanceTaskData *theOtherInst = theAv->av_inst[instance];
+        if (theOtherInst && (theOtherInst != theInst) && appA2dpIsSinkNonTwsCodec(theOtherInst))
+        {
+            if (appA2dpGetState(theOtherInst) == A2DP_STATE_CONNECTED_MEDIA_STREAMING_MUTED)
+            {
+                DEBUG_LOGF("appA2dpHandsetStreamingStopped(%p), switching to %p", (void *)theInst, (void *)theOtherInst);
+                appA2dpSwitchPeerSeid(theOtherInst);
+                MAKE_AV_MESSAGE(AV_INTERNAL_A2DP_RESUME_MEDIA_REQ);
+                message->reason = AV_SUSPEND_REASON_SWITCH;
+                MessageSendConditionally(&theOtherInst->av_task, AV_INTERNAL_A2DP_RESUME_MEDIA_REQ,
+                                         message, &appA2dpGetLock(theOtherInst));
+            }
+            else
+                theOtherInst->a2dp.suspend_state &= ~AV_SUSPEND_REASON_SWITCH;
+        }
+    }
+}
+
+/*! \brief Check if the handset is streaming with playback paused or stopped */
+static bool appA2dpSilenceIsPlaybackStopped(avInstanceTaskData *theInst)
+{
+    return (theInst->a2dp.play_status == avrcp_play_status_paused) ||
+           (theInst->a2dp.play_status == avrcp_play_status_stopped);
+}
+
+/*! \brief Start timer to suspend a handset stream that is silent
+
+    Only handset streams are suspended, the peer follows the handset through
+    the existing suspend relay.
+*/
+static void appA2dpSilenceStartTimer(avInstanceTaskData *theInst)
+{
+    MessageCancelFirst(&theInst->av_task, AV_INTERNAL_A2DP_SILENCE_IND);
+    if (appConfigA2dpSilenceSuspendMs() && appA2dpIsSinkNonTwsCodec(theInst) &&
+        appA2dpSilenceIsPlaybackStopped(theInst))
+    {
+        MessageSendLater(&theInst->av_task, AV_INTERNAL_A2DP_SILENCE_IND, NULL,
+                         appConfigA2dpSilenceSuspendMs());
+    }
+}
+
+/*! \brief Clear the silence suspend reason, accounting for time spent suspended */
+static void appA2dpSilenceClear(avInstanceTaskData *theInst)
+{
+    if (theInst->a2dp.suspend_state & AV_SUSPEND_REASON_SILENCE)
+    {
+        avTaskData *theAv = appGetAv();
+        theAv->silence_suspended_ms += VmGetClock() - theInst->a2dp.silence_start_ms;
+        theInst->a2dp.suspend_state &= ~AV_SUSPEND_REASON_SILENCE;
+    }
+}
+
+/*! \brief Handle play status reported by the handset
+
+    Called when the handset reports a change of play status over AVRCP.  If the
+    handset pauses or stops playback but keeps the media channel streaming, the
+    stream is suspended after appConfigA2dpSilenceSuspendMs().  When playback
+    resumes the stream is restarted.
+*/
+void appA2dpSilenceHandlePlayStatus(avInstanceTaskData *theInst, avrcp_play_status play_status)
+{
+    DEBUG_LOGF("appA2dpSilenceHandlePlayStatus(%p) play_status(%u) suspend_state(0x%x)",
+               (void *)theInst, play_status, theInst->a2dp.suspend_state);
+
+    theInst->a2dp.play_status = play_status;
+
+    if (appA2dpGetState(theInst) == A2DP_STATE_CONNECTED_MEDIA_STREAMING)
+        appA2dpSilenceStartTimer(theInst);
+    else if ((play_status == avrcp_play_status_playing) &&
+             (theInst->a2dp.suspend_state & AV_SUSPEND_REASON_SILENCE))
+    {
+        appA2dpSilenceClear(theInst);
+
+        /* Restart the stream, if there are no other suspend reasons active */
+        MAKE_AV_MESSAGE(AV_INTERNAL_A2DP_RESUME_MEDIA_REQ);
+        message->reason = AV_SUSPEND_REASON_SILENCE;
+        MessageSendConditionally(&theInst->av_task, AV_INTERNAL_A2DP_RESUME_MEDIA_REQ,
+                                 message, &appA2dpGetLock(theInst));
+    }
+}
+
+/*! \brief Handle timeout of handset streaming silence
+
+    Suspend the stream, this stops the audio chain, suspends forwarding to the
+    peer and allows the link to leave the streaming power table.
+*/
+static void appA2dpHandleInternalA2dpSilenceIndication(avInstanceTaskData *theInst)
+{
+    DEBUG_LOGF("appA2dpHandleInternalA2dpSilenceIndication(%p) state(0x%x)",
+               (void *)theInst, appA2dpGetState(theInst));
+
+    if ((appA2dpGetState(theInst) == A2DP_STATE_CONNECTED_MEDIA_STREAMING) &&
+        appA2dpSilenceIsPlaybackStopped(theInst))
+    {
+        AV_INTERNAL_A2DP_SUSPEND_MEDIA_REQ_T req;
+        req.reason = AV_SUSPEND_REASON_SILENCE;
+
+        appGetAv()->silence_suspends += 1;
+        theInst->a2dp.silence_start_ms = VmGetClock();
+        appA2dpHandleInternalA2dpSuspendRequest(theInst, &req);
+    }
+}
+
 /*! \brief Enter A2DP_STATE_CONNECTED_MEDIA_STREAMING
 
     The A2DP state machine has entered 'connected media streaming' state, this means
@@ -558,6 +976,9 @@ static void appA2dpEnterConnectedMediaStreaming(avInstanceTaskData *theInst)
 
     appA2dpInstSyncSendInd(theInst, A2DP_INST_SYNC_REASON_MEDIA_STREAMING, FALSE);
 
+    /* Suspend if the handset is streaming with playback stopped */
+    appA2dpSilenceStartTimer(theInst);
+
     /* Tell clients we are streaming */
     appTaskListMessageSendId(theInst->av_status_client_list, AV_STREAMING_ACTIVE_IND);
 }
@@ -580,6 +1001,16 @@ static void appA2dpExitConnectedMediaStreaming(avInstanceTaskData *theInst)
     /* Allow role switch on exit streaming */
     appLinkPolicyAllowRoleSwitch(&theInst->bd_addr);
 
+    MessageCancelFirst(&theInst->av_task, AV_INTERNAL_A2DP_SILENCE_IND);
+
+    /* Play audio from another handset if there is one streaming, and record
+       if the stream needed robust forwarding */
+    if (appA2dpIsSinkNonTwsCodec(theInst))
+    {
+        appA2dpHandsetStreamingStopped(theInst);
+        appA2dpUpdateCongestionHistory(theInst);
+    }
+
     /* Tell clients we are not streaming */
     appTaskListMessageSendId(theInst->av_status_client_list, AV_STREAMING_INACTIVE_IND);
 }
@@ -603,6 +1034,8 @@ static void appA2dpEnterConnectedMediaStreamingMuted(avInstanceTaskData *theInst
 static void appA2dpExitConnectedMediaStreamingMuted(avInstanceTaskData *theInst)
 {
     DEBUG_LOGF("appA2dpExitConnectedMediaStreamingMuted(%p)", (void *)theInst);
+
+    theInst->a2dp.switch_pending = FALSE;
 }
 
 /*! \brief Enter A2DP_STATE_CONNECTED_MEDIA_SUSPENDING_LOCAL
@@ -722,6 +1155,8 @@ static void appA2dpExitConnectedMediaStartingLocalSync(avInstanceTaskData *theIn
     this means the remote device has requested to start streaming.
     
     We sync the slave and get a message back that triggers the A2dpStartResponse().
+    If #appConfigA2dpStartResponseFirst is set, a non-TWS sink responds on entry
+    instead and the slave joins once its own media start completes.
     
     The operation lock is set to that any other operations are blocked until we
     have exited this state.
@@ -736,6 +1171,17 @@ static void appA2dpEnterConnectedMediaStartingRemoteSync(avInstanceTaskData *the
     /* Set operation lock */
     appA2dpSetTransitionLockBit(theInst);
 
+    /* Accept the start now rather than after the other instance has synced,
+       discarding media until the audio chain connects to it */
+    theInst->a2dp.start_rsp_sent = FALSE;
+    if (appConfigA2dpStartResponseFirst() && appA2dpIsSinkNonTwsCodec(theInst))
+    {
+        StreamConnectDispose(StreamSourceFromSink(theInst->a2dp.media_sink));
+        PanicFalse(A2dpMediaStartResponse(theInst->a2dp.device_id, theInst->a2dp.stream_id, TRUE));
+        appA2dpStartTraceMark(theInst, A2DP_START_PHASE_START_RSP);
+        theInst->a2dp.start_rsp_sent = TRUE;
+    }
+
     appA2dpInstSyncSendInd(theInst, A2DP_INST_SYNC_REASON_MEDIA_STARTING, TRUE);
 }
 
@@ -1133,8 +1579,15 @@ static void appA2dpHandleInternalA2dpConnectMediaRequest(avInstanceTaskData *the
                 return;
             }
 
-            /* Store requested SEID */
+            /* Store requested SEID, use the SEID last accepted by a handset
+               if none was requested */
             theInst->a2dp.current_seid = req->seid;
+            theInst->a2dp.seid_cached = FALSE;
+            if ((req->seid == AV_SEID_INVALID) && appDeviceIsHandset(&theInst->bd_addr))
+            {
+                theInst->a2dp.current_seid = appA2dpGetCachedSeid(theInst);
+                theInst->a2dp.seid_cached = (theInst->a2dp.current_seid != AV_SEID_INVALID);
+            }
 
             /* Move to 'local connecting media' state */
             appA2dpSetState(theInst, A2DP_STATE_CONNECTING_MEDIA_LOCAL);
@@ -1288,6 +1741,14 @@ static void appA2dpHandleInternalA2dpResumeRequest(avInstanceTaskData *theInst,
     /* Clear suspend reason */
     theInst->a2dp.suspend_state &= ~req->reason;
 
+    /* Audio switches to this handset once it's unmuted, which may wait for
+       other suspend reasons to clear */
+    if ((req->reason == AV_SUSPEND_REASON_SWITCH) &&
+        (appA2dpGetState(theInst) == A2DP_STATE_CONNECTED_MEDIA_STREAMING_MUTED))
+    {
+        theInst->a2dp.switch_pending = TRUE;
+    }
+
     /* Immediately return if suspend is not cleared. */
     if (theInst->a2dp.suspend_state)
     {
@@ -1309,6 +1770,8 @@ static void appA2dpHandleInternalA2dpResumeRequest(avInstanceTaskData *theInst,
 
         case A2DP_STATE_CONNECTED_MEDIA_STREAMING_MUTED:
         {
+            if (theInst->a2dp.switch_pending)
+                appGetAv()->handset_switches += 1;
             appA2dpSetState(theInst, A2DP_STATE_CONNECTED_MEDIA_STREAMING);
         }
         return;
@@ -1776,9 +2239,24 @@ static void appA2dpHandleA2dpMediaOpenConfirm(avInstanceTaskData *theInst,
                 theInst->a2dp.stream_id = cfm->stream_id;
                 theInst->a2dp.media_sink = A2dpMediaGetSink(theInst->a2dp.device_id,
                                                             theInst->a2dp.stream_id);
+                if (appA2dpIsSeidNonTwsSink(cfm->seid))
+                    appA2dpSetCachedSeid(theInst, cfm->seid);
 
                 appA2dpSetState(theInst, next_state);
             }
+            else if (theInst->a2dp.seid_cached)
+            {
+                DEBUG_LOGF("appA2dpHandleA2dpMediaOpenConfirm(%p), cached seid %u rejected",
+                           (void *)theInst, theInst->a2dp.current_seid);
+
+                /* Handset rejected the cached SEID, clear the cache and fall
+                   back to full negotiation, the operation lock is still held */
+                appGetAv()->seid_cache_rejects += 1;
+                appA2dpSetCachedSeid(theInst, AV_SEID_INVALID);
+                theInst->a2dp.seid_cached = FALSE;
+                theInst->a2dp.current_seid = AV_SEID_INVALID;
+                A2dpMediaOpenRequest(theInst->a2dp.device_id, 0, NULL);
+            }
             else
             {
                 /* Move to 'connected signalling' state */
@@ -1802,6 +2280,8 @@ static void appA2dpHandleA2dpMediaOpenConfirm(avInstanceTaskData *theInst,
                 theInst->a2dp.stream_id = cfm->stream_id;
                 theInst->a2dp.media_sink = A2dpMediaGetSink(theInst->a2dp.device_id,
                                                             theInst->a2dp.stream_id);
+                if (appA2dpIsSeidNonTwsSink(cfm->seid))
+                    appA2dpSetCachedSeid(theInst, cfm->seid);
 
                 /* Remote initiate media channel defaults to suspended */
                 appA2dpSetState(theInst, A2DP_STATE_CONNECTED_MEDIA_SUSPENDED);
@@ -1826,12 +2306,6 @@ static void appA2dpHandleA2dpMediaOpenConfirm(avInstanceTaskData *theInst,
             return;
     }
 }
-#define A2DP_TIME_MEDIA_START
-
-#ifdef A2DP_TIME_MEDIA_START
-uint32 start_ind_time = 0;
-#endif
-
 /*! \brief Handle A2DP streaming start indication
 
     A2DP Library has indicated streaming of the media channel, accept the
@@ -1843,8 +2317,10 @@ static void appA2dpHandleA2dpMediaStartIndication(avInstanceTaskData *theInst,
 {
     assert(theInst->a2dp.device_id == ind->device_id);
 
-    /* Record the fact that remote device has request start */
+    /* Record the fact that remote device has request start, audio is no
+       longer silent */
     theInst->a2dp.suspend_state &= ~AV_SUSPEND_REASON_REMOTE;
+    appA2dpSilenceClear(theInst);
 
     DEBUG_LOGF("appA2dpHandleA2dpMediaStartIndication(%p) state(0x%x) suspend_state(0x%x)",
                 (void *)theInst, appA2dpGetState(theInst), theInst->a2dp.suspend_state);
@@ -1863,10 +2339,8 @@ static void appA2dpHandleA2dpMediaStartIndication(avInstanceTaskData *theInst,
 
                 /* Move to 'connected media starting remote' state to wait for
                    the other instance to start streaming */
+                appA2dpStartTraceBegin(theInst, ind->stream_id);
                 appA2dpSetState(theInst, A2DP_STATE_CONNECTED_MEDIA_STARTING_REMOTE_SYNC);
-#ifdef A2DP_TIME_MEDIA_START
-                start_ind_time = VmGetTimerTime();
-#endif
             }
             else
             {
@@ -1943,14 +2417,14 @@ static void appA2dpHandleA2dpMediaStartConfirmation(avInstanceTaskData *theInst,
                                                     const A2DP_MEDIA_START_CFM_T *cfm)
 {
     assert(theInst->a2dp.device_id == cfm->device_id);
-#ifdef A2DP_TIME_MEDIA_START
-    uint32 start_time = VmGetTimerTime() - start_ind_time;
-    DEBUG_LOGF("appA2dpHandleA2dpMediaStartConfirmation(%p) status(%d) start_time(%d)",
-               (void *)theInst, cfm->status, start_time);
-#else
     DEBUG_LOGF("appA2dpHandleA2dpMediaStartConfirmation(%p) status(%d)",
                (void *)theInst, cfm->status);
-#endif
+
+    if (cfm->status == a2dp_success)
+        appA2dpStartTraceMark(theInst, A2DP_START_PHASE_START_CFM);
+    else
+        appA2dpStartTraceComplete(theInst);
+
     /* Handle different states */
     switch (appA2dpGetState(theInst))
     {
@@ -2328,7 +2802,8 @@ static void appA2dpHandleA2dpMediaAvSyncDelayIndication(avInstanceTaskData *theI
     DEBUG_LOGF("appA2dpHandleA2dpMediaAvSyncDelayIndication(%p) seid(%d)", (void *)theInst, ind->seid);
 
     if (appA2dpIsConnected(theInst))
-        A2dpMediaAvSyncDelayResponse(ind->device_id, ind->seid, TWS_STANDARD_LATENCY_MS*10);
+        A2dpMediaAvSyncDelayResponse(ind->device_id, ind->seid,
+                                     appKymeraA2dpLatencyMs(appA2dpSelectLatencyMode(theInst))*10);
     else
         appA2dpError(theInst, A2DP_MEDIA_AV_SYNC_DELAY_IND, ind);
 }
@@ -2438,6 +2913,9 @@ static void appA2dpHandleInternalA2dpInstSyncIndication(avInstanceTaskData *theI
         case A2DP_INST_SYNC_REASON_MEDIA_STREAMING:
         {
             PER_REASON_DEBUG(A2DP_INST_SYNC_REASON_MEDIA_STARTING/STREAMING);
+            /* Record against the sink instance if it is tracing a start */
+            if (ind->reason == A2DP_INST_SYNC_REASON_MEDIA_STARTING)
+                appA2dpStartTraceMark(appAvInstanceFindA2dpState(theInst, 0, 0), A2DP_START_PHASE_SYNC_IND);
             switch (local_state)
             {
                 case A2DP_STATE_DISCONNECTED:
@@ -2488,6 +2966,22 @@ static void appA2dpHandleInternalA2dpInstSyncIndication(avInstanceTaskData *theI
         case A2DP_INST_SYNC_REASON_MEDIA_SUSPENDED:
         {
             PER_REASON_DEBUG(A2DP_INST_SYNC_REASON_MEDIA_SUSPENDED);
+
+            /* The handset has suspended, so the AAC forwarding mode can change
+               without a gap. Close the forwarding media channel opened for the
+               old mode, it is reopened with the new SEID when the handset
+               next starts and the slave creates the matching decoder. The mode
+               is only updated once the channel is known to be open with the
+               SEID for the old mode, so source_seid stays valid otherwise. */
+            if ((ind->seid == AV_SEID_AAC_SNK) &&
+                ((local_state & A2DP_STATE_MASK_CONNECTED_MEDIA) == A2DP_STATE_MASK_CONNECTED_MEDIA) &&
+                (theInst->a2dp.current_seid == source_seid) &&
+                appAvAacForwardingUpdate())
+            {
+                msg_id = AV_INTERNAL_A2DP_DISCONNECT_MEDIA_REQ;
+                break;
+            }
+
             switch (local_state)
             {
                 case A2DP_STATE_DISCONNECTED:
@@ -2612,13 +3106,20 @@ static void appA2dpHandleInternalA2dpInstSyncResponse(avInstanceTaskData *theIns
             PanicFalse(res->reason == A2DP_INST_SYNC_REASON_MEDIA_STARTING);
             /* Start streaming request */
             PanicFalse(A2dpMediaStartRequest(theInst->a2dp.device_id, theInst->a2dp.stream_id));
+            /* Record against the sink instance if it is tracing a start */
+            appA2dpStartTraceMark(appAvInstanceFindA2dpState(theInst, 0, 0), A2DP_START_PHASE_PEER_START_REQ);
             /* The sync is complete, remain in this state waiting for the
                A2DP_MEDIA_START_CFM. */
         break;
         case A2DP_STATE_CONNECTED_MEDIA_STARTING_REMOTE_SYNC:
             PanicFalse(res->reason == A2DP_INST_SYNC_REASON_MEDIA_STARTING);
-            /* Start streaming response */
-            PanicFalse(A2dpMediaStartResponse(theInst->a2dp.device_id, theInst->a2dp.stream_id, TRUE));
+            appA2dpStartTraceMark(theInst, A2DP_START_PHASE_SYNC_RES);
+            /* Start streaming response, unless already sent on entry to this state */
+            if (!theInst->a2dp.start_rsp_sent)
+            {
+                PanicFalse(A2dpMediaStartResponse(theInst->a2dp.device_id, theInst->a2dp.stream_id, TRUE));
+                appA2dpStartTraceMark(theInst, A2DP_START_PHASE_START_RSP);
+            }
             /* The sync is complete, remain in this state waiting for the
                A2DP_MEDIA_START_CFM. */
         break;
@@ -2696,6 +3197,7 @@ static void appA2dpHandleKymeraA2dpStartConfirm(avInstanceTaskData *theInst)
 {
     DEBUG_LOGF("appA2dpHandleKymeraA2dpStartConfirm(%p)", theInst);
     appA2dpClearKymeraLockBit(theInst);
+    appA2dpStartTraceMark(theInst, A2DP_START_PHASE_KYMERA_CFM);
 }
 
 /*! \brief Initialise AV instance
@@ -2722,6 +3224,12 @@ void appA2dpInstanceInit(avInstanceTaskData *theAv, uint8 suspend_state)
     theAv->a2dp.suspend_state = suspend_state;   
     theAv->a2dp.local_initiated = FALSE;
     theAv->a2dp.disconnect_reason = AV_A2DP_DISCONNECT_NORMAL;
+    theAv->a2dp.start_rsp_sent = FALSE;
+    theAv->a2dp.seid_cached = FALSE;
+    theAv->a2dp.switch_pending = FALSE;
+    theAv->a2dp.play_status = avrcp_play_status_error;
+    theAv->a2dp.silence_start_ms = 0;
+    memset(&theAv->a2dp.start_trace, 0, sizeof(theAv->a2dp.start_trace));
 
     /* No profile instance yet */
     theAv->a2dp.device_id = INVALID_DEVICE_ID;
@@ -2817,6 +3325,10 @@ void appA2dpInstanceHandleMessage(avInstanceTaskData *theInst, MessageId id, Mes
             appA2dpHandleInternalA2dpInstSyncResponse(theInst, message);
             return;
 
+        case AV_INTERNAL_A2DP_SILENCE_IND:
+            appA2dpHandleInternalA2dpSilenceIndication(theInst);
+            return;
+
         case AV_INTERNAL_A2DP_CODEC_RECONFIG_IND:
             appA2dpHandleInternalA2dpCodecReconfigInd(theInst, message);
             return;
@@ -11,6 +11,7 @@
 #define _AV_HEADSET_A2DP_H_
 
 #include <a2dp.h>
+#include <avrcp.h>
 #include "av_headset.h"
 
 struct appDeviceAttributes;
@@ -95,9 +96,58 @@ typedef enum
     AV_SUSPEND_REASON_AV     = (1 << 2), /*!< Suspend AV due to AV activity */
     AV_SUSPEND_REASON_RELAY  = (1 << 3), /*!< Suspend AV due to master suspend request */
     AV_SUSPEND_REASON_REMOTE = (1 << 4), /*!< Suspend AV due to remote request */
-    AV_SUSPEND_REASON_SCOFWD = (1 << 5)  /*!< Suspend AV due to SCO forwarding */
+    AV_SUSPEND_REASON_SCOFWD = (1 << 5), /*!< Suspend AV due to SCO forwarding */
+    AV_SUSPEND_REASON_SWITCH = (1 << 6), /*!< Suspend AV as audio switched to another handset */
+    AV_SUSPEND_REASON_SILENCE = (1 << 7) /*!< Suspend AV as the handset is streaming silence */
 } avSuspendReason;
 
+/*! \brief Phases of a remotely initiated A2DP media start, in the order they
+           normally occur. Each phase is timed from #A2DP_START_PHASE_START_IND. */
+typedef enum
+{
+    A2DP_START_PHASE_START_IND,         /*!< A2DP_MEDIA_START_IND received */
+    A2DP_START_PHASE_SYNC_IND,          /*!< Other instance received AV_INTERNAL_A2DP_INST_SYNC_IND */
+    A2DP_START_PHASE_PEER_START_REQ,    /*!< Other instance sent A2dpMediaStartRequest() to the peer */
+    A2DP_START_PHASE_SYNC_RES,          /*!< AV_INTERNAL_A2DP_INST_SYNC_RES received */
+    A2DP_START_PHASE_START_RSP,         /*!< A2dpMediaStartResponse() sent */
+    A2DP_START_PHASE_START_CFM,         /*!< A2DP_MEDIA_START_CFM received */
+    A2DP_START_PHASE_KYMERA_CFM,        /*!< KYMERA_A2DP_START_CFM received */
+    A2DP_START_PHASE_COUNT
+} a2dpStartPhase;
+
+/*! Number of histogram buckets for each A2DP start phase */
+#define A2DP_START_HISTOGRAM_BUCKETS    (6)
+
+/*! Number of devices A2DP start statistics are kept for */
+#define A2DP_START_STATS_DEVICES        (2)
+
+/*! \brief Statistics of the time to reach an A2DP start phase */
+typedef struct
+{
+    uint16  count;                  /*!< Number of starts that reached the phase */
+    uint16  min_ms;                 /*!< Minimum time to the phase */
+    uint16  max_ms;                 /*!< Maximum time to the phase */
+    uint32  total_ms;               /*!< Total time, average is total_ms / count */
+    uint8   histogram[A2DP_START_HISTOGRAM_BUCKETS];   /*!< Saturating counts for <50, <100, <200,
+                                                            <500, <1000 and >=1000ms */
+} a2dpStartPhaseStats;
+
+/*! \brief A2DP start statistics for a device */
+typedef struct
+{
+    bdaddr              bd_addr;                        /*!< Device, zero if unused */
+    a2dpStartPhaseStats phase[A2DP_START_PHASE_COUNT];  /*!< Statistics for each phase */
+} a2dpStartStats;
+
+/*! \brief Trace of the media start in progress on an A2DP instance */
+typedef struct
+{
+    uint32  start_ms;                           /*!< VM clock when A2DP_MEDIA_START_IND was received */
+    uint16  phase_ms[A2DP_START_PHASE_COUNT];   /*!< Time to each phase, 0 if not reached yet */
+    uint8   stream_id;                          /*!< Stream being started */
+    bool    active;                             /*!< Set while a start is being traced */
+} a2dpStartTrace;
+
 typedef struct a2dpTaskData
 {
     avA2dpState     state;                 /*!< Current state of A2DP state machine */
@@ -113,6 +163,12 @@ typedef struct a2dpTaskData
     unsigned        connect_retries:3;     /*!< Number of connection retries */
     unsigned        local_initiated:1;     /*!< Flag to indicate if connection was locally initiated */
     unsigned        disconnect_reason:4;   /*!< Reason for disconnect */
+    unsigned        start_rsp_sent:1;      /*!< Media start already accepted, without waiting for sync */
+    unsigned        seid_cached:1;         /*!< Media open requested with the SEID cached for the handset */
+    unsigned        switch_pending:1;      /*!< Audio is switching to this handset once it's unmuted */
+    avrcp_play_status play_status;         /*!< Last play status reported by the handset over AVRCP */
+    uint32          silence_start_ms;      /*!< Time (VmGetClock) the stream was suspended for silence */
+    a2dpStartTrace  start_trace;           /*!< Trace of media start in progress */
 } a2dpTaskData;
 
 /*! \brief Check if SEID is for non-TWS CODEC */
@@ -224,7 +280,10 @@ extern void appA2dpSignallingConnectIndicationNew(struct avTaskData *theAv, cons
 extern void appA2dpRejectA2dpSignallingConnectIndicationNew(struct avTaskData *theAv, const A2DP_SIGNALLING_CONNECT_IND_T *ind);
 extern void appA2dpVolumeSet(struct avInstanceTaskData *theAv, uint16 volume);
 extern void appA2dpSetDefaultAttributes(struct appDeviceAttributes *attributes);
+extern void appA2dpSilenceHandlePlayStatus(struct avInstanceTaskData *theInst, avrcp_play_status play_status);
+extern bool appA2dpSetLowLatency(const bdaddr *bd_addr, bool low_latency);
 extern avA2dpState appA2dpGetState(struct avInstanceTaskData *theAv);
+extern bool appA2dpGetStartStats(const bdaddr *bd_addr, a2dpStartStats *stats);
 extern void appA2dpInstanceHandleMessage(struct avInstanceTaskData *theInst, MessageId id, Message message);
 extern uint8 appA2dpConvertSeidFromSinkToSource(uint8 seid);
 extern bool appA2dpSeidsAreCompatible(const struct avInstanceTaskData *inst1, const struct avInstanceTaskData *inst2);
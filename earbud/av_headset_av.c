@@ -40,6 +40,7 @@ Main AV task.
 #define assert(x)   PanicFalse(x)
 
 static void appAvHandleMessage(Task task, MessageId id, Message message);
+static void appAvAvrcpConnectLaterRequest(avInstanceTaskData *theInst, uint32 delay);
 
 /*! \brief Handle AV error
 
@@ -232,7 +233,27 @@ static void appAvInstanceHandleAvAvrcpConnectCfm(avInstanceTaskData *theInst, AV
 
         /* Cancel outstanding connect later request since we are now connected */
         MessageCancelAll(&theInst->av_task, AV_INTERNAL_AVRCP_CONNECT_LATER_REQ);
+
+        /* Handset accepted AVRCP straight after connecting A2DP, it no longer needs the delay */
+        if (theInst->avrcp.early_connect)
+        {
+            appDeviceSetAvrcpConnectDelayReqd(&theInst->bd_addr, FALSE);
+        }
+    }
+    else if (theInst->avrcp.early_connect)
+    {
+        /* Handset rejected AVRCP straight after connecting A2DP, remember
+           that it needs the delay. Connect again after the delay for any
+           failure. */
+        DEBUG_LOG("appAvInstanceHandleAvAvrcpConnectCfm, early connect failed, delaying");
+        if (cfm->status == avrcp_rejected)
+        {
+            appDeviceSetAvrcpConnectDelayReqd(&theInst->bd_addr, TRUE);
+        }
+        appAvAvrcpConnectLaterRequest(theInst, appConfigAvrcpConnectDelayAfterRemoteA2dpConnectMs());
     }
+
+    theInst->avrcp.early_connect = FALSE;
 }
 
 /*! \brief Handle confirmation of AVRCP disconnection */
@@ -323,6 +344,32 @@ avInstanceTaskData *appAvInstanceFindA2dpState(const avInstanceTaskData *theInst
     return NULL;
 }
 
+/*! \brief Find the AV instance of the peer earbud
+
+    \param theInst The instance to exclude from the search.
+
+    \return Pointer to the first other instance that is not a handset, NULL
+            if none was found.
+*/
+avInstanceTaskData *appAvInstanceFindPeer(const avInstanceTaskData *theInst)
+{
+    avTaskData *theAv = appGetAv();
+    int instance;
+
+    for (instance = 0; instance < AV_MAX_NUM_INSTANCES; instance++)
+    {
+        avInstanceTaskData *theOtherInst = theAv->av_inst[instance];
+        if (theOtherInst != NULL && theInst != theOtherInst &&
+            !appDeviceIsHandset(&theOtherInst->bd_addr))
+        {
+            return theOtherInst;
+        }
+    }
+
+    /* No match found */
+    return NULL;
+}
+
 /*! \brief Find AV instance for AVRCP passthrough
 
     This function finds the AV instance to send a AVRCP passthrough command.
@@ -338,6 +385,15 @@ avInstanceTaskData *appAvInstanceFindAvrcpForPassthrough(void)
     avTaskData *theAv = appGetAv();
     int instance;
 
+    /* Prefer the handset whose audio is playing, if there is more than one */
+    for (instance = 0; instance < AV_MAX_NUM_INSTANCES; instance++)
+    {
+        avInstanceTaskData *theInst = theAv->av_inst[instance];
+        if (theInst && appAvrcpIsConnected(theInst) && appA2dpIsSinkNonTwsCodec(theInst) &&
+            (appA2dpGetState(theInst) == A2DP_STATE_CONNECTED_MEDIA_STREAMING))
+            return theInst;
+    }
+
     for (instance = 0; instance < AV_MAX_NUM_INSTANCES; instance++)
     {
         avInstanceTaskData *theInst = theAv->av_inst[instance];
@@ -467,6 +523,11 @@ avInstanceTaskData *appAvInstanceFindFromBdAddr(const bdaddr *bd_addr)
 bool appAvInstanceShouldConnectMediaChannel(const avInstanceTaskData *theInst, uint8 *seid)
 {
     *seid = AV_SEID_INVALID;
+
+    /* Only the peer forwards audio from another instance */
+    if (appDeviceIsHandset(&theInst->bd_addr))
+        return FALSE;
+
     avInstanceTaskData *theOtherInst = appAvInstanceFindA2dpState(theInst,
                                                 A2DP_STATE_MASK_CONNECTED_MEDIA,
                                                 A2DP_STATE_CONNECTED_MEDIA);
@@ -511,8 +572,21 @@ void appAvInstanceA2dpConnected(avInstanceTaskData *theInst)
     }
     else if (appAvrcpIsDisconnected(theInst))
     {
-        DEBUG_LOG("appAvInstanceA2dpConnected, remotely initiated");
-        appAvAvrcpConnectLaterRequest(theInst, appConfigAvrcpConnectDelayAfterRemoteA2dpConnectMs());
+        /* Connect AVRCP now unless handset has been seen to need the delay,
+           try without the delay again after a number of delayed connects */
+        if (appDeviceIsHandset(&theInst->bd_addr) &&
+            (!appDeviceIsAvrcpConnectDelayReqd(&theInst->bd_addr) ||
+             (appDeviceAvrcpConnectDelayed(&theInst->bd_addr) > appConfigAvrcpConnectDelayRetryCount())))
+        {
+            DEBUG_LOG("appAvInstanceA2dpConnected, remotely initiated, connecting AVRCP");
+            theInst->avrcp.early_connect = TRUE;
+            appAvAvrcpConnectRequest(&theInst->av_task, &theInst->bd_addr);
+        }
+        else
+        {
+            DEBUG_LOG("appAvInstanceA2dpConnected, remotely initiated");
+            appAvAvrcpConnectLaterRequest(theInst, appConfigAvrcpConnectDelayAfterRemoteA2dpConnectMs());
+        }
     }
     /* Tell clients we have connected */
     MAKE_AV_MESSAGE(AV_A2DP_CONNECTED_IND);
@@ -757,6 +831,47 @@ void appAvInstanceDestroy(avInstanceTaskData *theInst)
     }
 }
 
+/*! \brief Update the AAC forwarding mode from the peer link quality
+
+    Stereo AAC passthrough is bit-exact but needs more airtime than
+    transcoding one channel to SBC mono, so passthrough is only used while
+    the peer link RSSI is good. Hysteresis stops the mode toggling on a
+    link at the threshold.
+
+    The forwarding codec is bound to the SEID of the peer media channel, so
+    the caller must only update the mode at a point where the peer media
+    channel can be reopened, such as the handset suspending.
+
+    \return TRUE if the mode changed.
+*/
+bool appAvAacForwardingUpdate(void)
+{
+    avTaskData *theAv = appGetAv();
+    conManagerLinkStats stats;
+    bdaddr peer_addr;
+    uint16 supervision_timeouts;
+    bool passthrough = theAv->aac_passthrough;
+
+    if (!appConfigAACStereoForwarding() ||
+        !appDeviceGetPeerBdAddr(&peer_addr) ||
+        !appConManagerGetLinkStats(&peer_addr, &stats, &supervision_timeouts) ||
+        !stats.rssi_samples)
+        return FALSE;
+
+    if (stats.rssi_last < appConfigAacForwardingSwitchRssi())
+        passthrough = FALSE;
+    else if (stats.rssi_last >= appConfigAacForwardingSwitchRssi() + appConfigAacForwardingSwitchHysteresis())
+        passthrough = TRUE;
+
+    if (passthrough == theAv->aac_passthrough)
+        return FALSE;
+
+    DEBUG_LOGF("appAvAacForwardingUpdate, passthrough %u, rssi %d", passthrough, stats.rssi_last);
+    theAv->aac_passthrough = passthrough;
+    theAv->aac_forwarding_switches += 1;
+    return TRUE;
+}
+
 /*! \brief Return AV instance for A2DP sink
 
     This function walks through the AV instance table looking for the
@@ -1031,6 +1146,19 @@ void appAvInit(void)
         theAv->av_inst[instance] = NULL;
     }
 
+    /* Clear A2DP start statistics */
+    memset(theAv->a2dp_start_stats, 0, sizeof(theAv->a2dp_start_stats));
+    theAv->volume_avrcp_msgs = 0;
+    theAv->seid_cache_hits = 0;
+    theAv->seid_cache_misses = 0;
+    theAv->seid_cache_rejects = 0;
+    theAv->aac_passthrough = appConfigAACStereoForwarding();
+    theAv->aac_forwarding_switches = 0;
+    memset(&theAv->avrcp_passthrough_stats, 0, sizeof(theAv->avrcp_passthrough_stats));
+    theAv->handset_switches = 0;
+    theAv->silence_suspends = 0;
+    theAv->silence_suspended_ms = 0;
+
     /* Initialise state */
     theAv->suspend_state = 0;
     theAv->state = AV_STATE_NULL;
@@ -1494,6 +1622,46 @@ void appAvStreamingSuspend(avSuspendReason reason)
     }
 }
 
+/*! \brief Switch audio to the other handset
+
+    If one handset is streaming and another handset is also streaming, but
+    muted, suspend the playing handset. Audio switches to the other handset
+    when the playing handset leaves the streaming state, see
+    appA2dpHandsetStreamingStopped(). Both media channels stay open, so the
+    switch doesn't need a reconnection.
+
+    \return TRUE if a switch was requested.
+*/
+bool appAvSwitchHandset(void)
+{
+    avTaskData *theAv = appGetAv();
+    avInstanceTaskData *theActiveInst = NULL;
+    avInstanceTaskData *theMutedInst = NULL;
+    int instance;
+
+    for (instance = 0; instance < AV_MAX_NUM_INSTANCES; instance++)
+    {
+        avInstanceTaskData *theInst = theAv->av_inst[instance];
+        if (theInst && appA2dpIsSinkNonTwsCodec(theInst))
+        {
+            if (appA2dpGetState(theInst) == A2DP_STATE_CONNECTED_MEDIA_STREAMING)
+                theActiveInst = theInst;
+            else if (appA2dpGetState(theInst) == A2DP_STATE_CONNECTED_MEDIA_STREAMING_MUTED)
+                theMutedInst = theInst;
+        }
+    }
+
+    DEBUG_LOGF("appAvSwitchHandset, active %p, muted %p", theActiveInst, theMutedInst);
+    if (!theActiveInst || !theMutedInst)
+        return FALSE;
+
+    MAKE_AV_MESSAGE(AV_INTERNAL_A2DP_SUSPEND_MEDIA_REQ);
+    message->reason = AV_SUSPEND_REASON_SWITCH;
+    MessageSendConditionally(&theActiveInst->av_task, AV_INTERNAL_A2DP_SUSPEND_MEDIA_REQ,
+                             message, &appA2dpGetLock(theActiveInst));
+    return TRUE;
+}
+
 /*! \brief Resume AV link
 
     This function is called whenever a module in the headset has cleared it's
@@ -1646,6 +1814,10 @@ void appAvHandleMessage(Task task, MessageId id, Message message)
             appAvVolumeAttributeStore(theAv);
             return;
 
+        case AV_INTERNAL_VOLUME_NOTIFY:
+            appAvVolumeHandleNotify(theAv);
+            return;
+
         case AV_AVRCP_CONNECT_IND:
             appAvHandleAvAvrcpConnectIndication(theAv, (AV_AVRCP_CONNECT_IND_T *)message);
             return;
@@ -38,8 +38,15 @@
 
 /*! Maximum number of AV connections for TWS */
 #define AV_MAX_NUM_TWS (1)
-/*! Maximum number of AV connections for audio Sinks */
+/*! Maximum number of AV connections for audio Sinks, two handsets can be
+    connected with their media channels open to switch audio between them.
+    This is disabled by default, define INCLUDE_AV_DUAL_HANDSET in the project
+    to enable it. */
+#ifdef INCLUDE_AV_DUAL_HANDSET
+#define AV_MAX_NUM_SNK (2)
+#else
 #define AV_MAX_NUM_SNK (1)
+#endif
 
 /*! \brief Maximum number of AV connections
 
@@ -96,6 +103,7 @@ extern const sep_config_type av_aac_stereo_tws_src_sep;
 
 extern void appAvUpdateSbcMonoTwsCapabilities(uint8 *caps, uint32_t sample_rate);
 extern void appAvUpdateAptxMonoTwsCapabilities(uint8 *caps, uint32_t sample_rate);
+extern uint16 appAvCapsVersion(void);
 
 
 /*! \brief AV task state machine states */
@@ -149,6 +157,17 @@ typedef struct avTaskData
     avSuspendReason suspend_state;          /*!< Bitmap of active suspend reasons */
     uint8           volume;                 /*!< The AV volume */
     avInstanceTaskData *av_inst[AV_MAX_NUM_INSTANCES];  /*!< AV Instances */
+    a2dpStartStats  a2dp_start_stats[A2DP_START_STATS_DEVICES]; /*!< A2DP media start statistics */
+    uint16          volume_avrcp_msgs;      /*!< Number of AVRCP volume commands and notifications sent */
+    uint16          seid_cache_hits;        /*!< Handset media opens requested with a cached SEID */
+    uint16          seid_cache_misses;      /*!< Handset media opens needing full negotiation */
+    uint16          seid_cache_rejects;     /*!< Cached SEIDs rejected by the handset */
+    bool            aac_passthrough;        /*!< AAC forwarded to the peer without transcoding */
+    uint16          aac_forwarding_switches; /*!< Number of AAC forwarding mode changes */
+    avrcpPassthroughStats avrcp_passthrough_stats; /*!< AVRCP passthrough command statistics */
+    uint16          handset_switches;       /*!< Number of times audio switched between handsets */
+    uint16          silence_suspends;       /*!< Number of streams suspended as the handset was streaming silence */
+    uint32          silence_suspended_ms;   /*!< Total time streams were suspended as the handset was streaming silence */
 
     TaskList        *avrcp_client_list;     /*!< List of tasks registered via \ref appAvAvrcpClientRegister */
     TaskList        *av_status_client_list; /*!< List of tasks registered via \ref appAvStatusClientRegister.
@@ -357,6 +376,8 @@ enum av_headset_internal_messages
     AV_INTERNAL_A2DP_INST_SYNC_RES,     /*!< The instance's reponse to the sync indication. */
     AV_INTERNAL_A2DP_CODEC_RECONFIG_IND,/*!< Indication the instance's codec was reconfigured, the other instance may
                                              also need to reconfigure */
+    AV_INTERNAL_A2DP_SILENCE_IND,       /*!< Indication the handset has streamed with playback paused or stopped for
+                                             appConfigA2dpSilenceSuspendMs() */
     AV_INTERNAL_A2DP_TOP,
 
     AV_INTERNAL_AVRCP_BASE,
@@ -375,6 +396,7 @@ enum av_headset_internal_messages
     AV_INTERNAL_AVRCP_TOP,
 
     AV_INTERNAL_VOLUME_STORE_REQ,
+    AV_INTERNAL_VOLUME_NOTIFY,                /*!< Send volume changes merged since the last AVRCP volume update */
 };
 
 /*! Internal indication of signalling channel connection */
@@ -500,7 +522,9 @@ typedef struct
     uint8 payload[1];           /*!< Start of command payload. Message is variable length */
 } AV_INTERNAL_AVRCP_VENDOR_PASSTHROUGH_REQ_T;
 
-/*! Internal message to initiate a remote control request, possibly repeating. */
+/*! Remote control request, possibly repeating. Used as the payload of
+    AV_INTERNAL_AVRCP_REMOTE_REPEAT_REQ, AV_INTERNAL_AVRCP_REMOTE_REQ has no
+    payload and sends the command at the head of the instance's passthrough queue. */
 typedef struct
 {
     avc_operation_id op_id; /*!< Operation ID */
@@ -510,8 +534,7 @@ typedef struct
 } AV_INTERNAL_AVRCP_REMOTE_REQ_T;
 
 /*! Internal message to trigger a remote control request repeatedly. 
-    Same structure as AV_INTERNAL_AVRCP_REMOTE_REQ_T, which is for the first
-    request. */
+    Same structure as AV_INTERNAL_AVRCP_REMOTE_REQ_T. */
 typedef AV_INTERNAL_AVRCP_REMOTE_REQ_T AV_INTERNAL_AVRCP_REMOTE_REPEAT_REQ_T;
 
 /*! Internal message to initiate registering notifications. */
@@ -520,6 +543,9 @@ typedef struct
     avrcp_supported_events event_id;
 } AV_INTERNAL_AVRCP_NOTIFICATION_REGISTER_REQ_T;
 
+/*! \brief Check if AAC is forwarded to the peer without transcoding */
+#define appAvAacForwardingIsPassthrough() (appGetAv()->aac_passthrough)
+
 /*! \brief Get the AV volume */
 #define appAvVolumeGet() (appGetAv()->volume)
 
@@ -566,6 +592,7 @@ extern bool appAvConnectWithBdAddr(const bdaddr *bd_addr);
 extern void appAvStatusClientRegister(Task client_task);
 
 extern void appAvStreamingSuspend(avSuspendReason reason);
+extern bool appAvSwitchHandset(void);
 extern void appAvStreamingResume(avSuspendReason reason);
 
 extern void appAvVolumeHandleAvrcpDisconnect(avInstanceTaskData *theInst);
@@ -599,9 +626,11 @@ extern avInstanceTaskData *appAvInstanceCreate(const bdaddr *bd_addr);
 extern void appAvInstanceDestroy(avInstanceTaskData *theInst);
 
 extern avInstanceTaskData *appAvGetA2dpSink(avCodecType codec_type);
+extern bool appAvAacForwardingUpdate(void);
 extern avInstanceTaskData *appAvGetA2dpSource(void);
 extern avInstanceTaskData *appAvInstanceFindFromBdAddr(const bdaddr *bd_addr);
 extern avInstanceTaskData *appAvInstanceFindA2dpState(const avInstanceTaskData *theInst, uint8 mask, uint8 expected);
+extern avInstanceTaskData *appAvInstanceFindPeer(const avInstanceTaskData *theInst);
 extern avInstanceTaskData *appAvInstanceFindAvrcpForPassthrough(void);
 extern avInstanceTaskData *appAvInstanceFindAvrcpFromBdAddr(const bdaddr *bd_addr);
 extern avInstanceTaskData *appAvInstanceFindAvrcpOther(avInstanceTaskData *theInst);
@@ -629,6 +658,7 @@ bool appAvIsValidInst(avInstanceTaskData* theInst);
 
 extern bool appAvIsAvrcpConnected(avInstanceTaskData* theInst);
 extern void appAvVolumeAttributeStore(avTaskData *theAv);
+extern void appAvVolumeHandleNotify(avTaskData *theAv);
 
 #endif
 
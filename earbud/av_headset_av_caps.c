@@ -395,3 +395,34 @@ void appAvUpdateAptxMonoTwsCapabilities(uint8 *caps, uint32_t sample_rate)
             break;
     }
 }
+
+/*! \brief Get the version of the standard sink endpoint capabilities
+
+    The version is a checksum of the standard (handset) sink endpoint
+    definitions, so any change to the capability tables above changes it.
+    Used to invalidate SEIDs cached against a handset under different
+    capabilities.
+
+    \return Version of the capability tables
+ */
+uint16 appAvCapsVersion(void)
+{
+    static const sep_config_type *const handset_seps[] =
+    {
+        &av_sbc_snk_sep, &av_aac_snk_sep, &av_aptx_snk_sep
+    };
+    uint16 version = 0;
+    unsigned sep, i;
+
+    for (sep = 0; sep < ARRAY_DIM(handset_seps); sep++)
+    {
+        const sep_config_type *sep_config = handset_seps[sep];
+
+        version = (uint16)((version << 1) | (version >> 15)) ^ sep_config->seid;
+        for (i = 0; i < sep_config->size_caps; i++)
+            version = (uint16)((version << 1) | (version >> 15)) ^ sep_config->caps[i];
+    }
+
+    /* Zero is reserved for attributes that have never cached a SEID */
+    return version ? version : 1;
+}
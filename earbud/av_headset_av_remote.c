@@ -28,6 +28,9 @@
 
 void appAvInstanceHandleAvAvrcpPlayStatusChangedInd(avInstanceTaskData *theOtherInst, AV_AVRCP_PLAY_STATUS_CHANGED_IND_T *ind)
 {
+    /* Suspend streaming from the handset while playback is stopped */
+    appA2dpSilenceHandlePlayStatus(theOtherInst, ind->play_status);
+
     /* Look in table to find connected instance */
     for (int instance = 0; instance < AV_MAX_NUM_INSTANCES; instance++)
     {
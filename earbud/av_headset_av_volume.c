@@ -42,12 +42,79 @@ static void appAvApplyVolume(uint8 volume)
         appAvSetLocalVolume(volume);
         theAv->volume = volume;
 
-        /* Cancel any pending messages */
-        MessageCancelFirst(&theAv->task, AV_INTERNAL_VOLUME_STORE_REQ);
+        /* Store configuration after 5 seconds, the volume at that time is
+           stored so there is no need to restart the timer on every step */
+        if (!MessagePendingFirst(&theAv->task, AV_INTERNAL_VOLUME_STORE_REQ, NULL))
+            MessageSendLater(&theAv->task, AV_INTERNAL_VOLUME_STORE_REQ, 0, D_SEC(5));
+    }
+}
+
+/*! \brief Send volume to a handset or peer over AVRCP
+    \param theInst The instance to send the volume to.
+    \param volume  The volume to send.
+*/
+static void appAvVolumeSendToInstance(avInstanceTaskData *theInst, uint8 volume)
+{
+    bdaddr *bd_addr = &theInst->bd_addr;
+
+    if (appDeviceIsHandset(bd_addr))
+    {
+        /* Send new volume to source (Handset or TWS Master) */
+        DEBUG_LOGF("appAvVolumeSendToInstance, nofity volume %u to handset %p", volume, theInst);
+        appAvAvrcpVolumeNotification(theInst, volume);
+    }
+    else if (appDeviceIsPeer(bd_addr))
+    {
+        /* Send new volume to peer, which could be master or slave */
+        if (appDeviceIsHandsetAvrcpConnected())
+        {
+            DEBUG_LOGF("appAvVolumeSendToInstance, absolute volume request %u to slave %p", volume, theInst);
+            AvrcpSetAbsoluteVolumeRequest(theInst->avrcp.avrcp, volume);
+        }
+        else
+        {
+            DEBUG_LOGF("appAvVolumeSendToInstance, notify volume %u to master %p", volume, theInst);
+            appAvAvrcpVolumeNotification(theInst, volume);
+        }
+    }
+    else
+        return;
+
+    appGetAv()->volume_avrcp_msgs++;
+}
 
-        /* Store configuration after 5 seconds */
-        MessageSendLater(&theAv->task, AV_INTERNAL_VOLUME_STORE_REQ, 0, D_SEC(5));
+/*! \brief Send the latest volume to all instances with a pending change
+
+    If anything was sent, the #AV_INTERNAL_VOLUME_NOTIFY timer is started so
+    changes during the next #appConfigVolumeNotifyIntervalMs are merged.
+*/
+void appAvVolumeHandleNotify(avTaskData *theAv)
+{
+    bool sent = FALSE;
+
+    for (int instance = 0; instance < AV_MAX_NUM_INSTANCES; instance++)
+    {
+        avInstanceTaskData *theInst = theAv->av_inst[instance];
+        if (theInst && theInst->avrcp.volume_pending)
+        {
+            /* Hold the volume back until queued remote control commands are sent */
+            if (theInst->avrcp.passthrough_queued)
+            {
+                sent = TRUE;
+                continue;
+            }
+
+            theInst->avrcp.volume_pending = FALSE;
+            if (appAvrcpIsConnected(theInst))
+            {
+                appAvVolumeSendToInstance(theInst, theInst->avrcp.volume);
+                sent = TRUE;
+            }
+        }
     }
+
+    if (sent)
+        MessageSendLater(&theAv->task, AV_INTERNAL_VOLUME_NOTIFY, NULL, appConfigVolumeNotifyIntervalMs());
 }
 
 /*! \brief Volume handling on AVRCP Connect
@@ -116,6 +183,8 @@ void appAvVolumeHandleAvrcpDisconnect(avInstanceTaskData *theInst)
 */
 void appAvVolumeSet(uint8 volume, avInstanceTaskData *theOtherInst)
 {
+    avTaskData *theAv = appGetAv();
+
     DEBUG_LOGF("appAvVolumeSet, volume %u", volume);
 
     /* Set local volume */
@@ -124,33 +193,14 @@ void appAvVolumeSet(uint8 volume, avInstanceTaskData *theOtherInst)
     /* Look in table to find connected instance */
     for (int instance = 0; instance < AV_MAX_NUM_INSTANCES; instance++)
     {
-        avInstanceTaskData *theInst = appGetAv()->av_inst[instance];
-        bdaddr *bd_addr = &theInst->bd_addr;
+        avInstanceTaskData *theInst = theAv->av_inst[instance];
         if (theInst && (theInst != theOtherInst))
         {
             if (appAvrcpIsConnected(theInst))
             {
-                if (appDeviceIsHandset(bd_addr))
-                {
-                    /* Send new volume to source (Handset or TWS Master) */
-                    DEBUG_LOGF("appAvVolumeSet, nofity volume %u to handset %p", volume, theInst);
-                    appAvAvrcpVolumeNotification(theInst, volume);
-                }
-                else if (appDeviceIsPeer(bd_addr))
-                {
-                    /* Send new volume to peer, which could be master or slave */
-                    if (appDeviceIsHandsetAvrcpConnected())
-                    {
-                        DEBUG_LOGF("appAvVolumeSet, absolute volume request %u to slave %p", volume, theInst);
-                        AvrcpSetAbsoluteVolumeRequest(theInst->avrcp.avrcp, volume);
-                    }
-                    else
-                    {
-                        DEBUG_LOGF("appAvVolumeSet, notify volume %u to master %p", volume, theInst);
-                        appAvAvrcpVolumeNotification(theInst, volume);
-                    }
-                }
+                /* Only the latest volume is sent, see appAvVolumeHandleNotify() */
                 theInst->avrcp.volume = volume;
+                theInst->avrcp.volume_pending = TRUE;
             }
             else
             {
@@ -158,6 +208,10 @@ void appAvVolumeSet(uint8 volume, avInstanceTaskData *theOtherInst)
             }
         }
     }
+
+    /* Send now, unless a volume was sent recently */
+    if (!MessagePendingFirst(&theAv->task, AV_INTERNAL_VOLUME_NOTIFY, NULL))
+        appAvVolumeHandleNotify(theAv);
 }
 
 /*! \brief Make volume change
@@ -19,6 +19,7 @@
 #include <kalimba.h>
 #include <kalimba_standard_messages.h>
 #include <ps.h>
+#include <vm.h>
 #include <string.h>
 
 #include "av_headset.h"
@@ -179,6 +180,7 @@ static void appAvrcpEnterConnected(avInstanceTaskData *theInst)
 {
     DEBUG_LOGF("appAvrcpEnterConnected(%p)", (void *)theInst);
 
+    theInst->avrcp.acl_handle = appConManagerGetHandle(&theInst->bd_addr);
     appAvInstanceAvrcpConnected(theInst);
     
     /* Mark this device as supporting AVRCP */
@@ -194,6 +196,8 @@ static void appAvrcpExitConnected(avInstanceTaskData *theInst)
 {
     DEBUG_LOGF("appAvrcpExitConnected(%p)", (void *)theInst);
 
+    theInst->avrcp.acl_handle = CON_MANAGER_HANDLE_INVALID;
+
     appAvInstanceAvrcpDisconnected(theInst);
 }
 
@@ -241,6 +245,9 @@ static void appAvrcpEnterDisconnected(avInstanceTaskData *theInst)
 
     /* Clear any queued up messages */
     MessageCancelAll(&theInst->av_task, AV_INTERNAL_AVRCP_REMOTE_REQ);
+    theInst->avrcp.passthrough_queued = 0;
+    theInst->avrcp.passthrough_held_count = 0;
+    theInst->avrcp.passthrough_req_pending = FALSE;
 
     /* Clear AVRCP pointer */
     theInst->avrcp.avrcp = NULL;
@@ -388,7 +395,7 @@ static void appAvrcpError(avInstanceTaskData *theInst, MessageId id, Message mes
     AV_INTERNAL_AVRCP_REMOTE_REPEAT_REQ message.
 */    
 static void appAvrcpHandleInternalAvrcpRemoteRequest(avInstanceTaskData *theInst,
-                                                     AV_INTERNAL_AVRCP_REMOTE_REQ_T *req,
+                                                     const AV_INTERNAL_AVRCP_REMOTE_REQ_T *req,
                                                      bool from_repeat_message)
 {
     DEBUG_LOGF("appAvrcpHandleInternalAvrcpRemoteRequest(%p)", (void *)theInst);
@@ -408,9 +415,12 @@ static void appAvrcpHandleInternalAvrcpRemoteRequest(avInstanceTaskData *theInst
             theInst->avrcp.op_id = req->op_id;
             theInst->avrcp.op_state = req->state;
             theInst->avrcp.op_repeat = from_repeat_message;
+            if (from_repeat_message)
+                theInst->avrcp.op_queued_ms = VmGetClock();
             
             /* Send remote control */
             AvrcpPassthroughRequest(theInst->avrcp.avrcp, subunit_panel, 0, req->state, req->op_id, 0, 0);
+            appLinkPolicyNotifyActivity(theInst->avrcp.acl_handle, LP_ACTIVITY_AVRCP);
 
             /* Repeat message every second */
             MessageCancelFirst(&theInst->av_task, AV_INTERNAL_AVRCP_REMOTE_REPEAT_REQ);
@@ -434,6 +444,201 @@ static void appAvrcpHandleInternalAvrcpRemoteRequest(avInstanceTaskData *theInst
 }
 
 
+/*! \brief Check if a passthrough operation controls volume
+
+    Volume commands are sent after any queued transport commands (play,
+    pause, skip, etc.), so a held volume key does not delay them.
+*/
+static bool appAvrcpPassthroughIsVolume(avc_operation_id op_id)
+{
+    return (op_id == opid_volume_up) || (op_id == opid_volume_down);
+}
+
+/*! \brief Check if a passthrough operation changes the play status
+
+    A queued click (press and release) of one of these operations is
+    superseded by any later one, e.g. pause-play-pause is sent as pause.
+*/
+static bool appAvrcpPassthroughIsPlayStatus(avc_operation_id op_id)
+{
+    return (op_id == opid_play) || (op_id == opid_pause) || (op_id == opid_stop);
+}
+
+/*! \brief Find a queued passthrough command
+
+    \return Index of the first matching command, or -1 if there is none.
+*/
+static int appAvrcpPassthroughFind(avInstanceTaskData *theInst, avc_operation_id op_id, uint8 state)
+{
+    for (int i = 0; i < theInst->avrcp.passthrough_queued; i++)
+    {
+        const avrcpPassthroughCommand *cmd = &theInst->avrcp.passthrough_queue[i];
+        if ((cmd->op_id == op_id) && (cmd->state == state))
+            return i;
+    }
+    return -1;
+}
+
+/*! \brief Remove commands from the passthrough queue */
+static void appAvrcpPassthroughRemove(avInstanceTaskData *theInst, int index, int count)
+{
+    avrcpPassthroughCommand *queue = theInst->avrcp.passthrough_queue;
+
+    theInst->avrcp.passthrough_queued -= count;
+    memmove(&queue[index], &queue[index + count],
+            (theInst->avrcp.passthrough_queued - index) * sizeof(queue[0]));
+}
+
+/*! \brief Release the queue slot reserved for the release of a press
+
+    \return TRUE if a press of the operation was held.
+*/
+static bool appAvrcpPassthroughUnhold(avInstanceTaskData *theInst, avc_operation_id op_id)
+{
+    for (int i = 0; i < theInst->avrcp.passthrough_held_count; i++)
+    {
+        if (theInst->avrcp.passthrough_held[i] == op_id)
+        {
+            theInst->avrcp.passthrough_held_count -= 1;
+            theInst->avrcp.passthrough_held[i] = theInst->avrcp.passthrough_held[theInst->avrcp.passthrough_held_count];
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*! \brief Discard all queued passthrough commands
+
+    Presses that are discarded no longer need their release, presses
+    already sent keep the slot for their release.
+*/
+static void appAvrcpPassthroughFlush(avInstanceTaskData *theInst)
+{
+    for (int i = 0; i < theInst->avrcp.passthrough_queued; i++)
+    {
+        if (!theInst->avrcp.passthrough_queue[i].state)
+            appAvrcpPassthroughUnhold(theInst, theInst->avrcp.passthrough_queue[i].op_id);
+    }
+    theInst->avrcp.passthrough_queued = 0;
+}
+
+/*! \brief Send the command at the head of the passthrough queue
+
+    The request is held until the AVRCP lock is released, so only one
+    command is in flight at a time.
+*/
+static void appAvrcpPassthroughKick(avInstanceTaskData *theInst)
+{
+    if (theInst->avrcp.passthrough_queued && !theInst->avrcp.passthrough_req_pending)
+    {
+        theInst->avrcp.passthrough_req_pending = TRUE;
+        MessageSendConditionally(&theInst->av_task, AV_INTERNAL_AVRCP_REMOTE_REQ,
+                                 NULL, &appAvrcpGetLock(theInst));
+    }
+}
+
+/*! \brief Queue a passthrough command
+
+    A play status click replaces any queued play status click and transport
+    commands are queued ahead of volume commands. A queue slot is reserved
+    for the release of each press accepted, and a release is dropped if its
+    press was dropped, so a release is never sent without its press.
+*/
+static void appAvrcpPassthroughQueue(avInstanceTaskData *theInst, avc_operation_id op_id,
+                                     uint8 state, bool ui, uint16 repeat_ms)
+{
+    avTaskData *theAv = appGetAv();
+    avrcpPassthroughCommand *queue = theInst->avrcp.passthrough_queue;
+    int index = theInst->avrcp.passthrough_queued;
+
+    if (!state && appAvrcpPassthroughIsPlayStatus(op_id))
+    {
+        for (int i = 0; i + 1 < theInst->avrcp.passthrough_queued; )
+        {
+            if (!queue[i].state && appAvrcpPassthroughIsPlayStatus(queue[i].op_id) &&
+                (queue[i + 1].op_id == queue[i].op_id) && queue[i + 1].state)
+            {
+                DEBUG_LOGF("appAvrcpPassthroughQueue, op_id %u supersedes op_id %u", op_id, queue[i].op_id);
+                ui = ui || queue[i].ui;
+                appAvrcpPassthroughRemove(theInst, i, 2);
+                theAv->avrcp_passthrough_stats.coalesced += 2;
+            }
+            else
+                i++;
+        }
+        index = theInst->avrcp.passthrough_queued;
+    }
+
+    if (state)
+    {
+        /* Use the slot reserved when the press was queued */
+        if (!appAvrcpPassthroughUnhold(theInst, op_id))
+        {
+            DEBUG_LOGF("appAvrcpPassthroughQueue, press dropped, dropping release op_id %u", op_id);
+            theAv->avrcp_passthrough_stats.dropped += 1;
+            return;
+        }
+    }
+    else if ((theInst->avrcp.passthrough_held_count >= ARRAY_DIM(theInst->avrcp.passthrough_held)) ||
+             (theInst->avrcp.passthrough_queued + theInst->avrcp.passthrough_held_count + 2 > AVRCP_PASSTHROUGH_QUEUE_DEPTH))
+    {
+        DEBUG_LOGF("appAvrcpPassthroughQueue, queue full, dropping op_id %u state %u", op_id, state);
+        theAv->avrcp_passthrough_stats.dropped += 1;
+        return;
+    }
+    else
+    {
+        theInst->avrcp.passthrough_held[theInst->avrcp.passthrough_held_count++] = op_id;
+    }
+
+    if (!appAvrcpPassthroughIsVolume(op_id))
+    {
+        /* Insert before the first queued volume command */
+        for (int i = 0; i < theInst->avrcp.passthrough_queued; i++)
+        {
+            if (appAvrcpPassthroughIsVolume(queue[i].op_id))
+            {
+                index = i;
+                break;
+            }
+        }
+    }
+
+    memmove(&queue[index + 1], &queue[index],
+            (theInst->avrcp.passthrough_queued - index) * sizeof(queue[0]));
+    queue[index].op_id = op_id;
+    queue[index].state = state ? 1 : 0;
+    queue[index].ui = ui;
+    queue[index].repeat_ms = repeat_ms;
+    queue[index].queued_ms = VmGetClock();
+    theInst->avrcp.passthrough_queued += 1;
+
+    appAvrcpPassthroughKick(theInst);
+}
+
+/*! \brief Send the command at the head of the passthrough queue */
+static void appAvrcpHandleInternalAvrcpRemoteQueueRequest(avInstanceTaskData *theInst)
+{
+    AV_INTERNAL_AVRCP_REMOTE_REQ_T req;
+    const avrcpPassthroughCommand *cmd = &theInst->avrcp.passthrough_queue[0];
+
+    theInst->avrcp.passthrough_req_pending = FALSE;
+    if (!theInst->avrcp.passthrough_queued)
+        return;
+
+    req.op_id = cmd->op_id;
+    req.state = cmd->state;
+    req.ui = cmd->ui;
+    req.repeat_ms = cmd->repeat_ms;
+    theInst->avrcp.op_queued_ms = cmd->queued_ms;
+    appAvrcpPassthroughRemove(theInst, 0, 1);
+
+    appAvrcpHandleInternalAvrcpRemoteRequest(theInst, &req, FALSE);
+
+    /* Next command is held until this one is confirmed */
+    appAvrcpPassthroughKick(theInst);
+}
+
 static bool appAvrcpAddClient(avInstanceTaskData *theInst, Task client)
 {
     return appTaskListAddTask(theInst->avrcp.client_list, client);
@@ -903,6 +1108,9 @@ static void appAvrcpHandleInternalAvrcpVendorPassthroughRequest(avInstanceTaskDa
                                     opid_vendor_unique,
                                     size_vendor_data,
                                     StreamRegionSource(vendor_data, size_vendor_data));
+            appLinkPolicyNotifyActivity(theInst->avrcp.acl_handle, appDeviceIsPeer(&theInst->bd_addr) ?
+                                                                        LP_ACTIVITY_PEER_SIGNALLING :
+                                                                        LP_ACTIVITY_AVRCP);
 
             /* Set lock to prevent other passthrough requests */
             appAvrcpSetLock(theInst, APP_AVRCP_LOCK_PASSTHROUGH_REQ);
@@ -1253,14 +1461,31 @@ static void appAvrcpHandleAvrcpPassthroughConfirm(avInstanceTaskData *theInst, c
     {
         case AVRCP_STATE_CONNECTED:
         {
+            avrcpPassthroughStats *stats = &appGetAv()->avrcp_passthrough_stats;
+            uint32 latency_ms = VmGetClock() - theInst->avrcp.op_queued_ms;
+
             /* Clear operation lock */
             appAvrcpClearLock(theInst, APP_AVRCP_LOCK_PASSTHROUGH_REQ);
 
+            /* Record response latency of remote control commands */
+            if (theInst->avrcp.op_id != opid_vendor_unique)
+            {
+                stats->commands += 1;
+                stats->latency_total_ms += latency_ms;
+                stats->latency_last_ms = (latency_ms > 0xFFFF) ? 0xFFFF : (uint16)latency_ms;
+                if (stats->latency_last_ms > stats->latency_max_ms)
+                    stats->latency_max_ms = stats->latency_last_ms;
+                DEBUG_LOGF("appAvrcpHandleAvrcpPassthroughConfirm, op_id %u, latency %ums",
+                           theInst->avrcp.op_id, stats->latency_last_ms);
+            }
+
             /* Clear any pending requests if this one failed, so the rest will probably as well */
             if (cfm->status != avrcp_success)
             {
                 MessageCancelAll(&theInst->av_task, AV_INTERNAL_AVRCP_REMOTE_REPEAT_REQ);
                 MessageCancelAll(&theInst->av_task, AV_INTERNAL_AVRCP_REMOTE_REQ);
+                appAvrcpPassthroughFlush(theInst);
+                theInst->avrcp.passthrough_req_pending = FALSE;
             }
 
             /* Play specific tone if required */
@@ -1537,6 +1762,7 @@ static void appAvrcpHandleSetAbsoluteVolumeInd(avInstanceTaskData *theInst, AVRC
 
     /* Accept the volume change */
     AvrcpSetAbsoluteVolumeResponse(ind->avrcp, avctp_response_accepted, ind->volume);
+    appLinkPolicyNotifyActivity(theInst->avrcp.acl_handle, LP_ACTIVITY_AVRCP);
 }
 
 /*! \brief Confirmation of SetAbsoluteVolume Command (Controller->Target)
@@ -1666,22 +1892,19 @@ void appAvrcpRemoteControl(avInstanceTaskData *theInst, avc_operation_id op_id,
     PanicFalse(appAvIsValidInst(theInst));
     DEBUG_LOG("appAvrcpRemoteControl");
 
-    /* Cancel repeated operation, exit if it doesn't exist */
-    if (rstate && repeat_ms && !MessageCancelFirst(&theInst->av_task, AV_INTERNAL_AVRCP_REMOTE_REPEAT_REQ))
+    /* Cancel repeated operation, exit if it doesn't exist and the press
+       hasn't been sent yet. The repeat is also cancelled when the press is
+       rejected, so free the slot reserved for the release. */
+    if (rstate && repeat_ms && (appAvrcpPassthroughFind(theInst, op_id, 0) < 0) &&
+        !MessageCancelFirst(&theInst->av_task, AV_INTERNAL_AVRCP_REMOTE_REPEAT_REQ))
     {
+        appAvrcpPassthroughUnhold(theInst, op_id);
         return;
     }
     else
     {
-        MAKE_AV_MESSAGE(AV_INTERNAL_AVRCP_REMOTE_REQ);
-
-        /* Send internal message */
-        message->op_id = op_id;
-        message->state = rstate;
-        message->ui = ui;
-        message->repeat_ms = repeat_ms;
-        MessageSendConditionally(&theInst->av_task, AV_INTERNAL_AVRCP_REMOTE_REQ,
-                                 message, &appAvrcpGetLock(theInst));
+        /* Queue command, sent when AVRCP is unlocked */
+        appAvrcpPassthroughQueue(theInst, op_id, rstate, ui, repeat_ms);
     }
 }
 
@@ -1737,7 +1960,7 @@ void appAvrcpInstanceHandleMessage(avInstanceTaskData *theInst, MessageId id, Me
             return;
 
         case AV_INTERNAL_AVRCP_REMOTE_REQ:
-            appAvrcpHandleInternalAvrcpRemoteRequest(theInst, (AV_INTERNAL_AVRCP_REMOTE_REQ_T *)message, FALSE);
+            appAvrcpHandleInternalAvrcpRemoteQueueRequest(theInst);
             return;
 
         case AV_INTERNAL_AVRCP_REMOTE_REPEAT_REQ:
@@ -1957,11 +2180,18 @@ void appAvrcpInstanceInit(avInstanceTaskData *theInst)
     theInst->avrcp.vendor_data = NULL;
     theInst->avrcp.vendor_opid = 0;
     theInst->avrcp.remotely_initiated = FALSE;
+    theInst->avrcp.early_connect = FALSE;
     theInst->avrcp.client_list = NULL;
     theInst->avrcp.client_lock = 0;
     theInst->avrcp.play_status = avrcp_play_status_error;
     theInst->avrcp.play_hint = avrcp_play_status_error;
     theInst->avrcp.volume = 0;
+    theInst->avrcp.volume_pending = FALSE;
+    theInst->avrcp.passthrough_queued = 0;
+    theInst->avrcp.passthrough_held_count = 0;
+    theInst->avrcp.passthrough_req_pending = FALSE;
+    theInst->avrcp.op_queued_ms = 0;
+    theInst->avrcp.acl_handle = CON_MANAGER_HANDLE_INVALID;
 }
 
 #else
@@ -58,6 +58,31 @@ typedef enum
     AVRCP_STATE_DISCONNECTING = 7 + AVRCP_STATE_LOCK                    /*!< Disconnecting control channel */
 } avAvrcpState;
 
+/*! Maximum number of passthrough commands (press or release) queued on an
+    AVRCP instance */
+#define AVRCP_PASSTHROUGH_QUEUE_DEPTH   (8)
+
+/*! A queued AVRCP passthrough command */
+typedef struct
+{
+    avc_operation_id op_id;     /*!< Operation ID */
+    unsigned state:1;           /*!< Button press (0) or release (1) */
+    unsigned ui:1;              /*!< Flag when set indicates tone should be played */
+    uint16 repeat_ms;           /*!< Period between repeats (0 for none) */
+    uint32 queued_ms;           /*!< Time (VmGetClock) the command was queued */
+} avrcpPassthroughCommand;
+
+/*! AVRCP passthrough command statistics */
+typedef struct
+{
+    uint16 commands;            /*!< Passthrough commands sent */
+    uint16 coalesced;           /*!< Commands removed as superseded by a later command */
+    uint16 dropped;             /*!< Commands dropped as the queue was full */
+    uint16 latency_last_ms;     /*!< Time from queueing to confirmation of the last command */
+    uint16 latency_max_ms;      /*!< Longest time from queueing to confirmation */
+    uint32 latency_total_ms;    /*!< Sum of times from queueing to confirmation */
+} avrcpPassthroughStats;
+
 typedef struct avrcpTaskData
 {
     AVRCP          *avrcp;                /*!< AVRCP profile library instance */
@@ -76,11 +101,20 @@ typedef struct avrcpTaskData
     uint8          *vendor_data;          /*!< Data for current vendor command */
     uint16          vendor_opid;          /*!< Operation identifier of the current vendor command */
     bool            remotely_initiated;   /*!< Was this connection initiated by the far end */
+    bool            early_connect;        /*!< Connection started without waiting after a remotely initiated A2DP connection */
                                           /*! Current play status of the AVRCP connection. 
                                               This is not always known. See \ref avrcp_play_hint */
     uint8           volume;               /*!< Current avrcp instance volume */
+    bool            volume_pending;       /*!< Volume changed but not yet sent, see #AV_INTERNAL_VOLUME_NOTIFY */
     avrcp_play_status play_status;
     avrcp_play_status play_hint;          /*!< Our local guess at the play status. Not always accurate. */
+    avrcpPassthroughCommand passthrough_queue[AVRCP_PASSTHROUGH_QUEUE_DEPTH]; /*!< Passthrough commands waiting to be sent */
+    uint8           passthrough_queued;   /*!< Number of commands in passthrough_queue */
+    avc_operation_id passthrough_held[AVRCP_PASSTHROUGH_QUEUE_DEPTH / 2]; /*!< Presses queued or sent, each has a queue slot reserved for its release */
+    uint8           passthrough_held_count; /*!< Number of entries in passthrough_held */
+    bool            passthrough_req_pending; /*!< AV_INTERNAL_AVRCP_REMOTE_REQ sent to send the queue head */
+    uint32          op_queued_ms;         /*!< Time (VmGetClock) the last sent operation was queued */
+    uint16          acl_handle;           /*!< Connection manager handle (#conManagerHandle) of the link whilst connected */
 } avrcpTaskData;
 
     
@@ -21,9 +21,29 @@
 /*! Whilst the filter is being filled read at this rate */
 #define BATTERY_READ_PERIOD_INITIAL (100)
 
-/*! When the filter is full, read at this rate */
+/*! When the filter is full, read at this rate when the voltage is near a
+    threshold. Further from thresholds the rate is reduced. */
 #define BATTERY_READ_PERIOD (D_SEC(2))
 
+/*! Multiplier applied to the read period when the voltage is not near a
+    threshold but still moving */
+#define BATTERY_READ_PERIOD_UNSTABLE_MULTIPLIER (4)
+
+/*! Multiplier applied to the read period when the voltage is stable and
+    not near a threshold */
+#define BATTERY_READ_PERIOD_STABLE_MULTIPLIER   (15)
+
+/*! The latest reading must be within this many milli-volts of the filtered
+    voltage for the voltage to be considered stable */
+#define BATTERY_STABLE_MARGIN_MV                (20)
+
+/*! The voltage is considered near a threshold within this many milli-volts */
+#define BATTERY_THRESHOLD_MARGIN_MV             (2 * appConfigSmBatteryHysteresisMargin())
+
+/*! When charging, the voltage is considered near termination within this
+    many milli-volts of the termination voltage */
+#define BATTERY_TERMINATION_MARGIN_MV           (100)
+
 /*! Enumerated type for messages sent within the headset battery 
     handler only. */
 enum headset_battery_internal_messages
@@ -37,47 +57,312 @@ enum headset_battery_internal_messages
 /*! TRUE when the filter is filled with results */
 #define FILTER_IS_FULL(battery) ((battery)->filter.index >= BATTERY_FILTER_LEN)
 
-/*! Add a client to the list of clients */
+/*! The battery capacity in micro-coulombs (1mAh = 3.6C) */
+#define BATTERY_CAPACITY_UC ((uint32)appConfigBatteryCapacityMah() * 3600000UL)
+
+/*! Divisor applied to the difference between the coulomb counted charge and
+    the charge implied by the OCV curve on each reading. The OCV estimate is
+    trusted more when the load is light. */
+#define BATTERY_SOC_OCV_CORRECTION_IDLE     (16)
+#define BATTERY_SOC_OCV_CORRECTION_LOADED   (64)
+
+/*! The widest band, which no value can exceed */
+#define BATTERY_BAND_FULL_LOW   (0)
+#define BATTERY_BAND_FULL_HIGH  (0xFFFF)
+
+/*! TRUE if the value is outside the band, so a client may need notifying */
+static bool bandExceeded(const batteryBand *band, uint16 value)
+{
+    return value < band->low || value > band->high;
+}
+
+/*! Set a band centred on value, with width given by hysteresis */
+static void bandSet(batteryBand *band, uint16 value, uint16 hysteresis)
+{
+    band->low = value > hysteresis ? value - hysteresis : BATTERY_BAND_FULL_LOW;
+    band->high = (uint32)value + hysteresis < BATTERY_BAND_FULL_HIGH ?
+                    value + hysteresis : BATTERY_BAND_FULL_HIGH;
+}
+
+/*! Narrow band to its intersection with other */
+static void bandIntersect(batteryBand *band, const batteryBand *other)
+{
+    if (other->low > band->low)
+        band->low = other->low;
+    if (other->high < band->high)
+        band->high = other->high;
+}
+
+/*! Compute the band of values for which the client need not be notified,
+    given the last value sent. For battery_level_repres_state the band is
+    the range of voltages in which stateUpdateIsRequired() cannot be TRUE. */
+static void appBatteryClientUpdateBand(batteryRegisteredClient *client)
+{
+    uint16 hysteresis = client->form.hysteresis;
+    batteryBand *band = &client->band;
+
+    if (client->notify_pending)
+    {
+        /* An empty band, any value exceeds it */
+        band->low = BATTERY_BAND_FULL_HIGH;
+        band->high = BATTERY_BAND_FULL_LOW;
+        return;
+    }
+
+    switch (client->form.representation)
+    {
+        case battery_level_repres_voltage:
+            bandSet(band, client->last.voltage, hysteresis);
+            break;
+
+        case battery_level_repres_percent:
+            bandSet(band, client->last.percent, hysteresis);
+            break;
+
+        case battery_level_repres_runtime:
+            bandSet(band, client->last.runtime_mins, hysteresis);
+            break;
+
+        case battery_level_repres_state:
+            switch (client->last.state)
+            {
+                case battery_level_too_low:
+                    band->low = BATTERY_BAND_FULL_LOW;
+                    band->high = appConfigBatteryVoltageCritical() + hysteresis;
+                    break;
+                case battery_level_critical:
+                    band->low = appConfigBatteryVoltageCritical() - hysteresis;
+                    band->high = appConfigBatteryVoltageLow() + hysteresis;
+                    break;
+                case battery_level_low:
+                    band->low = appConfigBatteryVoltageLow() - hysteresis;
+                    band->high = appConfigBatteryVoltageOk() + hysteresis;
+                    break;
+                case battery_level_ok:
+                    band->low = appConfigBatteryVoltageOk() - hysteresis;
+                    band->high = BATTERY_BAND_FULL_HIGH;
+                    break;
+                default:
+                    band->low = BATTERY_BAND_FULL_HIGH;
+                    band->high = BATTERY_BAND_FULL_LOW;
+                    break;
+            }
+            break;
+    }
+}
+
+/*! Recompute the no-change bands from the bands of all clients. A reading
+    within all of these bands cannot cause any client to be notified. */
+static void appBatteryUpdateBands(batteryTaskData *battery)
+{
+    batteryRegisteredClient *client;
+
+    battery->band.voltage.low = battery->band.percent.low = battery->band.runtime.low = BATTERY_BAND_FULL_LOW;
+    battery->band.voltage.high = battery->band.percent.high = battery->band.runtime.high = BATTERY_BAND_FULL_HIGH;
+
+    for (client = battery->client_list; client != NULL; client = client->next)
+    {
+        switch (client->form.representation)
+        {
+            case battery_level_repres_voltage:
+            case battery_level_repres_state:
+                bandIntersect(&battery->band.voltage, &client->band);
+                break;
+            case battery_level_repres_percent:
+                bandIntersect(&battery->band.percent, &client->band);
+                break;
+            case battery_level_repres_runtime:
+                bandIntersect(&battery->band.runtime, &client->band);
+                break;
+        }
+    }
+}
+
+/*! Add a client. Clients registering identical forms share one entry and
+    so one notification. */
 static bool appBatteryClientAdd(batteryTaskData *battery, batteryRegistrationForm *form)
 {
-    batteryRegisteredClient *new = calloc(1, sizeof(*new));
-    if (new)
+    batteryRegisteredClient *client;
+
+    for (client = battery->client_list; client != NULL; client = client->next)
     {
-        new->form = *form;
-        new->next = battery->client_list;
-        battery->client_list = new;
-        return TRUE;
+        if (   client->form.representation == form->representation
+            && client->form.hysteresis == form->hysteresis)
+        {
+            break;
+        }
     }
-    return FALSE;
+
+    if (!client)
+    {
+        client = calloc(1, sizeof(*client));
+        if (!client)
+        {
+            return FALSE;
+        }
+        client->form = *form;
+        client->tasks = appTaskListInit();
+        client->next = battery->client_list;
+        battery->client_list = client;
+    }
+
+    appTaskListAddTask(client->tasks, form->task);
+
+    /* Send the current level on the next reading so the new task is
+       informed, existing tasks will receive a duplicate */
+    client->notify_pending = TRUE;
+    appBatteryClientUpdateBand(client);
+    appBatteryUpdateBands(battery);
+    return TRUE;
 }
 
-/*! Remove a client from the list of clients */
+/*! Remove a client task, freeing its entry if it was the last task */
 static void appBatteryClientRemove(batteryTaskData *battery, Task task)
 {
     batteryRegisteredClient **head;
     for (head = &battery->client_list; *head != NULL; head = &(*head)->next)
     {
-        if ((*head)->form.task == task)
+        if (appTaskListRemoveTask((*head)->tasks, task))
         {
-            batteryRegisteredClient *toremove = *head;
-            *head = (*head)->next;
-            free(toremove);
+            if (appTaskListSize((*head)->tasks) == 0)
+            {
+                batteryRegisteredClient *toremove = *head;
+                *head = (*head)->next;
+                appTaskListDestroy(toremove->tasks);
+                free(toremove);
+                appBatteryUpdateBands(battery);
+            }
             break;
         }
     }
 }
 
+/*! Convert an open circuit voltage to state of charge in tenths of a percent,
+    interpolating linearly between the points of the OCV curve */
+static uint16 toPermille(uint16 voltage)
+{
+    const batteryOcvCurve *curve = appConfigBatteryOcvCurve();
+    const batteryOcvPoint *lower = &curve->points[0];
+    const batteryOcvPoint *upper = &curve->points[curve->num_points - 1];
+    unsigned i;
+
+    if (voltage <= lower->voltage_mv)
+        return lower->percent * 10;
+    if (voltage >= upper->voltage_mv)
+        return upper->percent * 10;
+
+    for (i = 1; i < curve->num_points; i++)
+    {
+        upper = &curve->points[i];
+        if (voltage < upper->voltage_mv)
+            break;
+        lower = upper;
+    }
+
+    return (lower->percent * 10) +
+           ((uint32)(voltage - lower->voltage_mv) * (upper->percent - lower->percent) * 10) /
+           (uint32)(upper->voltage_mv - lower->voltage_mv);
+}
+
 static uint8 toPercentage(uint16 voltage)
 {
-    uint16 critical = appConfigBatteryVoltageCritical();
-    uint16 charged = appConfigBatteryFullyCharged();
+    return toPermille(voltage) / 10;
+}
+
+/*! Get the estimated average current for a use case in micro-amps */
+static uint32 appBatteryUseCaseCurrent(battery_use_case use_case)
+{
+    switch (use_case)
+    {
+        case battery_use_case_tone:
+            return appConfigBatteryCurrentToneUa();
+        case battery_use_case_a2dp:
+            return appConfigBatteryCurrentA2dpUa();
+        case battery_use_case_a2dp_forwarding:
+            return appConfigBatteryCurrentA2dpForwardingUa();
+        case battery_use_case_sco:
+            return appConfigBatteryCurrentScoUa();
+        case battery_use_case_idle:
+        default:
+            return appConfigBatteryCurrentIdleUa();
+    }
+}
 
-    if (voltage < critical)
-        voltage = critical;
-    else if (voltage > charged)
-        voltage = charged;
+/*! Estimate the current battery current in micro-amps from the known load
+    and charger state. Positive when discharging, negative when charging. */
+static int32 appBatteryEstimateCurrent(void)
+{
+    int32 current = (int32)appBatteryUseCaseCurrent(appBatteryGetUseCase());
 
-    return (100UL * (uint32)(voltage - critical)) / (uint32)(charged - critical);
+#ifdef INCLUDE_CHARGER
+    switch (ChargerStatus())
+    {
+        case FAST_CHARGE:
+            current = -(int32)appConfigChargerFastCurrent() * 1000;
+            break;
+        case PRE_CHARGE:
+            current = -(int32)appConfigChargerPreCurrent() * 1000;
+            break;
+        case TRICKLE_CHARGE:
+            current = -(int32)appConfigChargerTrickleCurrent() * 1000;
+            break;
+        case STANDBY:
+        case HEADROOM_ERROR:
+        case DISABLED_ERROR:
+            /* The charger supplies the load */
+            current = 0;
+            break;
+        default:
+            break;
+    }
+#endif
+
+    return current;
+}
+
+/*! Update the coulomb counted state of charge with the latest reading */
+static void appBatteryUpdateStateOfCharge(batteryTaskData *battery)
+{
+    uint32 now = VmGetClock();
+    int32 capacity = (int32)BATTERY_CAPACITY_UC;
+    int32 ocv_charge = (int32)((BATTERY_CAPACITY_UC / 1000) * toPermille(appBatteryGetVoltage()));
+
+    if (!battery->soc.valid)
+    {
+        /* Seed the estimator from the OCV curve */
+        battery->soc.charge_uc = (uint32)ocv_charge;
+        battery->soc.valid = TRUE;
+    }
+    else
+    {
+        uint32 elapsed_ms = now - battery->soc.last_update_ms;
+        int32 current = battery->soc.current_ua;
+        int32 charge = (int32)battery->soc.charge_uc;
+        int32 divisor = (current > 0 && current <= (int32)appConfigBatteryCurrentIdleUa()) ?
+                            BATTERY_SOC_OCV_CORRECTION_IDLE :
+                            BATTERY_SOC_OCV_CORRECTION_LOADED;
+
+        /* Integrate the current over the elapsed time, split to avoid overflow */
+        charge -= current * (int32)(elapsed_ms / 1000);
+        charge -= (current * (int32)(elapsed_ms % 1000)) / 1000;
+
+        /* Slowly pull the estimate towards the OCV curve to cancel drift */
+        charge += (ocv_charge - charge) / divisor;
+
+#ifdef INCLUDE_CHARGER
+        /* Charging has terminated, the battery is full */
+        if (ChargerStatus() == STANDBY)
+            charge = capacity;
+#endif
+
+        if (charge < 0)
+            charge = 0;
+        else if (charge > capacity)
+            charge = capacity;
+
+        battery->soc.charge_uc = (uint32)charge;
+    }
+    battery->soc.last_update_ms = now;
 }
 
 static battery_level_state toState(uint16 voltage)
@@ -201,51 +486,102 @@ static bool stateUpdateIsRequired(battery_level_state last_state,
     return FALSE;
 }
 
-/*! Iterate through the list of clients, sending battery level messages when
-    the representation criteria is met */
+/*! Send battery level messages to the clients whose band has been exceeded.
+    Most readings are within the no-change bands and return immediately. */
 static void appBatteryServiceClients(batteryTaskData *battery)
 {
     batteryRegisteredClient *client = NULL;
     uint16 voltage = appBatteryGetVoltage();
+    uint8 percent = appBatteryGetPercent();
+    battery_use_case use_case = appBatteryGetUseCase();
+    uint16 runtime = appBatteryGetRemainingMinutes(use_case);
+    bool updated = FALSE;
+
+    if (   !bandExceeded(&battery->band.voltage, voltage)
+        && !bandExceeded(&battery->band.percent, percent)
+        && !bandExceeded(&battery->band.runtime, runtime))
+    {
+        return;
+    }
+
     for (client = battery->client_list; client != NULL; client = client->next)
     {
-        uint16 hysteresis = client->form.hysteresis;
+        bool notified = FALSE;
+
         switch (client->form.representation)
         {
             case battery_level_repres_voltage:
-                if (thresholdExceeded(voltage, client->last.voltage, hysteresis))
+                if (bandExceeded(&client->band, voltage))
                 {
                     MESSAGE_MAKE(msg, MESSAGE_BATTERY_LEVEL_UPDATE_VOLTAGE_T);
                     msg->voltage_mv = voltage;
                     client->last.voltage = voltage;
-                    MessageSend(client->form.task, MESSAGE_BATTERY_LEVEL_UPDATE_VOLTAGE, msg);
+                    appTaskListMessageSend(client->tasks, MESSAGE_BATTERY_LEVEL_UPDATE_VOLTAGE, msg);
+                    notified = TRUE;
                 }
             break;
             case battery_level_repres_percent:
             {
-                uint8 percent = toPercentage(voltage);
-                if (thresholdExceeded(percent, client->last.percent, hysteresis))
+                if (bandExceeded(&client->band, percent))
                 {
                     MESSAGE_MAKE(msg, MESSAGE_BATTERY_LEVEL_UPDATE_PERCENT_T);
                     msg->percent = percent;
                     client->last.percent = percent;
-                    MessageSend(client->form.task, MESSAGE_BATTERY_LEVEL_UPDATE_PERCENT, msg);
+                    appTaskListMessageSend(client->tasks, MESSAGE_BATTERY_LEVEL_UPDATE_PERCENT, msg);
+                    notified = TRUE;
                 }
             }
             break;
             case battery_level_repres_state:
             {
-                battery_level_state new_state = toState(voltage);
-                if (stateUpdateIsRequired(client->last.state, new_state, voltage, hysteresis))
+                if (bandExceeded(&client->band, voltage))
+                {
+                    battery_level_state new_state = toState(voltage);
+                    bool required = client->notify_pending ?
+                                        new_state != battery_level_unknown :
+                                        stateUpdateIsRequired(client->last.state, new_state,
+                                                              voltage, client->form.hysteresis);
+                    if (required)
+                    {
+                        MESSAGE_MAKE(msg, MESSAGE_BATTERY_LEVEL_UPDATE_STATE_T);
+                        msg->state = new_state;
+                        client->last.state = new_state;
+                        appTaskListMessageSend(client->tasks, MESSAGE_BATTERY_LEVEL_UPDATE_STATE, msg);
+                        notified = TRUE;
+                    }
+                }
+            }
+            break;
+            case battery_level_repres_runtime:
+            {
+                if (battery->soc.valid && bandExceeded(&client->band, runtime))
                 {
-                    MESSAGE_MAKE(msg, MESSAGE_BATTERY_LEVEL_UPDATE_STATE_T);
-                    msg->state = new_state;
-                    client->last.state = new_state;
-                    MessageSend(client->form.task, MESSAGE_BATTERY_LEVEL_UPDATE_STATE, msg);
+                    int i;
+                    MESSAGE_MAKE(msg, MESSAGE_BATTERY_LEVEL_UPDATE_RUNTIME_T);
+                    msg->use_case = use_case;
+                    for (i = 0; i < battery_use_cases; i++)
+                    {
+                        msg->runtime_mins[i] = appBatteryGetRemainingMinutes(i);
+                    }
+                    client->last.runtime_mins = runtime;
+                    appTaskListMessageSend(client->tasks, MESSAGE_BATTERY_LEVEL_UPDATE_RUNTIME, msg);
+                    notified = TRUE;
                 }
             }
             break;
         }
+
+        if (notified)
+        {
+            client->notify_pending = FALSE;
+            appBatteryClientUpdateBand(client);
+            updated = TRUE;
+        }
+    }
+
+    if (updated)
+    {
+        appBatteryUpdateBands(battery);
     }
 }
 
@@ -260,11 +596,19 @@ static bool appBatteryAdcResultHandler(batteryTaskData *battery, MessageAdcResul
         case adcsel_pmu_vbat_sns:
         {
             uint32 index = battery->filter.index & BATTERY_FILTER_MASK;
-            uint16 vbatt_mv = (uint16)((uint32)VmReadVrefConstant() * reading / battery->vref_raw);
+            int32 current = appBatteryEstimateCurrent();
+            int32 vbatt_mv = (int32)((uint32)VmReadVrefConstant() * reading / battery->vref_raw);
+
+            /* Add back the drop across the internal resistance (uA * mOhm = nV) */
+            vbatt_mv += (current * (int32)appConfigBatteryInternalResistanceMilliOhm()) / 1000000;
+            if (vbatt_mv < 0)
+                vbatt_mv = 0;
+            battery->soc.current_ua = current;
 
             battery->filter.accumulator -= battery->filter.buf[index];
-            battery->filter.buf[index] = vbatt_mv;
-            battery->filter.accumulator += vbatt_mv;
+            battery->filter.buf[index] = (uint16)vbatt_mv;
+            battery->filter.accumulator += (uint16)vbatt_mv;
+            battery->last_reading = (uint16)vbatt_mv;
             /* See the logic in appBatteryGetVoltage():
                0<=index<BATTERY_FILTER_LEN is only used when filling the filter,
                so jump over that range when the index wraps */
@@ -287,15 +631,64 @@ static bool appBatteryAdcResultHandler(batteryTaskData *battery, MessageAdcResul
     return FALSE;
 }
 
+/*! TRUE if the voltage is within margin of threshold */
+static bool nearThreshold(uint16 voltage, uint16 threshold, uint16 margin)
+{
+    return !thresholdExceeded(voltage, threshold, margin);
+}
+
+/*! Select the delay to the next measurement. Measure at the configured period
+    when a client is likely to be notified soon, less often when the voltage
+    is stable and well away from the thresholds. */
+static uint32 appBatteryGetMeasurementDelay(batteryTaskData *battery)
+{
+    uint16 voltage;
+    uint16 margin = BATTERY_THRESHOLD_MARGIN_MV;
+
+    if (!FILTER_IS_FULL(battery))
+    {
+        return BATTERY_READ_PERIOD_INITIAL;
+    }
+
+    voltage = appBatteryGetVoltage();
+    if (   nearThreshold(voltage, appConfigBatteryVoltageCritical(), margin)
+        || nearThreshold(voltage, appConfigBatteryVoltageLow(), margin)
+        || nearThreshold(voltage, appConfigBatteryVoltageOk(), margin))
+    {
+        return battery->period;
+    }
+
+    if (   appChargerIsConnected()
+        && voltage + BATTERY_TERMINATION_MARGIN_MV > appConfigChargerTerminationVoltage())
+    {
+        return battery->period;
+    }
+
+    if (thresholdExceeded(battery->last_reading, voltage, BATTERY_STABLE_MARGIN_MV))
+    {
+        return (uint32)battery->period * BATTERY_READ_PERIOD_UNSTABLE_MULTIPLIER;
+    }
+    return (uint32)battery->period * BATTERY_READ_PERIOD_STABLE_MULTIPLIER;
+}
+
 static void appBatteryScheduleNextMeasurement(batteryTaskData *battery)
 {
-    uint32 delay = FILTER_IS_FULL(battery) ?
-                        battery->period :
-                        BATTERY_READ_PERIOD_INITIAL;
+    uint32 delay = appBatteryGetMeasurementDelay(battery);
+
+    battery->next_measurement_ms = VmGetClock() + delay;
     MessageSendLater(&battery->task, MESSAGE_BATTERY_INTERNAL_MEASUREMENT_TRIGGER,
                         NULL, delay);
 }
 
+/*! Start a measurement and schedule the next one */
+static void appBatteryStartMeasurement(batteryTaskData *battery)
+{
+    /* Start immediate battery reading, note vref is read first */
+    AdcReadRequest(&battery->task, adcsel_vref_hq_buff, 0, 0);
+    AdcReadRequest(&battery->task, adcsel_pmu_vbat_sns, 0, 0);
+    appBatteryScheduleNextMeasurement(battery);
+}
+
 static void appBatteryHandleMessage(Task task, MessageId id, Message message)
 {
     batteryTaskData *battery = (batteryTaskData *)task;
@@ -306,6 +699,7 @@ static void appBatteryHandleMessage(Task task, MessageId id, Message message)
             case MESSAGE_ADC_RESULT:
                 if (appBatteryAdcResultHandler(battery, (MessageAdcResult*)message))
                 {
+                    appBatteryUpdateStateOfCharge(battery);
                     appBatteryServiceClients(battery);
                 }
                 break;
@@ -315,10 +709,8 @@ static void appBatteryHandleMessage(Task task, MessageId id, Message message)
                 break;
 
             case MESSAGE_BATTERY_INTERNAL_MEASUREMENT_TRIGGER:
-                /* Start immediate battery reading, note vref is read first */
-                AdcReadRequest(&battery->task, adcsel_vref_hq_buff, 0, 0);
-                AdcReadRequest(&battery->task, adcsel_pmu_vbat_sns, 0, 0);
-                appBatteryScheduleNextMeasurement(battery);
+                battery->wakeups.count++;
+                appBatteryStartMeasurement(battery);
                 break;
 
             default:
@@ -338,6 +730,8 @@ void appBatteryInit(void)
     /* Set up task handler */
     battery->task.handler = appBatteryHandleMessage;
     battery->period = BATTERY_READ_PERIOD;
+    appBatteryUpdateBands(battery);
+    battery->wakeups.start_ms = VmGetClock();
 
     appBatteryScheduleNextMeasurement(battery);
 }
@@ -350,6 +744,7 @@ void appBatterySetPeriod(uint16 period)
     {
         /* Reset the filter data */
         memset(&battery->filter, 0, sizeof(battery->filter));
+        memset(&battery->soc, 0, sizeof(battery->soc));
     }
     else if (battery->period == 0)
     {
@@ -388,9 +783,84 @@ battery_level_state appBatteryGetState(void)
 
 uint8 appBatteryGetPercent(void)
 {
-    uint16 voltage = appBatteryGetVoltage();
+    batteryTaskData *battery = appGetBattery();
+
+    if (battery->soc.valid && !appTestBatteryVoltage)
+    {
+        return battery->soc.charge_uc / (BATTERY_CAPACITY_UC / 100);
+    }
+    return toPercentage(appBatteryGetVoltage());
+}
+
+battery_use_case appBatteryGetUseCase(void)
+{
+    switch (appGetKymera()->state)
+    {
+        case KYMERA_STATE_A2DP_STARTING_A:
+        case KYMERA_STATE_A2DP_STARTING_B:
+        case KYMERA_STATE_A2DP_STARTING_C:
+        case KYMERA_STATE_A2DP_STREAMING:
+            return battery_use_case_a2dp;
+
+        case KYMERA_STATE_A2DP_STREAMING_WITH_FORWARDING:
+            return battery_use_case_a2dp_forwarding;
+
+        case KYMERA_STATE_SCO_ACTIVE:
+        case KYMERA_STATE_SCO_ACTIVE_WITH_FORWARDING:
+        case KYMERA_STATE_SCOFWD_RX_ACTIVE:
+            return battery_use_case_sco;
+
+        case KYMERA_STATE_TONE_PLAYING:
+            return battery_use_case_tone;
+
+        default:
+            return battery_use_case_idle;
+    }
+}
+
+uint16 appBatteryGetRemainingMinutes(battery_use_case use_case)
+{
+    batteryTaskData *battery = appGetBattery();
+    uint32 minutes;
+
+    if (!battery->soc.valid)
+    {
+        return 0;
+    }
+
+    minutes = battery->soc.charge_uc / appBatteryUseCaseCurrent(use_case) / 60;
+    return minutes > 0xFFFF ? 0xFFFF : (uint16)minutes;
+}
+
+void appBatteryMeasurementOpportunity(void)
+{
+    batteryTaskData *battery = appGetBattery();
+    int32 remaining;
+
+    if (battery->period == 0 || !FILTER_IS_FULL(battery))
+    {
+        return;
+    }
+
+    /* Take the next measurement now if it is due within the next half
+       period, saving a dedicated wakeup */
+    remaining = (int32)(battery->next_measurement_ms - VmGetClock());
+    if (remaining <= (int32)battery->period / 2)
+    {
+        if (MessageCancelAll(&battery->task, MESSAGE_BATTERY_INTERNAL_MEASUREMENT_TRIGGER))
+        {
+            battery->wakeups.merged++;
+            appBatteryStartMeasurement(battery);
+        }
+    }
+}
+
+uint32 appBatteryGetWakeupsPerHour(void)
+{
+    batteryTaskData *battery = appGetBattery();
+    uint32 elapsed_s = (VmGetClock() - battery->wakeups.start_ms) / 1000;
 
-    return toPercentage(voltage);
+    return elapsed_s ? (battery->wakeups.count * 3600UL) / elapsed_s : battery->wakeups.count;
 }
 
 bool appBatteryRegister(batteryRegistrationForm *client)
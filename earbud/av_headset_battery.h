@@ -12,6 +12,7 @@
 #define _AV_HEADSET_BATTERY_H_
 
 #include "av_headset.h"
+#include "av_headset_tasklist.h"
 
 /*! The battery filter in this implementation is a power of 2 in length */
 #define BATTERY_FILTER_POWER2 4
@@ -30,7 +31,9 @@ enum battery_messages
     /*! Message signalling the battery percentage has changed. */
     MESSAGE_BATTERY_LEVEL_UPDATE_PERCENT,
     /*! Message signalling the battery state has changed. */
-    MESSAGE_BATTERY_LEVEL_UPDATE_STATE
+    MESSAGE_BATTERY_LEVEL_UPDATE_STATE,
+    /*! Message signalling the estimated remaining runtime has changed. */
+    MESSAGE_BATTERY_LEVEL_UPDATE_RUNTIME
 };
 
 /*! Highest level battery level states */
@@ -51,9 +54,48 @@ enum battery_level_representation
     /*! As a percent */
     battery_level_repres_percent,
     /*! As high-level states */
-    battery_level_repres_state
+    battery_level_repres_state,
+    /*! As estimated remaining runtime per use case */
+    battery_level_repres_runtime
 };
 
+/*! Use cases for which the battery module estimates the load current and
+    remaining runtime. */
+typedef enum
+{
+    /*! No audio activity */
+    battery_use_case_idle,
+    /*! Playing a tone or prompt */
+    battery_use_case_tone,
+    /*! Streaming A2DP locally */
+    battery_use_case_a2dp,
+    /*! Streaming A2DP locally and forwarding to the peer */
+    battery_use_case_a2dp_forwarding,
+    /*! SCO active (locally or forwarded) */
+    battery_use_case_sco,
+    /*! Number of use cases */
+    battery_use_cases
+} battery_use_case;
+
+/*! One point on the battery open circuit voltage (OCV) curve. */
+typedef struct
+{
+    /*! Open circuit voltage in milli-volts */
+    uint16 voltage_mv;
+    /*! State of charge at this voltage in percent */
+    uint8 percent;
+} batteryOcvPoint;
+
+/*! The battery open circuit voltage curve, points must be in ascending
+    voltage order. */
+typedef struct __battery_ocv_curve
+{
+    /*! Number of points in the curve */
+    uint8 num_points;
+    /*! The points */
+    const batteryOcvPoint *points;
+} batteryOcvCurve;
+
 /*! Message #MESSAGE_BATTERY_LEVEL_UPDATE_VOLTAGE content. */
 typedef struct
 {
@@ -75,6 +117,15 @@ typedef struct
     battery_level_state state;
 } MESSAGE_BATTERY_LEVEL_UPDATE_STATE_T;
 
+/*! Message #MESSAGE_BATTERY_LEVEL_UPDATE_RUNTIME content. */
+typedef struct
+{
+    /*! The current use case. */
+    battery_use_case use_case;
+    /*! Estimated remaining runtime in minutes for each use case. */
+    uint16 runtime_mins[battery_use_cases];
+} MESSAGE_BATTERY_LEVEL_UPDATE_RUNTIME_T;
+
 /*! Battery client registration form */
 typedef struct
 {
@@ -86,18 +137,36 @@ typedef struct
           battery_level_repres_voltage: in millivolts
           battery_level_repres_percent: in percent
           battery_level_repres_state: in millivolts
+          battery_level_repres_runtime: in minutes
     */
     uint16 hysteresis;
 
 } batteryRegistrationForm;
 
-/*! Structure used internally to the battery module to store per-client state */
+/*! A range of values, in the units of a representation, within which no
+    notification is required. */
+typedef struct
+{
+    /*! Lowest value that does not require notification */
+    uint16 low;
+    /*! Highest value that does not require notification */
+    uint16 high;
+} batteryBand;
+
+/*! Structure used internally to the battery module to store per-client state.
+    Clients registering identical forms share one entry. */
 typedef struct battery_registered_client_item
 {
     /*! The next client in the list */
     struct battery_registered_client_item *next;
-    /*! The client's registration information */
+    /*! The registration information of the first client with this form */
     batteryRegistrationForm form;
+    /*! The tasks registered with this form */
+    TaskList *tasks;
+    /*! The band of values that do not require a notification */
+    batteryBand band;
+    /*! Set to send a notification on the next reading regardless of band */
+    bool notify_pending;
     /*! The last battery value sent to the client */
     union
     {
@@ -107,6 +176,8 @@ typedef struct battery_registered_client_item
         uint8 percent;
         /*! As a state */
         battery_level_state state;
+        /*! As remaining runtime of the current use case in minutes */
+        uint16 runtime_mins;
     } last;
 } batteryRegisteredClient;
 
@@ -119,30 +190,84 @@ typedef struct
     uint16 period;
     /*! Store the vref measurement, which is required to calculate vbat */
     uint16 vref_raw;
+    /*! The most recent (unfiltered) load compensated reading in mv */
+    uint16 last_reading;
+    /*! VM clock time at which the next measurement is scheduled */
+    uint32 next_measurement_ms;
+    /*! Counters of measurement wakeups */
+    struct
+    {
+        /*! VM clock time the counters were started */
+        uint32 start_ms;
+        /*! Number of times the VM was woken just to take a measurement */
+        uint32 count;
+        /*! Number of measurements merged into another module's wakeup */
+        uint32 merged;
+    } wakeups;
     /*! A sub-struct to allow reset */
     struct
     {
-        /*! Buffer of battery voltages in mv */
+        /*! Buffer of load compensated battery voltages in mv */
         uint16 buf[BATTERY_FILTER_LEN];
         /*! The current index into the filter */
         uint32 index;
         /*! Running sum of the filter buffer */
         uint32 accumulator;
     } filter;
+    /*! State of charge estimator */
+    struct
+    {
+        /*! Estimated remaining charge in micro-coulombs */
+        uint32 charge_uc;
+        /*! Time of the last estimator update (VM clock, ms) */
+        uint32 last_update_ms;
+        /*! Estimated battery current at the last update in micro-amps,
+            positive when discharging */
+        int32 current_ua;
+        /*! Set once the estimator has been seeded from the OCV curve */
+        bool valid;
+    } soc;
     /*! A linked-list of clients */
     batteryRegisteredClient *client_list;
+    /*! The intersection of the bands of all clients, per unit. A reading
+        within these bands requires no client to be notified. */
+    struct
+    {
+        /*! Band in milli-volts, for voltage and state clients */
+        batteryBand voltage;
+        /*! Band in percent */
+        batteryBand percent;
+        /*! Band in minutes */
+        batteryBand runtime;
+    } band;
 } batteryTaskData;
 
 /*! Start monitoring the battery voltage */
 extern void appBatteryInit(void);
 
 /*! @brief Override the default measurement period.
+
+    The period is used when the voltage is near a threshold or the battery
+    is near charge termination. At other times the module measures less
+    often.
+
     @param period The measurement period in milli-seconds.
     Setting to zero stops and resets the monitor, the monitor remains stopped
     until a non-zero value is set.
  */
 extern void appBatterySetPeriod(uint16 period);
 
+/*! @brief Inform the battery module the VM is awake for another reason.
+
+    If the next measurement is due soon it is taken now, so the VM does not
+    need to be woken again just for the measurement.
+*/
+extern void appBatteryMeasurementOpportunity(void);
+
+/*! @brief Get the rate the VM is woken to take battery measurements.
+    @return The number of dedicated measurement wakeups per hour. */
+extern uint32 appBatteryGetWakeupsPerHour(void);
+
 /*! @brief Register to receive battery change notifications.
 
     @note The first notification after registering will only be
@@ -163,15 +288,31 @@ extern bool appBatteryRegister(batteryRegistrationForm *form);
 extern void appBatteryUnregister(Task task);
 
 /*! @brief Read the filtered battery voltage in mV.
+
+    Each reading is compensated for the voltage dropped across the cell's
+    internal resistance by the estimated load current, so the value
+    approximates the open circuit voltage.
+
     @return The battery voltage. */
 extern uint16 appBatteryGetVoltage(void);
 
 /*! @brief Read the battery percent.
-    @return The battery voltage as a percentage. */
+    @return The estimated battery state of charge as a percentage. */
 extern uint8 appBatteryGetPercent(void);
 
 /*! @brief Read the battery state.
     @return The battery state. */
 extern battery_level_state appBatteryGetState(void);
 
+/*! @brief Get the use case the battery module is currently estimating the
+           load for.
+    @return The current use case. */
+extern battery_use_case appBatteryGetUseCase(void);
+
+/*! @brief Estimate the remaining runtime for a use case.
+    @param use_case The use case.
+    @return The estimated runtime in minutes, or zero if the state of charge
+            is not yet known. */
+extern uint16 appBatteryGetRemainingMinutes(battery_use_case use_case);
+
 #endif
@@ -98,9 +98,18 @@ bool appChargerIsConnected(void)
 /* Only compile if CHARGER defined */
 #ifdef INCLUDE_CHARGER
 
-/*! Interval at which the charger status is checked */
+/*! Interval at which the charger status is checked when the battery is
+    near charge termination */
 #define CHARGER_READ_PERIOD (D_SEC(1))
 
+/*! Interval at which the charger status is checked at other times while
+    charging. Charger state changes are also indicated by the firmware. */
+#define CHARGER_READ_PERIOD_SLOW (D_SEC(10))
+
+/*! The battery is considered near charge termination within this many
+    milli-volts of the termination voltage */
+#define CHARGER_TERMINATION_MARGIN_MV (100)
+
 /*! Internal message IDs used by the Charger module */
 enum av_headset_charger_internal_messages
 {
@@ -121,6 +130,14 @@ static  bool appChargerIsCharging(void)
     }
 }
 
+/**************************************************************************/
+static uint32 appChargerGetReadPeriod(void)
+{
+    if (appBatteryGetVoltage() + CHARGER_TERMINATION_MARGIN_MV > appConfigChargerTerminationVoltage())
+        return CHARGER_READ_PERIOD;
+    return CHARGER_READ_PERIOD_SLOW;
+}
+
 /**************************************************************************/
 static void appChargerEvent(void)
 {
@@ -214,7 +231,7 @@ static void appChargerEvent(void)
     if (is_connected && is_charging)
     {
         MessageCancelAll(&theCharger->task, CHARGER_INTERNAL_TIMER);
-        MessageSendLater(&theCharger->task, CHARGER_INTERNAL_TIMER, 0, CHARGER_READ_PERIOD);
+        MessageSendLater(&theCharger->task, CHARGER_INTERNAL_TIMER, 0, appChargerGetReadPeriod());
     }
 }
 
@@ -222,9 +239,16 @@ static void appChargerEvent(void)
 static void appChargerHandleMessage(Task task, MessageId id, Message message)
 {
     UNUSED(task);
-    UNUSED(id);
     UNUSED(message);
 
+    if (id == CHARGER_INTERNAL_TIMER)
+    {
+        appGetCharger()->wakeups++;
+
+        /* Take any battery measurement that is due soon while awake */
+        appBatteryMeasurementOpportunity();
+    }
+
     /* Check for charger events */
     appChargerEvent();
 }
@@ -287,6 +311,8 @@ void appChargerInit(void)
     theCharger->is_connected = FALSE;
     theCharger->is_charging = FALSE;
     theCharger->status = ENABLE_FAIL_UNKNOWN;
+    theCharger->wakeups = 0;
+    theCharger->wakeups_start_ms = VmGetClock();
 
     appChargerConfigureCharger();
 
@@ -322,6 +348,18 @@ bool appChargerClientRegister(Task client_task)
 }
 
 
+uint32 appChargerGetWakeupsPerHour(void)
+{
+#ifdef INCLUDE_CHARGER
+    chargerTaskData *theCharger = appGetCharger();
+    uint32 elapsed_s = (VmGetClock() - theCharger->wakeups_start_ms) / 1000;
+
+    return elapsed_s ? (theCharger->wakeups * 3600UL) / elapsed_s : theCharger->wakeups;
+#else
+    return 0;
+#endif
+}
+
 void appChargerClientUnregister(Task client_task)
 {
 #ifdef INCLUDE_CHARGER
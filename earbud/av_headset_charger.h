@@ -35,6 +35,10 @@ typedef struct
     unsigned is_connected:1;
     /*! The current charger status */
     charger_status status;
+    /*! Number of times the VM was woken to poll the charger */
+    uint32 wakeups;
+    /*! VM clock time the wakeup counter was started */
+    uint32 wakeups_start_ms;
 } chargerTaskData;
 
 extern void appChargerInit(void);
@@ -53,6 +57,10 @@ extern bool appChargerIsConnected(void);
 */
 extern bool appChargerClientRegister(Task client_task);
 
+/*! @brief Get the rate the VM is woken to poll the charger.
+    @return The number of charger poll wakeups per hour. */
+extern uint32 appChargerGetWakeupsPerHour(void);
+
 /*! @brief Unregister a client.
     @param client_task The task to unregister. */
 extern void appChargerClientUnregister(Task client_task);
@@ -14,6 +14,7 @@
 
 #include <message.h>
 #include <panic.h>
+#include <vm.h>
 #include <app/bluestack/dm_prim.h>
 
 /*! @{ Macros to make connection manager messages. */
@@ -35,6 +36,18 @@ static void appConManagerSetLinkSupervisionTimeout(const bdaddr *bd_addr, uint16
 
 static void appConManagerSetDeviceState(conManagerDevice *device, conManagerAclState state)
 {
+    if (state == ACL_CONNECTED && device->state != ACL_CONNECTED)
+    {
+        conManagerTaskData *theConMgr = appGetConManager();
+
+        device->stats.connect_time_ms = VmGetClock();
+
+        /* Start sampling RSSI for link statistics */
+        if (!MessagePendingFirst(&theConMgr->task, CON_MANAGER_INTERNAL_RSSI_SAMPLE, NULL))
+            MessageSendLater(&theConMgr->task, CON_MANAGER_INTERNAL_RSSI_SAMPLE, NULL,
+                             appConfigConManagerRssiSampleMs());
+    }
+
     device->state = state;
     device->lock = (state & ACL_STATE_LOCK);
 
@@ -46,15 +59,53 @@ static void appConManagerSetDeviceState(conManagerDevice *device, conManagerAclS
 static conManagerDevice *appConManagerFindDeviceFromBdAddr(const bdaddr *addr)
 {
     conManagerTaskData *theConMgr = appGetConManager();
+
+    /* Most lookups are for the same device as the last one */
+    if (BdaddrIsSame(&theConMgr->devices[theConMgr->last_index].addr, addr))
+        return &theConMgr->devices[theConMgr->last_index];
+
     for (int i = 0; i < CON_MANAGER_MAX_DEVICES; i++)
     {
         conManagerDevice *device = &theConMgr->devices[i];
         if (BdaddrIsSame(&device->addr, addr))
+        {
+            theConMgr->last_index = i;
             return device;
+        }
     }
     return NULL;
 }
 
+/*! \brief Make the handle for a device table entry.
+
+    The handle holds the table index (plus one, so zero is never a valid
+    handle) and the generation of the entry, so a stale handle to a
+    re-used entry is rejected.
+*/
+static conManagerHandle appConManagerMakeHandle(const conManagerDevice *device)
+{
+    conManagerTaskData *theConMgr = appGetConManager();
+    uint16 index = (uint16)(device - theConMgr->devices);
+
+    return (conManagerHandle)(((uint16)device->generation << 8) | (index + 1));
+}
+
+static conManagerDevice *appConManagerFindDeviceFromHandle(conManagerHandle handle)
+{
+    conManagerTaskData *theConMgr = appGetConManager();
+    uint16 index = (handle & 0xFF) - 1;
+    conManagerDevice *device;
+
+    if (handle == CON_MANAGER_HANDLE_INVALID || index >= CON_MANAGER_MAX_DEVICES)
+        return NULL;
+
+    device = &theConMgr->devices[index];
+    if (BdaddrIsZero(&device->addr) || device->generation != (handle >> 8))
+        return NULL;
+
+    return device;
+}
+
 
 /*! \brief Check if there are any CONNECTED links.
 */
@@ -116,10 +167,24 @@ static conManagerDevice *appConManagerAddDevice(const bdaddr *addr, conManagerAc
             if (BdaddrIsZero(&device->addr))
             {
                 device->addr = *addr;
+                device->generation++;
+                memset(&device->stats, 0, sizeof(device->stats));
                 appConManagerSetDeviceState(device, state);
                 device->users = 0;
                 device->local = is_local;
+                device->page_queued = FALSE;
+                device->paging = FALSE;
                 device->lpState.pt_index = POWERTABLE_UNASSIGNED;
+                device->lpState.traffic = LP_TRAFFIC_NORMAL;
+                device->lpState.applied = LP_TRAFFIC_NORMAL;
+                device->lpState.events = 0;
+                device->lpState.quiet_windows = 0;
+                device->lpState.active = FALSE;
+                device->role_switch.attempts = 0;
+                device->role_switch.failures = 0;
+                device->role_switch.retry_time = 0;
+                device->role_switch.consecutive_failures = 0;
+                device->role_switch.pending = FALSE;
                 return device;
             }
         }
@@ -140,6 +205,8 @@ static bool appConManagerRemoveDevice(const bdaddr *addr)
         appConManagerSetDeviceState(device, ACL_DISCONNECTED);
         BdaddrSetZero(&device->addr);
         device->users = 0;
+        device->page_queued = FALSE;
+        device->paging = FALSE;
         return TRUE;
     }
     else
@@ -161,33 +228,61 @@ void appConManagerSendCloseAclRequest(const bdaddr *addr, bool force)
     VmSendDmPrim(prim);
 }
 
-/* Remove device from the connected devices list. */
-uint16 *appConManagerCreateAcl(const bdaddr *addr)
+/*! \brief Find the page history for a device.
+
+    \param addr    Bluetooth address of the device
+    \param create  TRUE to create a history entry if there isn't one, replacing
+                   the least recently seen device.
+*/
+static conManagerPageHistory *appConManagerGetPageHistory(const bdaddr *addr, bool create)
 {
-    uint16 page_timeout = appConfigDefaultPageTimeout();
+    conManagerTaskData *theConMgr = appGetConManager();
+    conManagerPageHistory *oldest = &theConMgr->page_history[0];
 
-    /* Attempt to find existing device */
-    conManagerDevice *device = appConManagerFindDeviceFromBdAddr(addr);
-    if (device)
+    for (int i = 0; i < CON_MANAGER_MAX_DEVICES; i++)
     {
-        device->users += 1;
-        DEBUG_LOGF("appConManagerCreateAcl, %x,%x,%lx, found device, state %u, lock %u, users %u",
-                   device->addr.nap, device->addr.uap, device->addr.lap,
-                   device->state, device->lock, device->users);
-
-        /* Return pointer to lock, may or may not be set depending on ACL state */
-        return &device->lock;
+        conManagerPageHistory *history = &theConMgr->page_history[i];
+        if (BdaddrIsSame(&history->addr, addr))
+            return history;
+        if (BdaddrIsZero(&history->addr) ||
+            (!BdaddrIsZero(&oldest->addr) &&
+             (int32)(history->last_seen_ms - oldest->last_seen_ms) < 0))
+            oldest = history;
     }
 
-    /* Create new device */
-    device = appConManagerAddDevice(addr, ACL_CONNECTING, TRUE);
-    device->users += 1;
+    if (!create)
+        return NULL;
 
-    DEBUG_LOGF("appConManagerCreateAcl, %x,%x,%lx, create device, state %u, lock %u, users %u",
-               device->addr.nap, device->addr.uap, device->addr.lap,
-               device->state, device->lock, device->users);
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->addr = *addr;
+    oldest->last_seen_ms = VmGetClock();
+    return oldest;
+}
+
+/*! \brief Record that a device has been connected */
+static void appConManagerPageHistorySeen(const bdaddr *addr)
+{
+    appConManagerGetPageHistory(addr, TRUE)->last_seen_ms = VmGetClock();
+}
+
+/*! \brief Check if a device was connected recently enough to be in range */
+static bool appConManagerIsRecentlySeen(const conManagerPageHistory *history)
+{
+    return (VmGetClock() - history->last_seen_ms) < appConfigConManagerRecentlySeenMs();
+}
+
+/*! \brief Get the page timeout to use for a device
+
+    The page timeout depends on the type of device the connection is for,
+    and is halved for each consecutive failed page, down to
+    #appConfigMinPageTimeout, unless the device was seen recently. This
+    stops a device that isn't there holding up the pages of other devices.
+*/
+static uint16 appConManagerGetPageTimeout(const bdaddr *addr)
+{
+    const conManagerPageHistory *history = appConManagerGetPageHistory(addr, FALSE);
+    uint16 page_timeout = appConfigDefaultPageTimeout();
 
-    /* setup page timeout depending on the type of device the connection is for */
     if (appDeviceIsPeer(addr))
     {
         if (appConfigIsLeft())
@@ -199,12 +294,71 @@ uint16 *appConManagerCreateAcl(const bdaddr *addr)
             page_timeout = appConfigRightEarbudPageTimeout();
         }
     }
+
+    if (history && !appConManagerIsRecentlySeen(history))
+    {
+        for (int i = 0; i < history->consecutive_failures && page_timeout > appConfigMinPageTimeout(); i++)
+            page_timeout /= 2;
+        if (page_timeout < appConfigMinPageTimeout())
+            page_timeout = appConfigMinPageTimeout();
+    }
+
+    return page_timeout;
+}
+
+/*! \brief Check if device a should be paged before device b
+
+    Devices seen recently are paged first, then devices with the fewest
+    consecutive failed pages.
+*/
+static bool appConManagerIsBetterPageCandidate(const conManagerDevice *a, const conManagerDevice *b)
+{
+    const conManagerPageHistory *ha = appConManagerGetPageHistory(&a->addr, FALSE);
+    const conManagerPageHistory *hb = appConManagerGetPageHistory(&b->addr, FALSE);
+    bool recent_a = ha && appConManagerIsRecentlySeen(ha);
+    bool recent_b = hb && appConManagerIsRecentlySeen(hb);
+
+    if (recent_a != recent_b)
+        return recent_a;
+
+    return (ha ? ha->consecutive_failures : 0) < (hb ? hb->consecutive_failures : 0);
+}
+
+/*! \brief Page the next queued device, if no page is in progress */
+static void appConManagerPageNext(void)
+{
+    conManagerTaskData *theConMgr = appGetConManager();
+    conManagerDevice *next = NULL;
+    conManagerPageHistory *history;
+
+    for (int i = 0; i < CON_MANAGER_MAX_DEVICES; i++)
+    {
+        conManagerDevice *device = &theConMgr->devices[i];
+        if (device->paging)
+            return;
+        if (device->page_queued &&
+            (!next || appConManagerIsBetterPageCandidate(device, next)))
+            next = device;
+    }
+
+    if (!next)
+        return;
+
+    next->page_queued = FALSE;
+    next->paging = TRUE;
+    history = appConManagerGetPageHistory(&next->addr, TRUE);
+    history->pages++;
+
+    DEBUG_LOGF("appConManagerPageNext, %x,%x,%lx, page timeout %u",
+               next->addr.nap, next->addr.uap, next->addr.lap,
+               appConManagerGetPageTimeout(&next->addr));
+
     /* temporary direct use of DM_PRIMs until connection library API is created.
      * there is an API for page timeout, but we want to ensure it is set before using
      * the DM_ACK_OPEN_REQ. */
     {
         MAKE_PRIM_C(DM_HCI_WRITE_PAGE_TIMEOUT_REQ);
-        prim->page_timeout = page_timeout;
+        prim->page_timeout = appConManagerGetPageTimeout(&next->addr);
         VmSendDmPrim(prim);
     }
     {
@@ -212,9 +366,70 @@ uint16 *appConManagerCreateAcl(const bdaddr *addr)
         MAKE_PRIM_T(DM_ACL_OPEN_REQ);
         prim->addrt.type = TBDADDR_PUBLIC;
         prim->flags = 0;
-        BdaddrConvertVmToBluestack(&prim->addrt.addr, &device->addr);
+        BdaddrConvertVmToBluestack(&prim->addrt.addr, &next->addr);
         VmSendDmPrim(prim);
     }
+}
+
+/*! \brief Record the result of a page and page the next queued device */
+static void appConManagerPageComplete(const bdaddr *addr, bool success)
+{
+    conManagerDevice *device = appConManagerFindDeviceFromBdAddr(addr);
+
+    if (device)
+    {
+        conManagerPageHistory *history = appConManagerGetPageHistory(addr, TRUE);
+
+        if (device->paging)
+        {
+            if (success)
+            {
+                history->consecutive_failures = 0;
+            }
+            else
+            {
+                history->page_failures++;
+                if (history->consecutive_failures < 0xF)
+                    history->consecutive_failures++;
+            }
+        }
+
+        /* An incoming connection also satisfies a queued page */
+        device->paging = FALSE;
+        device->page_queued = FALSE;
+    }
+
+    if (success)
+        appConManagerPageHistorySeen(addr);
+}
+
+/* Remove device from the connected devices list. */
+uint16 *appConManagerCreateAcl(const bdaddr *addr)
+{
+    /* Attempt to find existing device */
+    conManagerDevice *device = appConManagerFindDeviceFromBdAddr(addr);
+    if (device)
+    {
+        device->users += 1;
+        DEBUG_LOGF("appConManagerCreateAcl, %x,%x,%lx, found device, state %u, lock %u, users %u",
+                   device->addr.nap, device->addr.uap, device->addr.lap,
+                   device->state, device->lock, device->users);
+
+        /* Return pointer to lock, may or may not be set depending on ACL state */
+        return &device->lock;
+    }
+
+    /* Create new device */
+    device = appConManagerAddDevice(addr, ACL_CONNECTING, TRUE);
+    device->users += 1;
+
+    DEBUG_LOGF("appConManagerCreateAcl, %x,%x,%lx, create device, state %u, lock %u, users %u",
+               device->addr.nap, device->addr.uap, device->addr.lap,
+               device->state, device->lock, device->users);
+
+    /* Queue the page, it starts now if no other device is being paged */
+    device->page_queued = TRUE;
+    appConManagerPageNext();
 
     /* Return pointer to lock, will always be set */
     return &device->lock;
@@ -235,7 +450,15 @@ void appConManagerReleaseAcl(const bdaddr *addr)
                    device->state, device->lock, device->users);
 
         if (!device->users)
-            appConManagerSendCloseAclRequest(addr, FALSE);
+        {
+            if (device->page_queued)
+            {
+                /* Not paged yet, so no ACL to close */
+                appConManagerRemoveDevice(addr);
+            }
+            else
+                appConManagerSendCloseAclRequest(addr, FALSE);
+        }
     }
 }
 
@@ -271,6 +494,7 @@ static void appHandleClSdpServiceSearchAttributeCfm(conManagerTaskData *theConMg
         uint16 tws_version = DEVICE_TWS_STANDARD;
         appSdpFindTwsVersion(cfm->attributes, cfm->attributes + cfm->size_attributes, &tws_version);
         appDeviceSetTwsVersion(&cfm->bd_addr, tws_version);
+        appDeviceSetSdpTwsVersionCached(&cfm->bd_addr);
 
         DEBUG_LOGF("appHandleClSdpServiceSearchAttributeCfm, TWS+ device %x,%x,%lx, version %d",
                      cfm->bd_addr.nap, cfm->bd_addr.uap, cfm->bd_addr.lap, tws_version);
@@ -283,6 +507,7 @@ static void appHandleClSdpServiceSearchAttributeCfm(conManagerTaskData *theConMg
         /* No response data, so handset doesn't have UUID and/or version attribute, therefore
            treat as standard handset */
         appDeviceSetTwsVersion(&cfm->bd_addr, DEVICE_TWS_STANDARD);
+        appDeviceSetSdpTwsVersionCached(&cfm->bd_addr);
     }
 
     /* Attempt to find existing device */
@@ -304,7 +529,8 @@ static void appHandleClSdpServiceSearchAttributeCfm(conManagerTaskData *theConMg
 /*  ACL opened indication handler
 
     If a new ACL is opened successfully and it is to a handset (where the TWS+
-    version needs to be checked everytime) a service attribute search is started.
+    version needs to be checked) a service attribute search is started, unless
+    a still valid TWS+ version from an earlier search is cached.
 */
 void appConManagerHandleClDmAclOpenedIndication(const CL_DM_ACL_OPENED_IND_T *ind)
 {
@@ -312,6 +538,9 @@ void appConManagerHandleClDmAclOpenedIndication(const CL_DM_ACL_OPENED_IND_T *in
                ind->status, (ind->flags & DM_ACL_FLAG_INCOMING) ? 1 : 0,
                ind->bd_addr.addr.nap, ind->bd_addr.addr.uap, ind->bd_addr.addr.lap);
 
+    if (ind->status != hci_error_max_nr_of_acl)
+        appConManagerPageComplete(&ind->bd_addr.addr, ind->status == hci_success);
+
     if (ind->status == hci_success)
     {        
         const bool is_local = ~ind->flags & DM_ACL_FLAG_INCOMING;
@@ -328,11 +557,21 @@ void appConManagerHandleClDmAclOpenedIndication(const CL_DM_ACL_OPENED_IND_T *in
             DEBUG_LOG("appConManagerHandleClDmAclOpenedIndication, handset");
 
 #ifndef DISABLE_TWS_PLUS
-            /* Add this device to list of connected devices */
-            appConManagerAddDevice(&ind->bd_addr.addr, ACL_CONNECTED_SDP_SEARCH, ~ind->flags & DM_ACL_FLAG_INCOMING);
+            uint16 tws_version;
+            if (appDeviceGetSdpTwsVersion(&ind->bd_addr.addr, &tws_version))
+            {
+                /* TWS version known from an earlier service search, so skip the search */
+                appConManagerAddDevice(&ind->bd_addr.addr, ACL_CONNECTED, ~ind->flags & DM_ACL_FLAG_INCOMING);
+                appConManagerMsgConnectionInd(&ind->bd_addr.addr, TRUE, hci_success);
+            }
+            else
+            {
+                /* Add this device to list of connected devices */
+                appConManagerAddDevice(&ind->bd_addr.addr, ACL_CONNECTED_SDP_SEARCH, ~ind->flags & DM_ACL_FLAG_INCOMING);
 
-            /* Perform service search for TWS+ Source UUID and version attribute */
-            appConManagerQueryHandsetTwsVersion(&ind->bd_addr.addr);
+                /* Perform service search for TWS+ Source UUID and version attribute */
+                appConManagerQueryHandsetTwsVersion(&ind->bd_addr.addr);
+            }
 #else
             /* TWS+ disabled so assume so handset is standard */
             appDeviceSetTwsVersion(&ind->bd_addr.addr, DEVICE_TWS_STANDARD);
@@ -365,6 +604,8 @@ void appConManagerHandleClDmAclOpenedIndication(const CL_DM_ACL_OPENED_IND_T *in
         /* Remove this device from list of connected devices */
         appConManagerRemoveDevice(&ind->bd_addr.addr);
     }
+
+    appConManagerPageNext();
 }
 
 /*! \brief ACL closed indication handler
@@ -378,12 +619,26 @@ void appConManagerHandleClDmAclClosedIndication(const CL_DM_ACL_CLOSED_IND_T *in
         DEBUG_LOG("appConManagerHandleClDmAclClosedIndication, handset");
 
     /* Remove this device from list of connected devices */
+    appConManagerPageHistorySeen(&ind->taddr.addr);
+    if (ind->status == hci_error_conn_timeout)
+        appConManagerGetPageHistory(&ind->taddr.addr, TRUE)->supervision_timeouts++;
     appConManagerRemoveDevice(&ind->taddr.addr);
+    appConManagerPageNext();
 
     /* Indicate to client the connection to this device has gone */
     appConManagerMsgConnectionInd(&ind->taddr.addr, FALSE, ind->status);
 }
 
+/*! \brief Link mode change indication handler
+*/
+void appConManagerHandleClDmModeChangeEvent(const CL_DM_MODE_CHANGE_EVENT_T *evt)
+{
+    conManagerDevice *device = appConManagerFindDeviceFromBdAddr(&evt->bd_addr);
+
+    if (device && evt->mode == lp_sniff)
+        device->stats.sniff_transitions++;
+}
+
 /*! \brief Handle authentication.
  */
 bool appConManagerHandleClSmAuthoriseIndication(const CL_SM_AUTHORISE_IND_T *ind)
@@ -423,6 +678,49 @@ void appConManagerQueryHandsetTwsVersion(const bdaddr *bd_addr)
                                                appSdpGetTwsSourceAttributeSearchRequestSize(), appSdpGetTwsSourceAttributeSearchRequest());
 }
 
+/*! \brief Sample the RSSI of all connected links. */
+static void appConManagerHandleInternalRssiSample(conManagerTaskData *theConMgr)
+{
+    bool connected = FALSE;
+
+    for (int i = 0; i < CON_MANAGER_MAX_DEVICES; i++)
+    {
+        conManagerDevice *device = &theConMgr->devices[i];
+        if (device->state == ACL_CONNECTED)
+        {
+            tp_bdaddr tpaddr;
+
+            tpaddr.transport = TRANSPORT_BREDR_ACL;
+            tpaddr.taddr.type = TYPED_BDADDR_PUBLIC;
+            tpaddr.taddr.addr = device->addr;
+            ConnectionGetRssiBdaddr(&theConMgr->task, &tpaddr);
+            connected = TRUE;
+        }
+    }
+
+    /* Keep sampling while there are links */
+    if (connected)
+        MessageSendLater(&theConMgr->task, CON_MANAGER_INTERNAL_RSSI_SAMPLE, NULL,
+                         appConfigConManagerRssiSampleMs());
+}
+
+/*! \brief Add an RSSI sample to the link statistics. */
+static void appConManagerHandleClDmRssiBdaddrCfm(const CL_DM_RSSI_BDADDR_CFM_T *cfm)
+{
+    conManagerDevice *device = appConManagerFindDeviceFromBdAddr(&cfm->tpaddr.taddr.addr);
+
+    if (device && cfm->status == hci_success)
+    {
+        conManagerLinkStats *stats = &device->stats;
+
+        if (!stats->rssi_samples || cfm->rssi < stats->rssi_min)
+            stats->rssi_min = cfm->rssi;
+        stats->rssi_last = cfm->rssi;
+        stats->rssi_sum += cfm->rssi;
+        stats->rssi_samples++;
+    }
+}
+
 /*! \brief Connection manager message handler.
  */
 static void appConManagerHandleMessage(Task task, MessageId id, Message message)
@@ -435,6 +733,14 @@ static void appConManagerHandleMessage(Task task, MessageId id, Message message)
             appHandleClSdpServiceSearchAttributeCfm(theConMgr, (CL_SDP_SERVICE_SEARCH_ATTRIBUTE_CFM_T *)message);
             return;
 
+        case CL_DM_RSSI_BDADDR_CFM:
+            appConManagerHandleClDmRssiBdaddrCfm((const CL_DM_RSSI_BDADDR_CFM_T *)message);
+            return;
+
+        case CON_MANAGER_INTERNAL_RSSI_SAMPLE:
+            appConManagerHandleInternalRssiSample(theConMgr);
+            return;
+
         /* TODO needed? */
         case PAIRING_HANDSET_PAIR_CFM:
             return;
@@ -486,6 +792,76 @@ void appConManagerRegisterConnectionsClient(Task client_task)
     appTaskListAddTask(theConMgr->connection_client_tasks, client_task);
 }
 
+/*! \brief Get the handle of a device. */
+conManagerHandle appConManagerGetHandle(const bdaddr *addr)
+{
+    const conManagerDevice *device = appConManagerFindDeviceFromBdAddr(addr);
+    return device ? appConManagerMakeHandle(device) : CON_MANAGER_HANDLE_INVALID;
+}
+
+/*! \brief Get the Bluetooth address of a device, by handle. */
+bool appConManagerGetBdAddrByHandle(conManagerHandle handle, bdaddr *addr)
+{
+    const conManagerDevice *device = appConManagerFindDeviceFromHandle(handle);
+    if (device)
+    {
+        *addr = device->addr;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/*! \brief Query if a device is currently connected, by handle. */
+bool appConManagerIsConnectedByHandle(conManagerHandle handle)
+{
+    const conManagerDevice *device = appConManagerFindDeviceFromHandle(handle);
+    return device ? device->state == ACL_CONNECTED : FALSE;
+}
+
+/*! \brief Set the link policy per-connection state, by handle. */
+void appConManagerSetLpStateByHandle(conManagerHandle handle, const lpPerConnectionState *lpState)
+{
+    conManagerDevice *device = appConManagerFindDeviceFromHandle(handle);
+    if (device)
+    {
+        device->lpState = *lpState;
+    }
+}
+
+/*! \brief Get the link policy per-connection state, by handle. */
+void appConManagerGetLpStateByHandle(conManagerHandle handle, lpPerConnectionState *lpState)
+{
+    const conManagerDevice *device = appConManagerFindDeviceFromHandle(handle);
+    if (device)
+    {
+        *lpState = device->lpState;
+    }
+}
+
+/*! \brief Get the statistics for the ACL to a device. */
+bool appConManagerGetLinkStats(const bdaddr *addr, conManagerLinkStats *stats,
+                               uint16 *supervision_timeouts)
+{
+    const conManagerDevice *device = appConManagerFindDeviceFromBdAddr(addr);
+    const conManagerPageHistory *history = appConManagerGetPageHistory(addr, FALSE);
+
+    *supervision_timeouts = history ? history->supervision_timeouts : 0;
+    if (device)
+    {
+        *stats = device->stats;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/*! \brief Record a role change on the ACL to a device. */
+void appConManagerLinkStatsRoleChanged(const bdaddr *addr)
+{
+    conManagerDevice *device = appConManagerFindDeviceFromBdAddr(addr);
+    if (device)
+        device->stats.role_changes++;
+}
+
 /*! \brief Set the link policy per-connection state. */
 void appConManagerSetLpState(const bdaddr *addr, const lpPerConnectionState *lpState)
 {
@@ -506,6 +882,105 @@ void appConManagerGetLpState(const bdaddr *addr, lpPerConnectionState *lpState)
     }
 }
 
+/*! \brief Record that a role switch has been requested. */
+void appConManagerRoleSwitchRequested(const bdaddr *addr, hci_role role)
+{
+    conManagerDevice *device = appConManagerFindDeviceFromBdAddr(addr);
+    if (device)
+    {
+        device->role_switch.attempts++;
+        device->role_switch.pending = TRUE;
+        device->role_switch.requested_role = role;
+    }
+}
+
+/*! \brief Record the outcome of a role switch. */
+bool appConManagerRoleSwitchComplete(const bdaddr *addr, hci_role role, bool success)
+{
+    conManagerDevice *device = appConManagerFindDeviceFromBdAddr(addr);
+    conManagerRoleSwitchHistory *history;
+    uint32 backoff_ms;
+
+    if (!device || !device->role_switch.pending)
+        return FALSE;
+
+    /* Answer to a role query, the role switch is still in progress */
+    if (success && (role != device->role_switch.requested_role))
+        return FALSE;
+
+    history = &device->role_switch;
+    history->pending = FALSE;
+    if (success)
+    {
+        history->consecutive_failures = 0;
+        history->retry_time = VmGetClock();
+        return TRUE;
+    }
+
+    history->failures++;
+    if (history->consecutive_failures < 0xF)
+        history->consecutive_failures++;
+
+    /* Double the delay on each consecutive failure */
+    backoff_ms = appConfigRoleSwitchBackoffMinMs();
+    for (int i = 1; i < history->consecutive_failures && backoff_ms < appConfigRoleSwitchBackoffMaxMs(); i++)
+        backoff_ms *= 2;
+    if (backoff_ms > appConfigRoleSwitchBackoffMaxMs())
+        backoff_ms = appConfigRoleSwitchBackoffMaxMs();
+    history->retry_time = VmGetClock() + backoff_ms;
+
+    DEBUG_LOGF("appConManagerRoleSwitchComplete, failures %u, backoff %lu",
+               history->failures, backoff_ms);
+    return TRUE;
+}
+
+/*! \brief Check if a role switch may be requested. */
+bool appConManagerIsRoleSwitchAllowed(const bdaddr *addr, uint32 *delay_ms)
+{
+    conManagerDevice *device = appConManagerFindDeviceFromBdAddr(addr);
+    int32 remaining;
+
+    *delay_ms = 0;
+    if (!device)
+        return FALSE;
+    if (device->role_switch.pending)
+        return FALSE;
+
+    remaining = (int32)(device->role_switch.retry_time - VmGetClock());
+    if (device->role_switch.consecutive_failures && remaining > 0)
+    {
+        *delay_ms = (uint32)remaining;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*! \brief Get the role switch counters. */
+bool appConManagerGetRoleSwitchCounts(const bdaddr *addr, uint16 *attempts, uint16 *failures)
+{
+    conManagerDevice *device = appConManagerFindDeviceFromBdAddr(addr);
+    if (device)
+    {
+        *attempts = device->role_switch.attempts;
+        *failures = device->role_switch.failures;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/*! \brief Get the page counters for a device. */
+bool appConManagerGetPageCounts(const bdaddr *addr, uint16 *pages, uint16 *failures)
+{
+    const conManagerPageHistory *history = appConManagerGetPageHistory(addr, FALSE);
+    if (history)
+    {
+        *pages = history->pages;
+        *failures = history->page_failures;
+        return TRUE;
+    }
+    return FALSE;
+}
+
 /*! \brief Control if handset connections are allowed. */
 void appConManagerAllowHandsetConnect(bool allowed)
 {
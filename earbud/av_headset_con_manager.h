@@ -21,6 +21,15 @@
  * status for. */
 #define CON_MANAGER_MAX_DEVICES 4
 
+/*! Handle for a device in the connection manager device table. Handles
+    give direct access to the device, and become invalid when the ACL to
+    the device is closed. Profiles cache the handle of their link when they
+    connect, headers included before this one store it as a uint16. */
+typedef uint16 conManagerHandle;
+
+/*! Value of a handle that does not refer to any device */
+#define CON_MANAGER_HANDLE_INVALID (0)
+
 /*! Flag used on ACL states to indicate if the state represents an activity
     that will finish. */
 #define ACL_STATE_LOCK (0x04)
@@ -38,6 +47,43 @@ typedef enum
     ACL_DISCONNECTED         = 3,
 } conManagerAclState;
 
+/*! Role switch history for a single device, used by the link policy
+    manager to back off from devices that refuse role switches. */
+typedef struct
+{
+        /*! Number of role switches requested on the ACL */
+    uint16 attempts;
+        /*! Number of role switches that failed */
+    uint16 failures;
+        /*! Time (VmGetClock) before which no further role switch should be requested */
+    uint32 retry_time;
+        /*! Number of consecutive failures, used to scale the backoff */
+    unsigned consecutive_failures:4;
+        /*! Flag that indicates a role switch has been requested and not confirmed */
+    bool pending:1;
+        /*! Role (#hci_role) requested by the pending role switch */
+    unsigned requested_role:2;
+} conManagerRoleSwitchHistory;
+
+/*! Statistics for a single ACL, used to tune link policy. */
+typedef struct
+{
+        /*! Time (VmGetClock) the ACL was connected */
+    uint32 connect_time_ms;
+        /*! Sum of RSSI samples, used to calculate the average */
+    int32 rssi_sum;
+        /*! Number of RSSI samples */
+    uint16 rssi_samples;
+        /*! Most recent RSSI sample */
+    int8 rssi_last;
+        /*! Lowest RSSI sample */
+    int8 rssi_min;
+        /*! Number of role changes */
+    uint16 role_changes;
+        /*! Number of times the link has entered sniff mode */
+    uint16 sniff_transitions;
+} conManagerLinkStats;
+
 /*! Structure used to hold information about a single device, managed by
     the connection manager. 
     This structure should not be accessed directly.
@@ -57,10 +103,38 @@ typedef struct
     unsigned users:4;
         /*! Flag that indicates if this is an incoming ACL */
     bool local:1;
+        /*! Flag that indicates the ACL is waiting for its turn to be paged */
+    bool page_queued:1;
+        /*! Flag that indicates the device is being paged */
+    bool paging:1;
         /*! The current link policy for this connection */
     lpPerConnectionState lpState;
+        /*! Role switch history for this connection */
+    conManagerRoleSwitchHistory role_switch;
+        /*! Statistics for this connection */
+    conManagerLinkStats stats;
+        /*! Generation of the table entry, part of the device handle */
+    uint8 generation;
 } conManagerDevice;
 
+/*! Page history for a single device, kept after the ACL has closed so
+    the page budget can be based on how likely the device is to answer. */
+typedef struct
+{
+        /*! Bluetooth address of the device */
+    bdaddr addr;
+        /*! Time (VmGetClock) the device was last connected */
+    uint32 last_seen_ms;
+        /*! Number of times the device has been paged */
+    uint16 pages;
+        /*! Number of pages that failed */
+    uint16 page_failures;
+        /*! Number of consecutive pages that failed */
+    unsigned consecutive_failures:4;
+        /*! Number of times the ACL to the device was lost to a supervision timeout */
+    uint16 supervision_timeouts;
+} conManagerPageHistory;
+
 /*! Connection Manager module task data. */
 typedef struct
 {
@@ -74,14 +148,27 @@ typedef struct
     /*! List of devices which are currently connected. */
     conManagerDevice devices[CON_MANAGER_MAX_DEVICES];
 
+    /*! Page history of recently connected devices. */
+    conManagerPageHistory page_history[CON_MANAGER_MAX_DEVICES];
+
     /*! Lock to control handling of internal messages pending other activities
      * completing */
     uint16 lock;
 
+    /*! Index of the device found by the last address lookup */
+    uint8 last_index;
+
     /*! Flag indicating if incoming handset connections are allowed */
     bool handset_connect_allowed:1;
 } conManagerTaskData;
 
+/*! \brief Connection manager internal messages. */
+enum
+{
+        /*! Time to sample the RSSI of connected links */
+    CON_MANAGER_INTERNAL_RSSI_SAMPLE = INTERNAL_MESSAGE_BASE,
+};
+
 /*! \brief Message IDs for connection manager messages to other tasks. */
 enum    av_headset_conn_manager_messages
 {
@@ -114,6 +201,11 @@ extern void appConManagerInit(void);
     If the ACL doens't exist then this function will request Bluestack to open
     an ACL.
 
+    Only one device is paged at a time, so the page timeout applies to the
+    correct device. Other devices are queued and paged in order of how
+    likely they are to answer. The page timeout for each device is reduced
+    after consecutive failed pages, unless the device was seen recently.
+
     \param addr [IN] Pointer to a BT address.
 
     \return uint16 Pointer to lock that will be cleared when ACL is available, or paging failed.
@@ -154,6 +246,12 @@ extern void appConManagerHandleClDmAclOpenedIndication(const CL_DM_ACL_OPENED_IN
 */
 extern void appConManagerHandleClDmAclClosedIndication(const CL_DM_ACL_CLOSED_IND_T *ind);
 
+/*! \brief Link mode change indication handler
+
+    \param[in] evt  Pointer to the received connection library event.
+*/
+extern void appConManagerHandleClDmModeChangeEvent(const CL_DM_MODE_CHANGE_EVENT_T *evt);
+
 /*! \brief Handle authentication.
 
     \param[in] ind  Pointer to the received connection library indication.
@@ -193,6 +291,64 @@ extern bool appConManagerIsConnected(const bdaddr *addr);
  */
 extern bool appConManagerIsAclLocal(const bdaddr *addr);
 
+/*! \brief Get the handle of a device.
+
+    \param addr [IN] Pointer to a BT address.
+
+    \return conManagerHandle Handle of the device, #CON_MANAGER_HANDLE_INVALID
+            if there is no ACL to the device.
+*/
+extern conManagerHandle appConManagerGetHandle(const bdaddr *addr);
+
+/*! \brief Get the Bluetooth address of a device, by handle.
+
+    \param handle [IN] Handle of the device.
+    \param addr [OUT] Bluetooth address of the device.
+
+    \return bool TRUE if the handle refers to a device, FALSE otherwise.
+*/
+extern bool appConManagerGetBdAddrByHandle(conManagerHandle handle, bdaddr *addr);
+
+/*! \brief Query if a device is currently connected, by handle.
+
+    \param handle [IN] Handle of the device.
+
+    \return bool TRUE device is connected, FALSE device is not connected.
+*/
+extern bool appConManagerIsConnectedByHandle(conManagerHandle handle);
+
+/*! \brief Set the link policy per-connection state, by handle.
+
+    \param handle [IN] Handle of the device.
+    \param lpState [IN] Address of state to store.
+*/
+extern void appConManagerSetLpStateByHandle(conManagerHandle handle, const lpPerConnectionState *lpState);
+
+/*! \brief Get the link policy per-connection state, by handle.
+
+    \param handle [IN] Handle of the device.
+    \param lpState [OUT] Address of state to update with retrieved state.
+*/
+extern void appConManagerGetLpStateByHandle(conManagerHandle handle, lpPerConnectionState *lpState);
+
+/*! \brief Get the statistics for the ACL to a device.
+
+    \param addr [IN] Pointer to a BT address.
+    \param stats [OUT] Address of statistics to update.
+    \param supervision_timeouts [OUT] Number of ACLs to the device lost to
+                                      a supervision timeout.
+
+    \return bool TRUE if there is an ACL to the device.
+*/
+extern bool appConManagerGetLinkStats(const bdaddr *addr, conManagerLinkStats *stats,
+                                      uint16 *supervision_timeouts);
+
+/*! \brief Record a role change on the ACL to a device.
+
+    \param addr [IN] Pointer to a BT address.
+*/
+extern void appConManagerLinkStatsRoleChanged(const bdaddr *addr);
+
 /*! \brief Set the link policy per-connection state.
 
     \param addr [IN] Pointer to a BT address.
@@ -207,6 +363,60 @@ extern void appConManagerSetLpState(const bdaddr *addr, const lpPerConnectionSta
 */
 extern void appConManagerGetLpState(const bdaddr *addr, lpPerConnectionState *lpState);
 
+/*! \brief Record that a role switch has been requested on the ACL to a device.
+
+    \param addr [IN] Pointer to a BT address.
+    \param role [IN] Role requested.
+*/
+extern void appConManagerRoleSwitchRequested(const bdaddr *addr, hci_role role);
+
+/*! \brief Record the outcome of a role switch on the ACL to a device.
+
+    A failed role switch delays the next attempt, with the delay doubling
+    on each consecutive failure up to #appConfigRoleSwitchBackoffMaxMs.
+
+    Role confirmations also answer role queries, a successful confirmation
+    is only the outcome of the pending role switch if it reports the role
+    requested.
+
+    \param addr [IN] Pointer to a BT address.
+    \param role [IN] Role reported by the confirmation.
+    \param success [IN] TRUE if the confirmation was successful.
+
+    \return bool TRUE if the confirmation was the outcome of a pending role switch.
+*/
+extern bool appConManagerRoleSwitchComplete(const bdaddr *addr, hci_role role, bool success);
+
+/*! \brief Check if a role switch may be requested on the ACL to a device.
+
+    \param addr [IN] Pointer to a BT address.
+    \param delay_ms [OUT] Time remaining before a role switch is allowed, if
+                          backing off after failures.
+
+    \return bool TRUE if a role switch may be requested now.
+*/
+extern bool appConManagerIsRoleSwitchAllowed(const bdaddr *addr, uint32 *delay_ms);
+
+/*! \brief Get the role switch counters for the ACL to a device.
+
+    \param addr [IN] Pointer to a BT address.
+    \param attempts [OUT] Number of role switches requested.
+    \param failures [OUT] Number of role switches that failed.
+
+    \return bool TRUE if the device is known to the connection manager.
+*/
+extern bool appConManagerGetRoleSwitchCounts(const bdaddr *addr, uint16 *attempts, uint16 *failures);
+
+/*! \brief Get the page counters for a device.
+
+    \param addr [IN] Pointer to a BT address.
+    \param pages [OUT] Number of times the device has been paged.
+    \param failures [OUT] Number of pages that failed.
+
+    \return bool TRUE if the device has a page history.
+*/
+extern bool appConManagerGetPageCounts(const bdaddr *addr, uint16 *pages, uint16 *failures);
+
 /*! \brief Manually close the ACL to a device.
 
     \param addr [IN] Pointer to a BT address.
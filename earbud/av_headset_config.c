@@ -8,6 +8,28 @@
 */
 
 #include "av_headset_config.h"
+#include "av_headset_battery.h"
+
+/*! Open circuit voltage curve for a typical single Li-ion earbud cell */
+static const batteryOcvPoint battery_ocv_points[] = {
+    {3000,   0},
+    {3450,   5},
+    {3600,  10},
+    {3680,  20},
+    {3730,  30},
+    {3770,  40},
+    {3810,  50},
+    {3860,  60},
+    {3930,  70},
+    {4000,  80},
+    {4080,  90},
+    {4200, 100},
+};
+
+const struct __battery_ocv_curve battery_ocv_curve = {
+    .num_points = sizeof(battery_ocv_points) / sizeof(battery_ocv_points[0]),
+    .points = battery_ocv_points,
+};
 
 #if defined(INCLUDE_PROXIMITY)
 #if   defined(HAVE_VNCL3020)
@@ -18,6 +40,10 @@ const struct __proximity_config proximity_config = {
     .threshold_high = 3500,
     .threshold_counts = vncl3020_threshold_count_4,
     .rate = vncl3020_proximity_rate_7p8125_per_second,
+    .rate_rest = vncl3020_proximity_rate_1p95_per_second,
+    .rate_motion = vncl3020_proximity_rate_16p625_per_second,
+    .baseline = 2500,
+    .max_calibration_offset = 400,
     .i2c_clock_khz = 100,
     .pios = {
         /* The PROXIMITY_PIO definitions are defined in the platform x2p file */
@@ -13,6 +13,21 @@
 /*! Time to wait before powering off when idle */
 #define APP_AUTO_POWER_OFF_TIMEOUT      (300)
 
+/*! Energy cost of a dormant-then-wake cycle (reboot, initialisation and
+    reconnection), expressed as seconds of idle current */
+#define appConfigPowerDormantWakeCostSecs()         (20)
+
+/*! Time to wait before entering dormant when idle, in contexts where
+    idle periods are typically long enough to be worth entering dormant */
+#define appConfigPowerIdlePredictiveTimeoutSecs()   (30)
+
+/*! Interval to re-check idle power down whilst it is blocked */
+#define appConfigPowerIdleRecheckSecs()             (30)
+
+/*! Length of idle period assumed for a wake from dormant, as the
+    time spent in dormant cannot be measured */
+#define appConfigPowerDormantAssumedIdleSecs()      (1800)
+
 /*! Delay power off slightly for UI tones to complete */
 #define APP_POWER_OFF_WAIT_MS           (D_SEC(1))
 
@@ -52,6 +67,17 @@
 /*! Default microphone gain */
 #define HFP_MICROPHONE_GAIN (15)
 
+/*! Time to wait for the AG to confirm an HFP AT command before sending the next (in milliseconds) */
+#define appConfigHfpAtCmdTimeoutMs()        (5000)
+
+/*! Time after an HFP AT command times out beyond which its confirmation is
+    assumed lost rather than late (in milliseconds) */
+#define appConfigHfpAtCmdStaleMs()          (10000)
+
+/*! Minimum interval between HFP gain synchronisation commands, so repeated
+    volume changes are merged (in milliseconds) */
+#define appConfigHfpAtCmdGainIntervalMs()   (200)
+
 /*! Auto connect HFP on power up */
 #define AUTO_CONNECT_HFP
 
@@ -101,6 +127,18 @@
 /*! Timeout in seconds for automatic handset pairing */
 #define appConfigAutoHandsetPairingTimeout()    (300)
 
+/*! Length of a peer pairing inquiry, in units of 1.28 seconds */
+#define appConfigPeerPairingInquiryTimeout()    (5)
+/*! Minimum time in milliseconds to collect inquiry results before a peer
+    can be selected without waiting for the inquiry to complete */
+#define appConfigPeerPairingMinWindowMs()       (1500)
+/*! Score added to a peer candidate advertising that it is unpaired or was
+    paired with this earbud */
+#define appConfigPeerPairingEirBonus()          (6)
+/*! Nonce carried in EIR during peer pairing, earbuds with the same nonce are
+    preferred over all others. Zero disables the nonce. */
+#define appConfigPeerPairingNonce()             (0x0000U)
+
 /*! Qualcomm Bluetooth SIG company ID */
 #define appConfigBtSigCompanyId() (0x00AU)
 /*! Qualcomm IEEE company ID */
@@ -179,12 +217,55 @@
 /*! Page timeout to use for connecting to any non-peer earbud devices. */
 #define appConfigDefaultPageTimeout()       (0x4000)
 
+/*! Interval between RSSI samples of connected links, for link statistics (in milliseconds) */
+#define appConfigConManagerRssiSampleMs()   (60000)
+
+/*! Shortest page timeout used for a device after consecutive failed pages. */
+#define appConfigMinPageTimeout()           (0x0800)
+
+/*! Time since a device was last connected for which it is still expected
+    to be in range, and is paged with its full page timeout (in milliseconds) */
+#define appConfigConManagerRecentlySeenMs() (600000)
+
 /*! Inactivity timeout after which peer signalling channel will be disconnected, 0 to leave connected (in sniff) */
 #define appConfigPeerSignallingChannelTimeoutSecs()   (0)
 
+/*! Time spent at each slow page scan decay level before moving to a lower duty cycle (in milliseconds) */
+#define appConfigScanManagerDecayStepMs()   (60000)
+
+/*! Time slow page scan uses fast parameters after an event that predicts an incoming connection (in milliseconds) */
+#define appConfigScanManagerBoostMs()       (10000)
+
+/*! Version of the local SDP records, sent to the peer earbud as a hint so it
+    can invalidate its cached service search results.  Must be changed whenever
+    a firmware change alters the SDP records. */
+#define appConfigSdpRecordsVersion()        (1)
+
+/*! Number of connections a cached handset TWS version is used for before the
+    service search is repeated to refresh it. */
+#define appConfigSdpCacheMaxUses()          (8)
+
 /*! Default link supervision timeout for all ACLs (in milliseconds) */
 #define appConfigDefaultLinkSupervisionTimeout()  (5000)
 
+/*! Delay before retrying a role switch after a failure (in milliseconds), doubled on each consecutive failure */
+#define appConfigRoleSwitchBackoffMinMs()   (1000)
+
+/*! Maximum delay before retrying a role switch after failures (in milliseconds) */
+#define appConfigRoleSwitchBackoffMaxMs()   (60000)
+
+/*! Delay before re-checking link roles when a role switch was deferred by audio activity (in milliseconds) */
+#define appConfigRoleSwitchDeferMs()        (5000)
+
+/*! Period over which link traffic is counted to adapt sniff parameters (in milliseconds) */
+#define appConfigLinkPolicyTrafficWindowMs()    (1000)
+
+/*! Number of activity events within a traffic window that is treated as a burst */
+#define appConfigLinkPolicyTrafficBurstEvents() (3)
+
+/*! Number of traffic windows without activity before backing off to a longer sniff interval */
+#define appConfigLinkPolicyTrafficQuietWindows()    (5)
+
 /*! Minimum volume gain in dB */
 #define appConfigMinVolumedB() (-45)
 
@@ -241,6 +322,62 @@
 /*! The last time before the TTP at which a packet may be transmitted */
 #define appConfigTwsDeadline()      (50000UL)
 
+/*! Interval at which the TWS slave reports the quality of the peer link to
+    the master while receiving forwarded A2DP. Set to 0 to disable reports,
+    the master then always forwards with normal quality. */
+#define appConfigTwsForwardingReportMs()        D_SEC(1)
+
+/*! Average peer link RSSI reported by the slave below which the master
+    forwards A2DP with robust settings */
+#define appConfigTwsForwardingRobustRssi()      (-75)
+
+/*! Increase in reported RSSI above appConfigTwsForwardingRobustRssi() needed
+    to return to normal forwarding */
+#define appConfigTwsForwardingRobustHysteresis() (6)
+
+/*! Maximum SBC bitpool when forwarding with robust settings */
+#define appConfigTwsRobustBitpool()             (24)
+
+/*! Maximum forwarding packet size when forwarding with robust settings, fewer
+    frames per packet means less audio lost with each packet. 367 octets fit
+    a 2-DH3 packet. */
+#define appConfigTwsRobustMtu()                 (367)
+
+/*! The time before the TTP at which a packet should be transmitted when
+    forwarding with robust settings, must be less than the TTP latency */
+#define appConfigTwsRobustTimeBeforeTx()        (150000UL)
+
+/*! The last time before the TTP at which a packet may be transmitted when
+    forwarding with robust settings */
+#define appConfigTwsRobustDeadline()            (40000UL)
+
+/*! Accept a handset's A2DP media start without waiting for the peer earbud to
+    sync. Forwarding to the peer joins once its media channel has started, the
+    packetiser's time to play keeps both earbuds aligned. */
+#define appConfigA2dpStartResponseFirst()   (FALSE)
+
+/*! Open the media channel to a handset with the SEID it last accepted,
+    instead of discovering and negotiating all endpoints again. */
+#define appConfigA2dpSeidCacheEnabled()     (TRUE)
+
+/*! Time a handset may stream with playback paused or stopped (as reported by
+    AVRCP play status) before the stream is suspended to save power, the DSP,
+    forwarding to the peer and the streaming link policy are stopped with it.
+    Silence is only inferred from the play status, media data isn't seen by
+    the application as it is routed directly to the DSP, so a handset that
+    streams other audio (e.g. a game) after pausing playback would be
+    suspended. Disabled (0) by default, set a time to opt in, e.g. D_SEC(10). */
+#define appConfigA2dpSilenceSuspendMs()     (0)
+
+/*! Streams from a handset are played with robust output latency once this
+    many recent streams needed robust forwarding to the peer. Each stream
+    that did increments the handset's count, each stream that did not
+    decrements it. */
+#define appConfigA2dpRobustLatencyCongestion()  (3)
+
+/*! Maximum count of recent streams that needed robust forwarding */
+#define appConfigA2dpCongestionMax()        (6)
+
 /*! Charger configuration */
 
 /*! The time to debounce charger state changes */
@@ -282,6 +419,26 @@
     the level has changed. Units of milli-volts */
 #define appConfigSmBatteryHysteresisMargin() (50)
 
+/*! Nominal battery capacity in milli-amp hours */
+#define appConfigBatteryCapacityMah()               (60)
+
+/*! Battery internal resistance in milli-ohms, used to compensate voltage
+    readings for the drop caused by the load current */
+#define appConfigBatteryInternalResistanceMilliOhm() (600)
+
+//!@{ @name Estimated average battery current per use case in micro-amps
+#define appConfigBatteryCurrentIdleUa()             (1500)
+#define appConfigBatteryCurrentToneUa()             (5000)
+#define appConfigBatteryCurrentA2dpUa()             (8000)
+#define appConfigBatteryCurrentA2dpForwardingUa()   (11000)
+#define appConfigBatteryCurrentScoUa()              (10000)
+//!@}
+
+/*! The battery open circuit voltage curve */
+extern const struct __battery_ocv_curve battery_ocv_curve;
+/*! Returns the battery open circuit voltage curve */
+#define appConfigBatteryOcvCurve() (&battery_ocv_curve)
+
 
 /*! Define which channel the 'left' audio channel comes out of. */
 #define appConfigLeftAudioChannel()              (AUDIO_CHANNEL_A)
@@ -289,6 +446,15 @@
 /*! Define which audio instance is used for microphone */
 #define appConfigMicAudioInstance()              (AUDIO_INSTANCE_0)
 
+/*! Minimum interval between gain updates to the volume operator (in milliseconds).
+    Volume changes within the interval are merged, the operator ramps to the
+    latest volume. */
+#define appConfigVolumeUpdateIntervalMs()       (50)
+
+/*! Minimum interval between AVRCP volume commands or notifications to each
+    handset and peer (in milliseconds). Only the latest volume is sent. */
+#define appConfigVolumeNotifyIntervalMs()       (200)
+
 /*! Define whether audio should start with or without a soft volume ramp */
 #define appConfigEnableSoftVolumeRampOnStart() (FALSE)
 
@@ -338,10 +504,38 @@
 /*! Timeout for SCO audio when earbud removed from ear. */
 #define appConfigOutOfEarScoTimeoutSecs()      (2)
 
+/*!@{ @name Physical state sensor fusion
+      @brief The proximity, motion and charger states are combined into a
+             confidence that the earbud is in the ear (0-100). The in ear
+             state is only changed when the confidence has been above (or
+             below) the threshold for the dwell time.
+
+             Proximity alone reaches the in ear threshold, so a worn earbud
+             that is still is in the ear. Motion alone doesn't. Whilst the
+             earbud is moving, as it is when put in or taken out, the dwell
+             time is scaled by appConfigPhyStateMotionDwellPercent(), so
+             a change whilst still must be held for longer.
+*/
+#define appConfigPhyStateProximityConfidence()  (75)
+#define appConfigPhyStateMotionConfidence()     (25)
+#define appConfigPhyStateInEarThreshold()       (75)
+#define appConfigPhyStateOutOfEarThreshold()    (25)
+#define appConfigPhyStateInEarDwellMs()         (400)
+#define appConfigPhyStateOutOfEarDwellMs()      (1000)
+#define appConfigPhyStateMotionDwellPercent()   (50)
+//!@}
+
 /*! Time to wait to connect AVRCP after a remotely initiated A2DP connection
-    indication if the remote device does not initiate a AVRCP connection */
+    indication if the remote device does not initiate a AVRCP connection.
+    Only used for handsets that have failed an AVRCP connection made without
+    the delay. */
 #define appConfigAvrcpConnectDelayAfterRemoteA2dpConnectMs() D_SEC(3)
 
+/*! Number of delayed AVRCP connections to a handset that rejected an early
+    connection before AVRCP is connected without the delay again, in case
+    the rejection was a one off. */
+#define appConfigAvrcpConnectDelayRetryCount() (5)
+
 /*! Time to wait to connect A2DP media channel after a locally initiated A2DP connection */
 #define appConfigA2dpMediaConnectDelayAfterLocalA2dpConnectMs() D_SEC(3)
 
@@ -358,6 +552,15 @@
     If FALSE, it will transcode one channel to SBC mono and forward. */
 #define appConfigAACStereoForwarding() TRUE
 
+/*! Peer link RSSI (dBm) below which the TWS standard master forwards AAC by
+    transcoding to SBC mono instead of passing stereo AAC through, reducing
+    airtime on a weak link. Only used if appConfigAACStereoForwarding() is TRUE. */
+#define appConfigAacForwardingSwitchRssi()      (-72)
+
+/*! Margin (dB) above appConfigAacForwardingSwitchRssi() the peer link RSSI
+    must reach before AAC passthrough forwarding is used again. */
+#define appConfigAacForwardingSwitchHysteresis() (6)
+
 #if defined(INCLUDE_PROXIMITY)
 #include "av_headset_proximity.h"
 /*! The proximity sensor configuration */
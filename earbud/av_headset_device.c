@@ -26,6 +26,53 @@
 #define COPY_DEVICE_MESSAGE(src, dst) *(dst) = *(src);
 
 
+/*! \brief Set fields added since the stored version of the attributes to their defaults. */
+static void appDeviceUpgradeAttributes(appDeviceAttributes *attributes)
+{
+    if (attributes->dev_info_version < 2)
+    {
+        attributes->sdp_cache_uses = 0;
+        attributes->sdp_scofwd_psm = 0;
+        attributes->sdp_records_version = 0;
+        attributes->a2dp_cached_seid = 0;
+        attributes->a2dp_caps_version = 0;
+        attributes->a2dp_low_latency = FALSE;
+        attributes->a2dp_congestion = 0;
+        attributes->avrcp_delayed_connects = 0;
+    }
+    attributes->dev_info_version = DEVICE_ATTRIBUTES_VERSION;
+}
+
+/*! \brief Read the attributes of a device from Persistent Store.
+
+    Records written by older firmware are shorter, if the full read fails
+    the version 1 layout is read and the later fields defaulted.
+*/
+static bool appDeviceReadAttributes(const bdaddr *bd_addr, appDeviceAttributes *attributes)
+{
+    if (!ConnectionSmGetAttributeNowReq(0, TYPED_BDADDR_PUBLIC, bd_addr, sizeof(*attributes), (uint8 *)attributes))
+    {
+        if (!ConnectionSmGetAttributeNowReq(0, TYPED_BDADDR_PUBLIC, bd_addr, sizeof(appDeviceAttributesV1), (uint8 *)attributes))
+            return FALSE;
+        attributes->dev_info_version = 1;
+    }
+    appDeviceUpgradeAttributes(attributes);
+    return TRUE;
+}
+
+/*! \brief Read the attributes of a device from Persistent Store by index, see appDeviceReadAttributes(). */
+static bool appDeviceReadIndexedAttributes(int index, appDeviceAttributes *attributes, typed_bdaddr *taddr)
+{
+    if (!ConnectionSmGetIndexedAttributeNowReq(0, index, sizeof(*attributes), (uint8 *)attributes, taddr))
+    {
+        if (!ConnectionSmGetIndexedAttributeNowReq(0, index, sizeof(appDeviceAttributesV1), (uint8 *)attributes, taddr))
+            return FALSE;
+        attributes->dev_info_version = 1;
+    }
+    appDeviceUpgradeAttributes(attributes);
+    return TRUE;
+}
+
 /*! \brief Update the RAM cache of a device attributes. */
 static void appDeviceUpdateCache(deviceTaskData *theDevice, appDeviceAttributes *attributes, const bdaddr *bd_addr)
 {
@@ -67,7 +114,10 @@ bool appDeviceGetAttachedHandsetBdAddr(bdaddr *bd_addr)
 
 bool appDeviceFindBdAddrAttributes(const bdaddr *bd_addr, appDeviceAttributes *attributes)
 {
-    return ConnectionSmGetAttributeNowReq(0, TYPED_BDADDR_PUBLIC, bd_addr, attributes ? sizeof(*attributes) : 0, (uint8 *)attributes);
+    if (!attributes)
+        return ConnectionSmGetAttributeNowReq(0, TYPED_BDADDR_PUBLIC, bd_addr, 0, NULL);
+
+    return appDeviceReadAttributes(bd_addr, attributes);
 }
 
 /*! @brief Get attributes for device type starting search at specified index.
@@ -90,9 +140,7 @@ static bool appDeviceGetAttributes(bdaddr *bd_addr, deviceType type, appDeviceAt
 
     for (; iter < appConfigMaxPairedDevices(); iter++)
     {
-        if (ConnectionSmGetIndexedAttributeNowReq(0, iter,
-                                                  sizeof(*attributes), (uint8 *)attributes,
-                                                  &taddr))
+        if (appDeviceReadIndexedAttributes(iter, attributes, &taddr))
         {
             /* Return if device type matches and TWS version is known */
             if ((attributes->type == type) && (attributes->tws_version != DEVICE_TWS_UNKNOWN))
@@ -216,6 +264,8 @@ void appDeviceInit(void)
 
     theDevice->task.handler = appDeviceHandleMessage;
     theDevice->device_version_client_tasks = appTaskListInit();
+    theDevice->sdp_cache_hits = 0;
+    theDevice->sdp_cache_misses = 0;
             
     BdaddrSetZero(&theDevice->handset_bd_addr);
     BdaddrSetZero(&theDevice->peer_bd_addr);
@@ -227,9 +277,7 @@ void appDeviceInit(void)
         typed_bdaddr t_bd_addr;
 
         /* Retrieve attributes from the specified device index */
-        if (ConnectionSmGetIndexedAttributeNowReq(0, index,
-                                                  sizeof(attributes), (uint8 *)&attributes,
-                                                  &t_bd_addr))
+        if (appDeviceReadIndexedAttributes(index, &attributes, &t_bd_addr))
         {
             /* Update cache */
             appDeviceUpdateCache(theDevice, &attributes, &t_bd_addr.addr);
@@ -245,7 +293,7 @@ void appDeviceInit(void)
 void appDeviceInitAttributes(appDeviceAttributes *attributes)
 {
     attributes->a2dp_num_seids = 0;
-    attributes->dev_info_version = 1;
+    attributes->dev_info_version = DEVICE_ATTRIBUTES_VERSION;
     attributes->hfp_profile = 0;
     attributes->supported_profiles = 0;
     attributes->connected_profiles = 0;
@@ -253,6 +301,14 @@ void appDeviceInitAttributes(appDeviceAttributes *attributes)
     attributes->type = DEVICE_TYPE_UNKNOWN;
     attributes->link_mode = DEVICE_LINK_MODE_UNKNOWN;
     attributes->flags = 0x00;
+    attributes->sdp_cache_uses = 0;
+    attributes->sdp_scofwd_psm = 0;
+    attributes->sdp_records_version = 0;
+    attributes->a2dp_cached_seid = 0;
+    attributes->a2dp_caps_version = 0;
+    attributes->a2dp_low_latency = FALSE;
+    attributes->a2dp_congestion = 0;
+    attributes->avrcp_delayed_connects = 0;
 #ifdef INCLUDE_AV
     appA2dpSetDefaultAttributes(attributes);
 #endif
@@ -338,6 +394,153 @@ void appDeviceSetTwsVersion(const bdaddr *bd_addr, uint16 tws_version)
     }
 }
 
+bool appDeviceGetSdpTwsVersion(const bdaddr *bd_addr, uint16 *tws_version)
+{
+    deviceTaskData *theDevice = appGetDevice();
+    appDeviceAttributes attributes;
+
+    if (appDeviceFindBdAddrAttributes(bd_addr, &attributes) &&
+        (attributes.flags & DEVICE_FLAGS_SDP_TWS_VERSION_CACHED) &&
+        (attributes.sdp_cache_uses < appConfigSdpCacheMaxUses()))
+    {
+        /* Count the use, so the result is refreshed by a search periodically */
+        attributes.sdp_cache_uses += 1;
+        appDeviceSetAttributes(bd_addr, &attributes);
+
+        DEBUG_LOGF("appDeviceGetSdpTwsVersion, hit, version %u.%02u, uses %u",
+                   attributes.tws_version >> 8, attributes.tws_version & 0xFF, attributes.sdp_cache_uses);
+        theDevice->sdp_cache_hits += 1;
+        *tws_version = attributes.tws_version;
+        return TRUE;
+    }
+
+    DEBUG_LOG("appDeviceGetSdpTwsVersion, miss");
+    theDevice->sdp_cache_misses += 1;
+    return FALSE;
+}
+
+void appDeviceSetSdpTwsVersionCached(const bdaddr *bd_addr)
+{
+    appDeviceAttributes attributes;
+
+    if (appDeviceFindBdAddrAttributes(bd_addr, &attributes))
+    {
+        attributes.flags |= DEVICE_FLAGS_SDP_TWS_VERSION_CACHED;
+        attributes.sdp_cache_uses = 0;
+        appDeviceSetAttributes(bd_addr, &attributes);
+    }
+}
+
+bool appDeviceGetSdpScoFwdPsm(const bdaddr *bd_addr, uint16 *psm)
+{
+    deviceTaskData *theDevice = appGetDevice();
+    appDeviceAttributes attributes;
+
+    if (appDeviceFindBdAddrAttributes(bd_addr, &attributes) && attributes.sdp_scofwd_psm)
+    {
+        DEBUG_LOGF("appDeviceGetSdpScoFwdPsm, hit, psm %u", attributes.sdp_scofwd_psm);
+        theDevice->sdp_cache_hits += 1;
+        *psm = attributes.sdp_scofwd_psm;
+        return TRUE;
+    }
+
+    DEBUG_LOG("appDeviceGetSdpScoFwdPsm, miss");
+    theDevice->sdp_cache_misses += 1;
+    return FALSE;
+}
+
+void appDeviceSetSdpScoFwdPsm(const bdaddr *bd_addr, uint16 psm)
+{
+    appDeviceAttributes attributes;
+
+    if (appDeviceFindBdAddrAttributes(bd_addr, &attributes) && (attributes.sdp_scofwd_psm != psm))
+    {
+        DEBUG_LOGF("appDeviceSetSdpScoFwdPsm, psm %u", psm);
+        attributes.sdp_scofwd_psm = psm;
+        appDeviceSetAttributes(bd_addr, &attributes);
+    }
+}
+
+void appDeviceSetSdpRecordsVersion(const bdaddr *bd_addr, uint16 version)
+{
+    appDeviceAttributes attributes;
+
+    if (appDeviceFindBdAddrAttributes(bd_addr, &attributes) && (attributes.sdp_records_version != version))
+    {
+        DEBUG_LOGF("appDeviceSetSdpRecordsVersion, version %u, previous %u, invalidating cache",
+                   version, attributes.sdp_records_version);
+        attributes.sdp_records_version = version;
+        attributes.flags &= ~DEVICE_FLAGS_SDP_TWS_VERSION_CACHED;
+        attributes.sdp_scofwd_psm = 0;
+        appDeviceSetAttributes(bd_addr, &attributes);
+    }
+}
+
+void appDeviceInvalidateSdpCache(const bdaddr *bd_addr)
+{
+    appDeviceAttributes attributes;
+
+    if (appDeviceFindBdAddrAttributes(bd_addr, &attributes))
+    {
+        DEBUG_LOG("appDeviceInvalidateSdpCache");
+        attributes.flags &= ~DEVICE_FLAGS_SDP_TWS_VERSION_CACHED;
+        attributes.sdp_scofwd_psm = 0;
+        appDeviceSetAttributes(bd_addr, &attributes);
+    }
+}
+
+void appDeviceSetAvrcpConnectDelayReqd(const bdaddr *bd_addr, bool reqd)
+{
+    appDeviceAttributes attributes;
+
+    if (appDeviceFindBdAddrAttributes(bd_addr, &attributes))
+    {
+        uint8 flags = attributes.flags;
+        uint16 delayed_connects = attributes.avrcp_delayed_connects;
+
+        if (reqd)
+            attributes.flags |= DEVICE_FLAGS_AVRCP_CONNECT_DELAY_REQD;
+        else
+            attributes.flags &= ~DEVICE_FLAGS_AVRCP_CONNECT_DELAY_REQD;
+
+        /* Either way the delayed connects are counted afresh */
+        attributes.avrcp_delayed_connects = 0;
+
+        if ((attributes.flags != flags) || delayed_connects)
+        {
+            DEBUG_LOGF("appDeviceSetAvrcpConnectDelayReqd, reqd %u", reqd);
+            appDeviceSetAttributes(bd_addr, &attributes);
+        }
+    }
+}
+
+bool appDeviceIsAvrcpConnectDelayReqd(const bdaddr *bd_addr)
+{
+    appDeviceAttributes attributes;
+
+    if (appDeviceFindBdAddrAttributes(bd_addr, &attributes))
+        return (attributes.flags & DEVICE_FLAGS_AVRCP_CONNECT_DELAY_REQD) != 0;
+
+    return FALSE;
+}
+
+uint16 appDeviceAvrcpConnectDelayed(const bdaddr *bd_addr)
+{
+    appDeviceAttributes attributes;
+
+    if (appDeviceFindBdAddrAttributes(bd_addr, &attributes))
+    {
+        if (attributes.avrcp_delayed_connects < 0xFFFF)
+        {
+            attributes.avrcp_delayed_connects += 1;
+            appDeviceSetAttributes(bd_addr, &attributes);
+        }
+        return attributes.avrcp_delayed_connects;
+    }
+
+    return 0;
+}
+
 bool appDeviceIsPeer(const bdaddr *bd_addr)
 {
     deviceTaskData *theDevice = appGetDevice();
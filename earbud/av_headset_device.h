@@ -53,6 +53,18 @@ typedef enum
 #define DEVICE_FLAGS_JUST_PAIRED                    (1 << 2)
 /*! Bit in handset flags indicating this handset was pre-paired on request from peer. */
 #define DEVICE_FLAGS_PRE_PAIRED_HANDSET             (1 << 3)
+/*! Bit in device flags indicating the stored TWS version came from a service
+ * search that is still valid, so the search can be skipped on reconnect. */
+#define DEVICE_FLAGS_SDP_TWS_VERSION_CACHED         (1 << 4)
+/*! Bit in handset flags indicating the handset fails AVRCP connections made
+ * straight after it connects A2DP, so AVRCP must be connected after a delay. */
+#define DEVICE_FLAGS_AVRCP_CONNECT_DELAY_REQD       (1 << 5)
+
+/*! Version of #appDeviceAttributes written to Persistent Store.
+    - 1: baseline, see #appDeviceAttributesV1
+    - 2: adds the SDP cache, cached A2DP SEID, A2DP latency and delayed
+         AVRCP connect fields */
+#define DEVICE_ATTRIBUTES_VERSION   (2)
 
 /*! Device attributes store in Persistent Store */
 typedef struct appDeviceAttributes
@@ -68,6 +80,14 @@ typedef struct appDeviceAttributes
     uint8 connected_profiles;   /*!< Bitmap of connected profiles */
     uint16 tws_version;         /*!< TWS+ version number, MSB major, LSB minor. 0 if standard device */
     uint8 flags;                /*!< Misc. flags */
+    uint8 sdp_cache_uses;       /*!< Connections served from the SDP cache since the last search */
+    uint16 sdp_scofwd_psm;      /*!< Cached SCO forwarding PSM of a peer earbud, 0 if not cached */
+    uint16 sdp_records_version; /*!< SDP records version hint of the device when the cache was filled */
+    uint16 a2dp_cached_seid;    /*!< SEID of the last media channel opened to a handset, 0 if not cached */
+    uint16 a2dp_caps_version;   /*!< Endpoint capabilities version when the SEID was cached */
+    uint8 a2dp_low_latency;     /*!< Handset content needs low latency audio, e.g. gaming */
+    uint8 a2dp_congestion;      /*!< Recent streams from the handset that needed robust forwarding */
+    uint16 avrcp_delayed_connects; /*!< Delayed AVRCP connects since an early connect was rejected */
 } appDeviceAttributes;
 
 /*! \brief appDeviceAttributes structure must be an even number of octets, otherwise
@@ -75,6 +95,24 @@ typedef struct appDeviceAttributes
  * after the structure */
 STATIC_ASSERT((sizeof(appDeviceAttributes) % 2 == 0), appDeviceAttributes_not_even);
 
+/*! Layout of version 1 device attributes. Records written by older firmware
+    are shorter than #appDeviceAttributes, they are read with this size and
+    the fields added since are set to their defaults. */
+typedef struct
+{
+    uint8 a2dp_num_seids;
+    uint8 a2dp_volume;
+    uint8 hfp_profile;
+
+    uint8 dev_info_version;
+    deviceType type;
+    deviceLinkMode link_mode;
+    uint8 supported_profiles;
+    uint8 connected_profiles;
+    uint16 tws_version;
+    uint8 flags;
+} appDeviceAttributesV1;
+
 /*! \brief Device manager task data. */
 typedef struct
 {
@@ -89,6 +127,8 @@ typedef struct
     uint16 peer_flags;			/*!< Peer misc. flags */
     bool   peer_connected;      /*!< Is peer currently connected? */
     TaskList *device_version_client_tasks; /*!< List of tasks interested in device version changes */
+    uint16 sdp_cache_hits;      /*!< Service searches skipped using cached results */
+    uint16 sdp_cache_misses;    /*!< Service searches required as no valid cached result */
 } deviceTaskData;
 
 
@@ -193,6 +233,82 @@ extern uint16 appDeviceTwsVersion(const bdaddr *bd_addr);
 */
 extern void appDeviceSetTwsVersion(const bdaddr *bd_addr, uint16 tws_version);
 
+/*! \brief Get the cached TWS version for a given BT address.
+
+    The TWS version is only returned if it was found by a service search
+    that has not since been invalidated, and the cached result has not been
+    used for more than appConfigSdpCacheMaxUses() connections.  Using the
+    cached result counts as one use.
+
+    \param bd_addr Pointer to read-only device BT address.
+    \param tws_version Set to the cached TWS version if found.
+    \return bool TRUE if a valid cached TWS version was found, FALSE otherwise.
+*/
+extern bool appDeviceGetSdpTwsVersion(const bdaddr *bd_addr, uint16 *tws_version);
+
+/*! \brief Mark the TWS version for a given BT address as found by service search.
+
+    \param bd_addr Pointer to read-only device BT address.
+*/
+extern void appDeviceSetSdpTwsVersionCached(const bdaddr *bd_addr);
+
+/*! \brief Get the cached SCO forwarding PSM for a given BT address.
+
+    \param bd_addr Pointer to read-only device BT address.
+    \param psm Set to the cached PSM if found.
+    \return bool TRUE if a cached PSM was found, FALSE otherwise.
+*/
+extern bool appDeviceGetSdpScoFwdPsm(const bdaddr *bd_addr, uint16 *psm);
+
+/*! \brief Set the cached SCO forwarding PSM for a given BT address.
+
+    \param bd_addr Pointer to read-only device BT address.
+    \param psm PSM found by service search, 0 to invalidate the cached PSM.
+*/
+extern void appDeviceSetSdpScoFwdPsm(const bdaddr *bd_addr, uint16 psm);
+
+/*! \brief Set the SDP records version hint for a given BT address.
+
+    If the version differs from the one the cached SDP results were found
+    under, all cached SDP results for the device are invalidated.
+
+    \param bd_addr Pointer to read-only device BT address.
+    \param version SDP records version hint reported by the device.
+*/
+extern void appDeviceSetSdpRecordsVersion(const bdaddr *bd_addr, uint16 version);
+
+/*! \brief Invalidate all cached SDP results for a given BT address.
+
+    \param bd_addr Pointer to read-only device BT address.
+*/
+extern void appDeviceInvalidateSdpCache(const bdaddr *bd_addr);
+
+/*! \brief Set flag for a device indicating if AVRCP must be connected after
+           a delay when the device connects A2DP.
+
+    \param bd_addr Pointer to read-only device BT address.
+    \param reqd TRUE if the delay is required, FALSE otherwise.
+*/
+extern void appDeviceSetAvrcpConnectDelayReqd(const bdaddr *bd_addr, bool reqd);
+
+/*! \brief Determine if AVRCP must be connected after a delay when the
+           device connects A2DP.
+
+    \param bd_addr Pointer to read-only device BT address.
+    \return bool TRUE if the delay is required, FALSE otherwise.
+*/
+extern bool appDeviceIsAvrcpConnectDelayReqd(const bdaddr *bd_addr);
+
+/*! \brief Record that AVRCP was connected after a delay for a device.
+
+    The count is reset by appDeviceSetAvrcpConnectDelayReqd().
+
+    \param bd_addr Pointer to read-only device BT address.
+    \return uint16 Number of delayed connects since an early connect was
+            last rejected, 0 if the device is unknown.
+*/
+extern uint16 appDeviceAvrcpConnectDelayed(const bdaddr *bd_addr);
+
 /*! \brief Determine if a BT address is a known handset device. 
 
 	\param bd_addr Pointer to read-only device BT address.
@@ -32,6 +32,7 @@ typedef enum av_handset_gaia_internal_messages
 static void appGaiaMessageHandler(Task task, MessageId id, Message message);
 static void gaia_handle_command(Task task, const GAIA_UNHANDLED_COMMAND_IND_T *command);
 static bool gaia_handle_status_command(Task task, const GAIA_UNHANDLED_COMMAND_IND_T *command);
+static void gaia_send_a2dp_start_stats(const GAIA_UNHANDLED_COMMAND_IND_T *command);
 static void gaia_send_response(uint16 vendor_id, uint16 command_id, uint16 status,
                           uint16 payload_length, uint8 *payload);
 static void gaia_send_packet(uint16 vendor_id, uint16 command_id, uint16 status,
@@ -285,6 +286,51 @@ static void gaia_handle_command(Task task, const GAIA_UNHANDLED_COMMAND_IND_T *c
     }
 }
 
+/*************************************************************************
+NAME
+    gaia_send_a2dp_start_stats
+
+DESCRIPTION
+    Respond with the A2DP media start statistics of the handset. For each
+    phase: count, minimum, average and maximum time (16 bit, big endian)
+    followed by the start latency histogram buckets (8 bit).
+*/
+static void gaia_send_a2dp_start_stats(const GAIA_UNHANDLED_COMMAND_IND_T *command)
+{
+    uint8 payload[A2DP_START_PHASE_COUNT * (8 + A2DP_START_HISTOGRAM_BUCKETS)];
+    uint8 *ptr = payload;
+    a2dpStartStats stats;
+    bdaddr bd_addr;
+    int phase;
+    int bucket;
+
+    if (!appDeviceGetHandsetBdAddr(&bd_addr) || !appA2dpGetStartStats(&bd_addr, &stats))
+    {
+        gaia_send_response(command->vendor_id, command->command_id, GAIA_STATUS_INCORRECT_STATE, 0, NULL);
+        return;
+    }
+
+    for (phase = 0; phase < A2DP_START_PHASE_COUNT; phase++)
+    {
+        const a2dpStartPhaseStats *phase_stats = &stats.phase[phase];
+        const uint16 avg_ms = phase_stats->count ? (uint16)(phase_stats->total_ms / phase_stats->count) : 0;
+
+        *ptr++ = phase_stats->count >> 8;
+        *ptr++ = phase_stats->count & 0xFF;
+        *ptr++ = phase_stats->min_ms >> 8;
+        *ptr++ = phase_stats->min_ms & 0xFF;
+        *ptr++ = avg_ms >> 8;
+        *ptr++ = avg_ms & 0xFF;
+        *ptr++ = phase_stats->max_ms >> 8;
+        *ptr++ = phase_stats->max_ms & 0xFF;
+        for (bucket = 0; bucket < A2DP_START_HISTOGRAM_BUCKETS; bucket++)
+            *ptr++ = phase_stats->histogram[bucket];
+    }
+
+    gaia_send_response(command->vendor_id, command->command_id, GAIA_STATUS_SUCCESS,
+                       sizeof(payload), payload);
+}
+
 /*************************************************************************
 NAME
     gaia_handle_status_command
@@ -302,6 +348,11 @@ static bool gaia_handle_status_command(Task task, const GAIA_UNHANDLED_COMMAND_I
         DEBUG_LOG("AV_GAIA_COMMAND_GET_APPLICATION_VERSION");
         return FALSE;
 
+    case GAIA_COMMAND_AV_GET_A2DP_START_STATS:
+        DEBUG_LOG("AV_GAIA_COMMAND_AV_GET_A2DP_START_STATS");
+        gaia_send_a2dp_start_stats(command);
+        return TRUE;
+
     default:
         DEBUG_LOGF("AV_GAIA_COMMAND 0x%x (%d)",command->command_id,command->command_id);
         return FALSE;
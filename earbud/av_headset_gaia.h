@@ -15,6 +15,13 @@
 #include <gaia.h>
 
 
+/*! GAIA status command to read the A2DP media start statistics of the
+    handset. The response holds the count, minimum, average and maximum time
+    in milliseconds, as big-endian uint16, followed by the
+    #A2DP_START_HISTOGRAM_BUCKETS histogram counts, as uint8, for each
+    #a2dpStartPhase. */
+#define GAIA_COMMAND_AV_GET_A2DP_START_STATS    (0x03C0)
+
 /*! Data used by the GAIA module */
 typedef struct
 {
@@ -11,6 +11,9 @@
 #include <audio.h>
 #include <panic.h>
 #include <ps.h>
+#include <vm.h>
+#include <string.h>
+#include <stdlib.h>
 
 #ifdef INCLUDE_HFP
 
@@ -58,6 +61,8 @@ const hfpState hfp_call_state_table[10] =
 static void appHfpHandleInternalConfigWriteRequest(void);
 static void appHfpConfigStore(void);
 static void appHfpHandleMessage(Task task, MessageId id, Message message);
+static void appHfpAtCmdQueue(hfpAtCmdType type, unsigned param, const char *cmd);
+static void appHfpAtCmdFlush(void);
 
 /*! \brief Set default attributes
 
@@ -221,6 +226,8 @@ static void appHfpEnterConnected(void)
 {
     DEBUG_LOG("appHfpEnterConnected");
 
+    appGetHfp()->acl_handle = appConManagerGetHandle(&appGetHfp()->ag_bd_addr);
+
     /* Update most recent connected device */
     ConnectionSmUpdateMruDevice(&appGetHfp()->ag_bd_addr);
 
@@ -236,8 +243,8 @@ static void appHfpEnterConnected(void)
         /* Inform AG of the current gain settings */
         /* hfp_primary_link indicates the link that was connected first */
         /* TODO : Handle multipoint support */
-        HfpVolumeSyncSpeakerGainRequest((hfp_link_priority)hfp_primary_link, &appGetHfp()->volume);
-        HfpVolumeSyncMicrophoneGainRequest(hfp_primary_link, &appGetHfp()->mic_volume);
+        appHfpAtCmdQueue(HFP_AT_CMD_SPEAKER_GAIN, 0, NULL);
+        appHfpAtCmdQueue(HFP_AT_CMD_MIC_GAIN, 0, NULL);
     }
 
     /* Set link supervision timeout to 5 seconds */
@@ -292,6 +299,11 @@ static void appHfpEnterConnected(void)
 static void appHfpExitConnected(void)
 {
     DEBUG_LOG("appHfpExitConnected");
+
+    appGetHfp()->acl_handle = CON_MANAGER_HANDLE_INVALID;
+
+    /* Discard AT commands that can no longer be sent */
+    appHfpAtCmdFlush();
     
     /* Tell clients we have disconnected */
     MAKE_HFP_MESSAGE(APP_HFP_DISCONNECTED_IND);
@@ -1459,6 +1471,356 @@ static void appHfpHandleHfpUnrecognisedAtCmdInd(HFP_UNRECOGNISED_AT_CMD_IND_T* i
 
 }
 
+/*! \brief Get the scheduling priority of an AT command type */
+static hfpAtCmdPriority appHfpAtCmdGetPriority(hfpAtCmdType type)
+{
+    switch (type)
+    {
+        case HFP_AT_CMD_SPEAKER_GAIN:
+        case HFP_AT_CMD_MIC_GAIN:
+            return HFP_AT_CMD_PRIORITY_VOLUME;
+
+        case HFP_AT_CMD_VENDOR:
+            return HFP_AT_CMD_PRIORITY_VENDOR;
+
+        default:
+            return HFP_AT_CMD_PRIORITY_CALL;
+    }
+}
+
+/*! \brief Record the latency of an AT command, from queuing to completion */
+static void appHfpAtCmdRecordLatency(const hfpAtCmd *at_cmd)
+{
+    hfpAtCmdLatency *latency = &appGetHfp()->at_latency[at_cmd->type];
+    uint32 elapsed = VmGetClock() - at_cmd->queued_ms;
+
+    latency->count += 1;
+    latency->last_ms = (elapsed > 0xFFFF) ? 0xFFFF : (uint16)elapsed;
+    if (latency->last_ms > latency->max_ms)
+        latency->max_ms = latency->last_ms;
+    latency->total_ms += elapsed;
+
+    DEBUG_LOGF("appHfpAtCmdRecordLatency, type %u, latency %u", at_cmd->type, latency->last_ms);
+}
+
+/*! \brief Discard an AT command without sending it
+
+    A client sending a vendor command is told it failed, so it doesn't wait
+    for a confirmation that will never come.
+*/
+static void appHfpAtCmdDiscard(hfpAtCmd *at_cmd)
+{
+    hfpTaskData *hfp = appGetHfp();
+
+    DEBUG_LOGF("appHfpAtCmdDiscard, type %u", at_cmd->type);
+
+    hfp->at_latency[at_cmd->type].dropped += 1;
+    if (at_cmd->type == HFP_AT_CMD_VENDOR)
+    {
+        free(at_cmd->cmd);
+        at_cmd->cmd = NULL;
+
+        if (hfp->at_cmd_task)
+        {
+            MAKE_HFP_MESSAGE(APP_HFP_AT_CMD_CFM);
+            message->status = FALSE;
+            MessageSend(hfp->at_cmd_task, APP_HFP_AT_CMD_CFM, message);
+        }
+    }
+}
+
+/*! \brief Send an AT command to the AG
+
+    \return TRUE if the HFP library will confirm the command, FALSE otherwise.
+*/
+static bool appHfpAtCmdSend(const hfpAtCmd *at_cmd)
+{
+    switch (at_cmd->type)
+    {
+        case HFP_AT_CMD_CALL_ANSWER:
+            HfpCallAnswerRequest(hfp_primary_link, TRUE);
+            return TRUE;
+
+        case HFP_AT_CMD_CALL_REJECT:
+            HfpCallAnswerRequest(hfp_primary_link, FALSE);
+            return TRUE;
+
+        case HFP_AT_CMD_CALL_TERMINATE:
+            HfpCallTerminateRequest(hfp_primary_link);
+            return TRUE;
+
+        case HFP_AT_CMD_BUTTON_PRESS:
+            HfpHsButtonPressRequest(hfp_primary_link);
+            return TRUE;
+
+        case HFP_AT_CMD_DIAL_LAST_NUMBER:
+            HfpDialLastNumberRequest(hfp_primary_link);
+            return TRUE;
+
+        case HFP_AT_CMD_VOICE_RECOGNITION:
+            HfpVoiceRecognitionEnableRequest(hfp_primary_link, at_cmd->param);
+            return TRUE;
+
+        /* Gain is read when the command is sent, so merged commands send the latest gain */
+        case HFP_AT_CMD_SPEAKER_GAIN:
+            HfpVolumeSyncSpeakerGainRequest(hfp_primary_link, &appGetHfp()->volume);
+            return FALSE;
+
+        case HFP_AT_CMD_MIC_GAIN:
+            HfpVolumeSyncMicrophoneGainRequest(hfp_primary_link, &appGetHfp()->mic_volume);
+            return FALSE;
+
+        case HFP_AT_CMD_VENDOR:
+            HfpAtCmdRequest((hfp_link_priority)at_cmd->param, at_cmd->cmd);
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+/*! \brief Send the next queued AT command if none is awaiting confirmation
+
+    The highest priority command is sent first, oldest first within a
+    priority.  Only one command is outstanding at a time since the AG handles
+    AT commands in order, so a queued call control command never waits
+    behind more than one other command.
+*/
+static void appHfpAtCmdDispatch(void)
+{
+    hfpTaskData *hfp = appGetHfp();
+
+    if (hfp->at_in_flight.type == HFP_AT_CMD_NONE && hfp->at_queue_len)
+    {
+        int next = 0;
+
+        for (int i = 1; i < hfp->at_queue_len; i++)
+            if (appHfpAtCmdGetPriority(hfp->at_queue[i].type) < appHfpAtCmdGetPriority(hfp->at_queue[next].type))
+                next = i;
+
+        hfp->at_in_flight = hfp->at_queue[next];
+        hfp->at_queue_len -= 1;
+        memmove(&hfp->at_queue[next], &hfp->at_queue[next + 1], (hfp->at_queue_len - next) * sizeof(hfpAtCmd));
+
+        DEBUG_LOGF("appHfpAtCmdDispatch, type %u, queued %u", hfp->at_in_flight.type, hfp->at_queue_len);
+
+        if (appHfpAtCmdSend(&hfp->at_in_flight))
+        {
+            MessageSendLater(appGetHfpTask(), HFP_INTERNAL_AT_CMD_TIMEOUT, NULL, appConfigHfpAtCmdTimeoutMs());
+        }
+        else
+        {
+            /* No confirmation, hold off the next command so repeated gain changes merge */
+            appHfpAtCmdRecordLatency(&hfp->at_in_flight);
+            MessageSendLater(appGetHfpTask(), HFP_INTERNAL_AT_CMD_TIMEOUT, NULL, appConfigHfpAtCmdGainIntervalMs());
+        }
+
+        free(hfp->at_in_flight.cmd);
+        hfp->at_in_flight.cmd = NULL;
+        appLinkPolicyNotifyActivity(hfp->acl_handle, LP_ACTIVITY_HFP);
+    }
+}
+
+/*! \brief Queue an AT command for sending to the AG
+
+    Gain and call control commands are merged with an identical command
+    already queued.  If the queue is full the newest lower priority command
+    is discarded to make room, otherwise the new command is discarded.
+
+    \param type     Type of command
+    \param param    Voice recognition enable, or link priority for vendor commands
+    \param cmd      NULL terminated vendor command, copied by the queue
+*/
+static void appHfpAtCmdQueue(hfpAtCmdType type, unsigned param, const char *cmd)
+{
+    hfpTaskData *hfp = appGetHfp();
+    hfpAtCmdPriority priority = appHfpAtCmdGetPriority(type);
+    hfpAtCmd *at_cmd;
+
+    if (type != HFP_AT_CMD_VENDOR && type != HFP_AT_CMD_BUTTON_PRESS)
+    {
+        for (int i = 0; i < hfp->at_queue_len; i++)
+        {
+            if (hfp->at_queue[i].type == type)
+            {
+                DEBUG_LOGF("appHfpAtCmdQueue, type %u merged", type);
+                hfp->at_queue[i].param = param;
+                hfp->at_latency[type].coalesced += 1;
+                return;
+            }
+        }
+    }
+
+    if (hfp->at_queue_len == HFP_AT_CMD_QUEUE_SIZE)
+    {
+        int victim = -1;
+
+        for (int i = hfp->at_queue_len - 1; i >= 0; i--)
+        {
+            hfpAtCmdPriority victim_priority = appHfpAtCmdGetPriority(hfp->at_queue[i].type);
+            if (victim_priority > priority &&
+                (victim < 0 || victim_priority > appHfpAtCmdGetPriority(hfp->at_queue[victim].type)))
+                victim = i;
+        }
+
+        if (victim < 0)
+        {
+            hfpAtCmd discard = {0};
+            discard.type = type;
+            appHfpAtCmdDiscard(&discard);
+            return;
+        }
+
+        appHfpAtCmdDiscard(&hfp->at_queue[victim]);
+        hfp->at_queue_len -= 1;
+        memmove(&hfp->at_queue[victim], &hfp->at_queue[victim + 1], (hfp->at_queue_len - victim) * sizeof(hfpAtCmd));
+    }
+
+    at_cmd = &hfp->at_queue[hfp->at_queue_len++];
+    at_cmd->type = type;
+    at_cmd->param = param;
+    at_cmd->cmd = NULL;
+    at_cmd->queued_ms = VmGetClock();
+    if (cmd)
+    {
+        at_cmd->cmd = PanicUnlessMalloc(strlen(cmd) + 1);
+        strcpy(at_cmd->cmd, cmd);
+    }
+
+    appHfpAtCmdDispatch();
+}
+
+/*! \brief Get the HFP library message confirming an AT command type
+
+    \return The confirmation message, 0 if the command isn't confirmed.
+*/
+static MessageId appHfpAtCmdGetCfmId(hfpAtCmdType type)
+{
+    switch (type)
+    {
+        case HFP_AT_CMD_CALL_ANSWER:
+        case HFP_AT_CMD_CALL_REJECT:
+            return HFP_CALL_ANSWER_CFM;
+
+        case HFP_AT_CMD_CALL_TERMINATE:
+            return HFP_CALL_TERMINATE_CFM;
+
+        case HFP_AT_CMD_BUTTON_PRESS:
+            return HFP_HS_BUTTON_PRESS_CFM;
+
+        case HFP_AT_CMD_DIAL_LAST_NUMBER:
+            return HFP_DIAL_LAST_NUMBER_CFM;
+
+        case HFP_AT_CMD_VOICE_RECOGNITION:
+            return HFP_VOICE_RECOGNITION_ENABLE_CFM;
+
+        case HFP_AT_CMD_VENDOR:
+            return HFP_AT_CMD_CFM;
+
+        default:
+            return 0;
+    }
+}
+
+/*! \brief Handle confirmation of an AT command from the HFP library
+
+    The HFP library confirms commands in order, so a confirmation still due
+    for a command that timed out arrives before the confirmation of a later
+    command of the same type. It is dropped rather than confirming the
+    command in flight.
+
+    A confirmation not received within appConfigHfpAtCmdStaleMs() of the
+    timeout, or before a later command is confirmed, is assumed lost so it
+    can't swallow the confirmation of every later command of its type.
+
+    \param id The HFP library confirmation message
+    \return FALSE if the confirmation was for a command that timed out.
+*/
+static bool appHfpAtCmdConfirm(MessageId id)
+{
+    hfpTaskData *hfp = appGetHfp();
+    int type;
+
+    if ((VmGetClock() - hfp->at_stale_ms) > appConfigHfpAtCmdStaleMs())
+        memset(hfp->at_stale_cfms, 0, sizeof(hfp->at_stale_cfms));
+
+    for (type = HFP_AT_CMD_NONE + 1; type < HFP_AT_CMD_TYPE_COUNT; type++)
+    {
+        if (hfp->at_stale_cfms[type] && (appHfpAtCmdGetCfmId((hfpAtCmdType)type) == id))
+        {
+            DEBUG_LOGF("appHfpAtCmdConfirm, late confirmation, type %u", type);
+            hfp->at_stale_cfms[type] -= 1;
+            return FALSE;
+        }
+    }
+
+    if ((hfp->at_in_flight.type != HFP_AT_CMD_NONE) &&
+        (appHfpAtCmdGetCfmId((hfpAtCmdType)hfp->at_in_flight.type) == id))
+    {
+        appHfpAtCmdRecordLatency(&hfp->at_in_flight);
+        hfp->at_in_flight.type = HFP_AT_CMD_NONE;
+        MessageCancelAll(appGetHfpTask(), HFP_INTERNAL_AT_CMD_TIMEOUT);
+
+        /* Confirmations are in order, any still due for earlier commands were lost */
+        memset(hfp->at_stale_cfms, 0, sizeof(hfp->at_stale_cfms));
+        appHfpAtCmdDispatch();
+    }
+    return TRUE;
+}
+
+/*! \brief Handle AT command not confirmed in time, or end of gain command interval
+
+    A command that wasn't confirmed in time is failed, its confirmation is
+    dropped if it arrives later.
+*/
+static void appHfpHandleInternalAtCmdTimeout(void)
+{
+    hfpTaskData *hfp = appGetHfp();
+    hfpAtCmdType type = (hfpAtCmdType)hfp->at_in_flight.type;
+
+    DEBUG_LOGF("appHfpHandleInternalAtCmdTimeout, type %u", type);
+
+    if (appHfpAtCmdGetCfmId(type))
+    {
+        hfp->at_latency[type].timeouts += 1;
+        if (hfp->at_stale_cfms[type] < 0xFF)
+            hfp->at_stale_cfms[type] += 1;
+        hfp->at_stale_ms = VmGetClock();
+
+        if ((type == HFP_AT_CMD_VENDOR) && hfp->at_cmd_task)
+        {
+            MAKE_HFP_MESSAGE(APP_HFP_AT_CMD_CFM);
+            message->status = FALSE;
+            MessageSend(hfp->at_cmd_task, APP_HFP_AT_CMD_CFM, message);
+        }
+    }
+
+    hfp->at_in_flight.type = HFP_AT_CMD_NONE;
+    appHfpAtCmdDispatch();
+}
+
+/*! \brief Discard all queued AT commands */
+static void appHfpAtCmdFlush(void)
+{
+    hfpTaskData *hfp = appGetHfp();
+
+    while (hfp->at_queue_len)
+        appHfpAtCmdDiscard(&hfp->at_queue[--hfp->at_queue_len]);
+
+    hfp->at_in_flight.type = HFP_AT_CMD_NONE;
+    memset(hfp->at_stale_cfms, 0, sizeof(hfp->at_stale_cfms));
+    MessageCancelAll(appGetHfpTask(), HFP_INTERNAL_AT_CMD_TIMEOUT);
+}
+
+bool appHfpGetAtCmdLatency(hfpAtCmdType type, hfpAtCmdLatency *latency)
+{
+    if (type >= HFP_AT_CMD_TYPE_COUNT)
+        return FALSE;
+
+    *latency = appGetHfp()->at_latency[type];
+    return TRUE;
+}
+
 /*! \brief Send handset signalling AT command to handset. 
 
     \param  priority    Which HFP link to send the command over
@@ -1466,7 +1828,7 @@ static void appHfpHandleHfpUnrecognisedAtCmdInd(HFP_UNRECOGNISED_AT_CMD_IND_T* i
 */
 void appHfpSendAtCmdReq(hfp_link_priority priority, char* cmd)
 {
-    HfpAtCmdRequest(priority, cmd);
+    appHfpAtCmdQueue(HFP_AT_CMD_VENDOR, priority, cmd);
 }
 
 /*! \brief Handle confirmation result of attempt to send AT command to handset. */
@@ -1474,6 +1836,11 @@ static void appHfpHandleHfpAtCmdConfirm(HFP_AT_CMD_CFM_T *cfm)
 {
     hfpTaskData* hfp = appGetHfp();
     DEBUG_LOGF("appHfpHandleHfpAtCmdConfirm %d", cfm->status);
+
+    /* The client was already told a command that timed out failed */
+    if (!appHfpAtCmdConfirm(HFP_AT_CMD_CFM))
+        return;
+
     MAKE_HFP_MESSAGE(APP_HFP_AT_CMD_CFM);
     message->status = cfm->status == hfp_success ? TRUE : FALSE;
     MessageSend(hfp->at_cmd_task, APP_HFP_AT_CMD_CFM, message);
@@ -1688,13 +2055,13 @@ static void appHfpHandleInternalHfpLastNumberRedialRequest(void)
             {
                 /* Send button press */
                 /* TODO: Support Multilink */
-                HfpHsButtonPressRequest(hfp_primary_link);
+                appHfpAtCmdQueue(HFP_AT_CMD_BUTTON_PRESS, 0, NULL);
             }
             else
             {
                 /* Request last number redial */
                 /* TODO: Support Mulitilink */
-                HfpDialLastNumberRequest(hfp_primary_link);
+                appHfpAtCmdQueue(HFP_AT_CMD_DIAL_LAST_NUMBER, 0, NULL);
             }
         }
         return;
@@ -1726,13 +2093,13 @@ static void appHfpHandleInternalHfpVoiceDialRequest(void)
             {
                 /* Send button press */
                 /* TODO: Support Multilink */
-                HfpHsButtonPressRequest(hfp_primary_link);
+                appHfpAtCmdQueue(HFP_AT_CMD_BUTTON_PRESS, 0, NULL);
             }
             else
             {
                 /* Send the CMD to the AG */
                 /* TODO: Support Multipoint */
-                HfpVoiceRecognitionEnableRequest(hfp_primary_link, appGetHfp()->voice_recognition_request = TRUE);
+                appHfpAtCmdQueue(HFP_AT_CMD_VOICE_RECOGNITION, appGetHfp()->voice_recognition_request = TRUE, NULL);
             }
         }
         return;
@@ -1764,13 +2131,13 @@ static void appHfpHandleInternalHfpVoiceDialDisableRequest(void)
             {
                 /* Send button press */
                 /* TODO: Support Multilink */
-                HfpHsButtonPressRequest(hfp_primary_link);
+                appHfpAtCmdQueue(HFP_AT_CMD_BUTTON_PRESS, 0, NULL);
             }
             else
             {
                 /* Send the CMD to the AG */
                 /* TODO: Support Multipoint */
-                HfpVoiceRecognitionEnableRequest(hfp_primary_link, appGetHfp()->voice_recognition_request = FALSE);
+                appHfpAtCmdQueue(HFP_AT_CMD_VOICE_RECOGNITION, appGetHfp()->voice_recognition_request = FALSE, NULL);
             }
         }
         return;
@@ -1802,13 +2169,13 @@ static void appHfpHandleInternalHfpCallAcceptRequest(void)
             {
                 /* Send button press */
                 /* TODO: Support Multilink */
-                HfpHsButtonPressRequest(hfp_primary_link);
+                appHfpAtCmdQueue(HFP_AT_CMD_BUTTON_PRESS, 0, NULL);
             }
             else
             {
                 /* Answer the incoming call */
                 /* TODO: Support Multipoint */
-                HfpCallAnswerRequest(hfp_primary_link, TRUE);
+                appHfpAtCmdQueue(HFP_AT_CMD_CALL_ANSWER, 0, NULL);
             }
         }
         return;
@@ -1845,7 +2212,7 @@ static void appHfpHandleInternalHfpCallRejectRequest(void)
             {
                 /* Reject the incoming call */
                 /* TODO: Support Multipoint */
-                HfpCallAnswerRequest(hfp_primary_link, FALSE);
+                appHfpAtCmdQueue(HFP_AT_CMD_CALL_REJECT, 0, NULL);
             }
         }
         return;
@@ -1878,13 +2245,13 @@ static void appHfpHandleInternalHfpCallHangupRequest(void)
             {
                 /* Send an HSP button press */
                 /* TODO: Support Multipoint */
-                HfpHsButtonPressRequest(hfp_primary_link);
+                appHfpAtCmdQueue(HFP_AT_CMD_BUTTON_PRESS, 0, NULL);
             }
             else
             {
                 /* Terminate the call */
                 /* TODO: Support Multiponit */
-                HfpCallTerminateRequest(hfp_primary_link);
+                appHfpAtCmdQueue(HFP_AT_CMD_CALL_TERMINATE, 0, NULL);
             }
         }
         return;
@@ -2091,6 +2458,13 @@ void appHfpInit(void)
     appGetHfp()->sco_sink = 0;
     appGetHfp()->hfp_lock = 0;
     appGetHfp()->disconnect_reason = APP_HFP_CONNECT_FAILED;
+    appGetHfp()->at_queue_len = 0;
+    appGetHfp()->at_in_flight.type = HFP_AT_CMD_NONE;
+    appGetHfp()->at_in_flight.cmd = NULL;
+    appGetHfp()->acl_handle = CON_MANAGER_HANDLE_INVALID;
+    memset(appGetHfp()->at_latency, 0, sizeof(appGetHfp()->at_latency));
+    memset(appGetHfp()->at_stale_cfms, 0, sizeof(appGetHfp()->at_stale_cfms));
+    appGetHfp()->at_stale_ms = 0;
     appHfpSetState(HFP_STATE_INITIALISING_HFP);
 
     /* Register to receive notifications of (dis)connections */
@@ -2417,18 +2791,17 @@ void appHfpCallHangup(void)
 
     This function is called to store the current HFP configuration.
     
-    The configuration isn't store immediately, instead a timer is started, any
-    currently running timer is cancel.  On timer expiration the configuration
+    The configuration isn't store immediately, instead a timer is started if
+    not already running.  On timer expiration the configuration
     is written to Persistent Store, (see \ref appHfpHandleInternalConfigWriteRequest).
     This is to avoid multiple writes when the user adjusts the playback volume.
 */		
 static void appHfpConfigStore(void)
 {
-    /* Cancel any pending messages */
-    MessageCancelFirst(appGetHfpTask(), HFP_INTERNAL_CONFIG_WRITE_REQ);
-    
-    /* Store configuration after a 5 seconds */
-    MessageSendLater(appGetHfpTask(), HFP_INTERNAL_CONFIG_WRITE_REQ, 0, D_SEC(5));
+    /* Store configuration after a 5 seconds, the configuration at that time
+       is stored so there is no need to restart the timer on every change */
+    if (!MessagePendingFirst(appGetHfpTask(), HFP_INTERNAL_CONFIG_WRITE_REQ, NULL))
+        MessageSendLater(appGetHfpTask(), HFP_INTERNAL_CONFIG_WRITE_REQ, 0, D_SEC(5));
 }
 
 /*! \brief Make volume change
@@ -2464,7 +2837,7 @@ static bool appHfpVolumeChange(int16 step)
     if (appHfpIsConnected())
     {
         /* TODO: Support mulltipoint */
-        HfpVolumeSyncSpeakerGainRequest(hfp_primary_link, &appGetHfp()->volume);
+        appHfpAtCmdQueue(HFP_AT_CMD_SPEAKER_GAIN, 0, NULL);
     }
             
     /* Store new configuration */        
@@ -2749,6 +3122,10 @@ static void appHfpHandleMessage(Task task, MessageId id, Message message)
         case HFP_INTERNAL_VOLUME_DOWN:
             appHfpVolumeRepeat(-1);
             return;
+
+        case HFP_INTERNAL_AT_CMD_TIMEOUT:
+            appHfpHandleInternalAtCmdTimeout();
+            return;
     }
     
     /* HFP profile library messages */
@@ -2799,6 +3176,7 @@ static void appHfpHandleMessage(Task task, MessageId id, Message message)
              return;
 
         case HFP_VOICE_RECOGNITION_ENABLE_CFM:
+             appHfpAtCmdConfirm(id);
              appHfpHandleHfpVoiceRecognitionEnableConfirmation((HFP_VOICE_RECOGNITION_ENABLE_CFM_T *)message);
              return;
 
@@ -2819,10 +3197,12 @@ static void appHfpHandleMessage(Task task, MessageId id, Message message)
              return;
 
         case HFP_CALL_ANSWER_CFM:
+             appHfpAtCmdConfirm(id);
              appHfpHandleHfpCallAnswerConfirmation((HFP_CALL_ANSWER_CFM_T *)message); 
              return;                
         
         case HFP_CALL_TERMINATE_CFM:
+             appHfpAtCmdConfirm(id);
              appHfpHandleHfpCallTerminateConfirmation((HFP_CALL_TERMINATE_CFM_T *)message); 
              return;                
 
@@ -2834,9 +3214,12 @@ static void appHfpHandleMessage(Task task, MessageId id, Message message)
              appHfpHandleHfpUnrecognisedAtCmdInd((HFP_UNRECOGNISED_AT_CMD_IND_T*)message);
              return;
 
-        /* Handle additional messages */
         case HFP_HS_BUTTON_PRESS_CFM:
         case HFP_DIAL_LAST_NUMBER_CFM:
+             appHfpAtCmdConfirm(id);
+             return;
+
+        /* Handle additional messages */
         case HFP_SIGNAL_IND:
         case HFP_ROAM_IND:
         case HFP_BATTCHG_IND:
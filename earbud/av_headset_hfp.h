@@ -86,6 +86,54 @@ typedef enum
 
 struct appTaskData;
 
+/*! \brief Number of AT commands that can be queued waiting to be sent to the AG */
+#define HFP_AT_CMD_QUEUE_SIZE   (6)
+
+/*! \brief Scheduling priority of AT commands, highest first */
+typedef enum
+{
+    HFP_AT_CMD_PRIORITY_CALL,               /*!< Call control */
+    HFP_AT_CMD_PRIORITY_VOLUME,             /*!< Volume synchronisation */
+    HFP_AT_CMD_PRIORITY_VENDOR              /*!< Vendor commands from handset signalling */
+} hfpAtCmdPriority;
+
+/*! \brief Types of AT command sent through the AT command queue */
+typedef enum
+{
+    HFP_AT_CMD_NONE,
+    HFP_AT_CMD_CALL_ANSWER,                 /*!< Answer incoming call */
+    HFP_AT_CMD_CALL_REJECT,                 /*!< Reject incoming call */
+    HFP_AT_CMD_CALL_TERMINATE,              /*!< Terminate active or outgoing call */
+    HFP_AT_CMD_BUTTON_PRESS,                /*!< HSP button press */
+    HFP_AT_CMD_DIAL_LAST_NUMBER,            /*!< Last number redial */
+    HFP_AT_CMD_VOICE_RECOGNITION,           /*!< Enable or disable voice recognition */
+    HFP_AT_CMD_SPEAKER_GAIN,                /*!< Speaker gain synchronisation */
+    HFP_AT_CMD_MIC_GAIN,                    /*!< Microphone gain synchronisation */
+    HFP_AT_CMD_VENDOR,                      /*!< Vendor command */
+    HFP_AT_CMD_TYPE_COUNT
+} hfpAtCmdType;
+
+/*! \brief Entry in the AT command queue */
+typedef struct
+{
+    unsigned    type:4;                     /*!< Command type, \ref hfpAtCmdType */
+    unsigned    param:2;                    /*!< Voice recognition enable, or link priority for vendor commands */
+    char       *cmd;                        /*!< NULL terminated vendor command, owned by the queue */
+    uint32      queued_ms;                  /*!< Time the command was queued */
+} hfpAtCmd;
+
+/*! \brief Round-trip latency of an AT command type, from queuing to confirmation */
+typedef struct
+{
+    uint16      count;                      /*!< Number of commands completed */
+    uint16      dropped;                    /*!< Number of commands dropped as queue was full */
+    uint16      coalesced;                  /*!< Number of commands merged with one already queued */
+    uint16      timeouts;                   /*!< Number of commands not confirmed in time */
+    uint16      last_ms;                    /*!< Latency of the last command */
+    uint16      max_ms;                     /*!< Largest latency */
+    uint32      total_ms;                   /*!< Sum of latencies, for the mean */
+} hfpAtCmdLatency;
+
 /*! \brief HFP instance structure
 
     This structure contains all the information for an HFP connection.
@@ -128,6 +176,14 @@ typedef struct
     TaskList*   slc_status_notify_list;             /*!< List of tasks to notify of SLC connection status. */
     TaskList*   status_notify_list;                 /*!< List of tasks to notify of general HFP status changes */
     Task        at_cmd_task;                        /*!< Task to handle TWS+ AT commands. */
+
+    hfpAtCmd    at_queue[HFP_AT_CMD_QUEUE_SIZE];    /*!< AT commands waiting to be sent */
+    uint8       at_queue_len;                       /*!< Number of entries in at_queue */
+    hfpAtCmd    at_in_flight;                       /*!< AT command awaiting confirmation, type HFP_AT_CMD_NONE if none */
+    hfpAtCmdLatency at_latency[HFP_AT_CMD_TYPE_COUNT]; /*!< Latency of each AT command type */
+    uint8       at_stale_cfms[HFP_AT_CMD_TYPE_COUNT]; /*!< Confirmations still due for commands that timed out */
+    uint32      at_stale_ms;                        /*!< Time the last AT command timed out */
+    uint16      acl_handle;                         /*!< Connection manager handle (#conManagerHandle) of the AG link whilst connected */
 } hfpTaskData;
 
 /*! \brief HFP settings structure
@@ -159,7 +215,8 @@ enum
     HFP_INTERNAL_HFP_MUTE_REQ,					/*!< Internal message to mute an active call */
     HFP_INTERNAL_HFP_TRANSFER_REQ,				/*!< Internal message to transfer active call between AG and device */
     HFP_INTERNAL_VOLUME_UP,						/*!< Internal message to increase the volume on the active call */
-    HFP_INTERNAL_VOLUME_DOWN					/*!< Internal message to decrease the volume on the active call */
+    HFP_INTERNAL_VOLUME_DOWN,					/*!< Internal message to decrease the volume on the active call */
+    HFP_INTERNAL_AT_CMD_TIMEOUT					/*!< Internal message to indicate an AT command was not confirmed */
 };
 
 /*! \brief Message IDs from HFP to main application task */
@@ -326,6 +383,7 @@ extern void appHfpClientRegister(Task task);
 extern void appHfpSendAtCmdReq(hfp_link_priority priority, char* cmd);
 extern void appHfpRegisterAtCmdTask(Task task);
 extern void appHfpStatusClientRegister(Task task);
+extern bool appHfpGetAtCmdLatency(hfpAtCmdType type, hfpAtCmdLatency *latency);
 
 #else
 
@@ -86,6 +86,11 @@
 #define KYMERA_OP_MSG_ID_TONE_END (0x0001) /*!< Kymera ringtone generator TONE_END message */
 /*!@}*/
 
+/*!@{ \name Peer link report sent by the TWS slave on #PEER_SIG_MSG_CHANNEL_A2DP_FWD */
+#define KYMERA_FWD_MSG_LINK_REPORT (0x01)
+#define KYMERA_FWD_MSG_LINK_REPORT_SIZE (3)  /*!< Message ID, average RSSI, last RSSI */
+/*!@}*/
+
 /*@{ \name System kick periods, in microseconds */
 #define KICK_PERIOD_FAST (2000)
 #define KICK_PERIOD_SLOW (7500)
@@ -401,7 +406,8 @@ static void appKymeraExternalAmpControl(bool enable)
     }
 }
 
-static void appKymeraConfigureRtpDecoder(Operator op, rtp_codec_type_t codec_type, uint32 rate, bool cp_header_enabled)
+static void appKymeraConfigureRtpDecoder(Operator op, rtp_codec_type_t codec_type, uint32 rate,
+                                         bool cp_header_enabled, uint32 latency_us)
 {
     rtp_working_mode_t mode = (codec_type == rtp_codec_type_aptx && !cp_header_enabled) ?
                                     rtp_ttp_only : rtp_decode;
@@ -417,7 +423,7 @@ static void appKymeraConfigureRtpDecoder(Operator op, rtp_codec_type_t codec_typ
 
     OperatorsRtpSetCodecType(op, codec_type);
     OperatorsRtpSetWorkingMode(op, mode);
-    OperatorsStandardSetTimeToPlayLatency(op, TWS_STANDARD_LATENCY_US);
+    OperatorsStandardSetTimeToPlayLatency(op, latency_us);
     OperatorsStandardSetBufferSize(op, PRE_DECODER_BUFFER_SIZE);
     OperatorsRtpSetContentProtection(op, cp_header_enabled);
     /* Sending this message trashes the RTP operator sample rate */
@@ -672,7 +678,8 @@ static bool appKymeraA2dpStartMaster(const a2dp_codec_settings *codec_settings,
                     appKymeraSetLowPowerSBCParams(chain_handle, rate);
                 break;
             }
-            appKymeraConfigureRtpDecoder(op_rtp_decoder, rtp_codec, rate, cp_header_enabled);
+            appKymeraConfigureRtpDecoder(op_rtp_decoder, rtp_codec, rate, cp_header_enabled,
+                                         US_PER_MS * appKymeraA2dpLatencyMs(theKymera->latency_mode));
             ChainConnect(theKymera->chain_input_handle);
         }
         return FALSE;
@@ -680,16 +687,32 @@ static bool appKymeraA2dpStartMaster(const a2dp_codec_settings *codec_settings,
         case KYMERA_STATE_A2DP_STARTING_C:
         {
             unsigned kick_period = KICK_PERIOD_FAST;
+            unsigned buffer_size = PCM_LATENCY_BUFFER_SIZE;
             uint8 volume_config = appConfigEnableSoftVolumeRampOnStart() ? 0 : volume;
-            DEBUG_LOG("appKymeraA2dpStartMaster, creating output chain, completing startup");
+            DEBUG_LOGF("appKymeraA2dpStartMaster, creating output chain, completing startup, latency mode %u",
+                       theKymera->latency_mode);
             switch (seid)
             {
                 case AV_SEID_SBC_SNK:  kick_period = KICK_PERIOD_MASTER_SBC;  break;
                 case AV_SEID_AAC_SNK:  kick_period = KICK_PERIOD_MASTER_AAC;  break;
                 case AV_SEID_APTX_SNK: kick_period = KICK_PERIOD_MASTER_APTX; break;
             }
+            switch (theKymera->latency_mode)
+            {
+                case KYMERA_LATENCY_LOW:
+                    /* AAC frames are too long to benefit from the fast kick period */
+                    if (seid != AV_SEID_AAC_SNK)
+                        kick_period = KICK_PERIOD_FAST;
+                    buffer_size = MS_TO_BUFFER_SIZE_MONO_PCM(PCM_LOW_LATENCY_BUFFER_MS, MAX_SAMPLE_RATE);
+                break;
+                case KYMERA_LATENCY_ROBUST:
+                    buffer_size = MS_TO_BUFFER_SIZE_MONO_PCM(PCM_ROBUST_LATENCY_BUFFER_MS, MAX_SAMPLE_RATE);
+                break;
+                default:
+                break;
+            }
             OperatorsFrameworkSetKickPeriod(kick_period);
-            appKymeraCreateOutputChain(rate, kick_period, PCM_LATENCY_BUFFER_SIZE, volume_config);
+            appKymeraCreateOutputChain(rate, kick_period, buffer_size, volume_config);
 
             /* Connect input and output chains together */
             ChainConnectInput(theKymera->chain_output_vol_handle,
@@ -774,6 +797,153 @@ static void appKymeraA2dpCommonStop(Source source)
     }
 }
 
+uint16 appKymeraA2dpLatencyMs(kymeraLatencyMode latency_mode)
+{
+    switch (latency_mode)
+    {
+        case KYMERA_LATENCY_LOW:
+            return PRE_DECODER_BUFFER_MS + PCM_LOW_LATENCY_BUFFER_MS;
+        case KYMERA_LATENCY_ROBUST:
+            return PRE_DECODER_BUFFER_MS + PCM_ROBUST_LATENCY_BUFFER_MS;
+        default:
+            return TWS_STANDARD_LATENCY_MS;
+    }
+}
+
+bool appKymeraA2dpForwardingWasRobust(void)
+{
+    return appGetKymera()->forwarding_robust_seen;
+}
+
+/* Configure the forwarding SBC encoder, capping the bitpool for robust forwarding */
+static void appKymeraSetForwardingSbcParams(kymera_chain_handle_t chain)
+{
+    kymeraTaskData *theKymera = appGetKymera();
+    sbc_encoder_params_t sbc_encoder_params = theKymera->forwarding_sbc_params;
+    Operator op;
+
+    if ((theKymera->forwarding_quality == KYMERA_FORWARDING_QUALITY_ROBUST) &&
+        (sbc_encoder_params.bitpool_size > appConfigTwsRobustBitpool()))
+    {
+        sbc_encoder_params.bitpool_size = appConfigTwsRobustBitpool();
+    }
+    if (GET_OP_FROM_CHAIN(op, chain, OPR_SBC_ENCODER))
+    {
+        OperatorsSbcEncoderSetEncodingParams(op, &sbc_encoder_params);
+    }
+}
+
+void appKymeraA2dpForwardingLinkReport(int8 rssi)
+{
+    kymeraTaskData *theKymera = appGetKymera();
+    kymeraForwardingQuality quality = theKymera->forwarding_quality;
+
+    theKymera->forwarding_reports++;
+
+    if (rssi < appConfigTwsForwardingRobustRssi())
+        quality = KYMERA_FORWARDING_QUALITY_ROBUST;
+    else if (rssi >= appConfigTwsForwardingRobustRssi() + appConfigTwsForwardingRobustHysteresis())
+        quality = KYMERA_FORWARDING_QUALITY_NORMAL;
+
+    if (quality == KYMERA_FORWARDING_QUALITY_ROBUST)
+        theKymera->forwarding_robust_seen = TRUE;
+
+    if (quality == theKymera->forwarding_quality)
+        return;
+
+    DEBUG_LOGF("appKymeraA2dpForwardingLinkReport, quality %u, rssi %d", quality, rssi);
+    theKymera->forwarding_quality = quality;
+    theKymera->forwarding_quality_changes++;
+
+    /* The bitpool can change while forwarding, the packetiser keeps its
+       settings until forwarding restarts */
+    if ((theKymera->state == KYMERA_STATE_A2DP_STREAMING_WITH_FORWARDING) &&
+        theKymera->forwarding_sbc_params.bitpool_size)
+    {
+        appKymeraSetForwardingSbcParams(theKymera->chain_input_handle);
+    }
+}
+
+/* Start sending peer link reports to the master, while receiving forwarded audio */
+static void appKymeraForwardingReportStart(void)
+{
+    kymeraTaskData *theKymera = appGetKymera();
+    conManagerLinkStats stats;
+    uint16 supervision_timeouts;
+    bdaddr peer_addr;
+
+    theKymera->report_rssi_sum = 0;
+    theKymera->report_rssi_samples = 0;
+    if (appDeviceGetPeerBdAddr(&peer_addr) &&
+        appConManagerGetLinkStats(&peer_addr, &stats, &supervision_timeouts))
+    {
+        theKymera->report_rssi_sum = stats.rssi_sum;
+        theKymera->report_rssi_samples = stats.rssi_samples;
+    }
+
+    MessageCancelAll(&theKymera->task, KYMERA_INTERNAL_FORWARDING_REPORT);
+    if (appConfigTwsForwardingReportMs())
+    {
+        MessageSendLater(&theKymera->task, KYMERA_INTERNAL_FORWARDING_REPORT, NULL,
+                         appConfigTwsForwardingReportMs());
+    }
+}
+
+/* Send the average peer link RSSI since the last report to the master */
+static void appKymeraHandleInternalForwardingReport(void)
+{
+    kymeraTaskData *theKymera = appGetKymera();
+    conManagerLinkStats stats;
+    uint16 supervision_timeouts;
+    bdaddr peer_addr;
+
+    if ((theKymera->state != KYMERA_STATE_A2DP_STREAMING) ||
+        !appA2dpIsSeidTwsSink(theKymera->a2dp_seid) ||
+        !appDeviceGetPeerBdAddr(&peer_addr))
+    {
+        return;
+    }
+
+    if (appConManagerGetLinkStats(&peer_addr, &stats, &supervision_timeouts))
+    {
+        /* Statistics restart with a new ACL */
+        if (stats.rssi_samples < theKymera->report_rssi_samples)
+        {
+            theKymera->report_rssi_sum = 0;
+            theKymera->report_rssi_samples = 0;
+        }
+        if (stats.rssi_samples > theKymera->report_rssi_samples)
+        {
+            int32 rssi_avg = (stats.rssi_sum - theKymera->report_rssi_sum) /
+                             (stats.rssi_samples - theKymera->report_rssi_samples);
+            uint8 report[KYMERA_FWD_MSG_LINK_REPORT_SIZE];
+
+            report[0] = KYMERA_FWD_MSG_LINK_REPORT;
+            report[1] = (uint8)(int8)rssi_avg;
+            report[2] = (uint8)stats.rssi_last;
+            appPeerSigMsgChannelTxRequest(&theKymera->task, &peer_addr,
+                                          PEER_SIG_MSG_CHANNEL_A2DP_FWD,
+                                          report, sizeof(report));
+            theKymera->forwarding_reports++;
+            theKymera->report_rssi_sum = stats.rssi_sum;
+            theKymera->report_rssi_samples = stats.rssi_samples;
+        }
+    }
+
+    MessageSendLater(&theKymera->task, KYMERA_INTERNAL_FORWARDING_REPORT, NULL,
+                     appConfigTwsForwardingReportMs());
+}
+
+/* Handle a peer link report from the slave */
+static void appKymeraHandlePeerSigMsgChannelRxInd(const PEER_SIG_MSG_CHANNEL_RX_IND_T *ind)
+{
+    if ((ind->msg_size >= KYMERA_FWD_MSG_LINK_REPORT_SIZE) &&
+        (ind->msg[0] == KYMERA_FWD_MSG_LINK_REPORT))
+    {
+        appKymeraA2dpForwardingLinkReport((int8)ind->msg[1]);
+    }
+}
+
 static void appKymeraA2dpStartForwarding(const a2dp_codec_settings *codec_settings)
 {
     kymeraTaskData *theKymera = appGetKymera();
@@ -786,6 +956,8 @@ static void appKymeraA2dpStartForwarding(const a2dp_codec_settings *codec_settin
     uint8 seid;
     Sink sink;
     kymera_chain_handle_t inchain = theKymera->chain_input_handle;
+    uint32 time_before_tx = appConfigTwsTimeBeforeTx();
+    uint32 deadline = appConfigTwsDeadline();
 
     appKymeraGetA2dpCodecSettingsCore(codec_settings, &seid, &sink, NULL, &cp_enabled, &mtu);
     appKymeraGetA2dpCodecSettingsSBC(codec_settings, &sbc_encoder_params);
@@ -800,8 +972,8 @@ static void appKymeraA2dpStartForwarding(const a2dp_codec_settings *codec_settin
 
         case AV_SEID_SBC_MONO_TWS_SRC:
         {
-            Operator sbc_encoder= ChainGetOperatorByRole(inchain, OPR_SBC_ENCODER);
-            OperatorsSbcEncoderSetEncodingParams(sbc_encoder, &sbc_encoder_params);
+            theKymera->forwarding_sbc_params = sbc_encoder_params;
+            appKymeraSetForwardingSbcParams(inchain);
             p0_codec = VM_TRANSFORM_PACKETISE_CODEC_SBC;
         }
         break;
@@ -819,12 +991,29 @@ static void appKymeraA2dpStartForwarding(const a2dp_codec_settings *codec_settin
         break;
     }
 
+    if (theKymera->forwarding_quality == KYMERA_FORWARDING_QUALITY_ROBUST)
+    {
+        time_before_tx = appConfigTwsRobustTimeBeforeTx();
+        deadline = appConfigTwsRobustDeadline();
+        if (mtu > appConfigTwsRobustMtu())
+            mtu = appConfigTwsRobustMtu();
+    }
+    /* Keep the packetiser timing within the TTP latency */
+    if ((time_before_tx >= US_PER_MS * appKymeraA2dpLatencyMs(theKymera->latency_mode)) ||
+        (deadline >= time_before_tx))
+    {
+        time_before_tx = appConfigTwsTimeBeforeTx();
+        deadline = appConfigTwsDeadline();
+    }
+    DEBUG_LOGF("appKymeraA2dpStartForwarding, quality %u, mtu %u, time before tx %lu, deadline %lu",
+               theKymera->forwarding_quality, mtu, time_before_tx, deadline);
+
     theKymera->packetiser = TransformPacketise(audio_source, sink);
     TransformConfigure(theKymera->packetiser, VM_TRANSFORM_PACKETISE_CODEC, p0_codec);
     TransformConfigure(theKymera->packetiser, VM_TRANSFORM_PACKETISE_MODE, mode);
     TransformConfigure(theKymera->packetiser, VM_TRANSFORM_PACKETISE_MTU, mtu);
-    TransformConfigure(theKymera->packetiser, VM_TRANSFORM_PACKETISE_TIME_BEFORE_TTP, appConfigTwsTimeBeforeTx() / 1000);
-    TransformConfigure(theKymera->packetiser, VM_TRANSFORM_PACKETISE_LATEST_TIME_BEFORE_TTP, appConfigTwsDeadline() / 1000);
+    TransformConfigure(theKymera->packetiser, VM_TRANSFORM_PACKETISE_TIME_BEFORE_TTP, time_before_tx / 1000);
+    TransformConfigure(theKymera->packetiser, VM_TRANSFORM_PACKETISE_LATEST_TIME_BEFORE_TTP, deadline / 1000);
     TransformConfigure(theKymera->packetiser, VM_TRANSFORM_PACKETISE_CPENABLE, cp_enabled);
     TransformStart(theKymera->packetiser);
 
@@ -861,6 +1050,7 @@ static void appKymeraA2dpStopForwarding(void)
         theKymera->packetiser = NULL;
     }
 
+    theKymera->forwarding_sbc_params.bitpool_size = 0;
     appKymeraSetLowPowerSBCParams(inchain, theKymera->output_rate);
 }
 
@@ -1010,6 +1200,8 @@ static void appKymeraHandleInternalA2dpStart(const KYMERA_INTERNAL_A2DP_START_T
                 appKymeraPreStartSanity(theKymera);
                 theKymera->output_rate = rate;
                 theKymera->a2dp_seid = seid;
+                theKymera->latency_mode = msg->latency_mode;
+                theKymera->forwarding_robust_seen = FALSE;
                 theKymera->state = KYMERA_STATE_A2DP_STARTING_A;
             }
             // fall-through
@@ -1042,6 +1234,7 @@ static void appKymeraHandleInternalA2dpStart(const KYMERA_INTERNAL_A2DP_START_T
         theKymera->state = KYMERA_STATE_A2DP_STREAMING;
         theKymera->output_rate = rate;
         theKymera->a2dp_seid = seid;
+        appKymeraForwardingReportStart();
     }
     else if (appA2dpIsSeidSource(seid))
     {
@@ -1123,6 +1316,7 @@ static void appKymeraHandleInternalA2dpSetVolume(uint16 volume)
         case KYMERA_STATE_A2DP_STREAMING:
         case KYMERA_STATE_A2DP_STREAMING_WITH_FORWARDING:
             appKymeraSetMainVolume(theKymera->chain_output_vol_handle, volume);
+            theKymera->volume_updates++;
             break;
 
         default:
@@ -1666,6 +1860,7 @@ static void appKymeraHandleInternalScoSetVolume(uint8 volume)
         {
             uint16 volume_scaled = ((uint16)volume * 127) / 15;
             appKymeraSetMainVolume(theKymera->chain_sco_handle, volume_scaled);
+            theKymera->volume_updates++;
         }
         break;
 
@@ -1870,7 +2065,8 @@ static void appKymeraToneStop(void)
 }
 
 void appKymeraA2dpStart(Task task, const a2dp_codec_settings *codec_settings,
-                        uint8 volume, uint8 master_pre_start_delay)
+                        uint8 volume, uint8 master_pre_start_delay,
+                        kymeraLatencyMode latency_mode)
 {
     kymeraTaskData *theKymera = appGetKymera();
 
@@ -1881,6 +2077,7 @@ void appKymeraA2dpStart(Task task, const a2dp_codec_settings *codec_settings,
     message->codec_settings = *codec_settings;
     message->volume = volume;
     message->master_pre_start_delay = master_pre_start_delay;
+    message->latency_mode = latency_mode;
     MessageSendConditionally(&theKymera->task, KYMERA_INTERNAL_A2DP_START,
                              message, &theKymera->lock);
 }
@@ -1929,16 +2126,71 @@ bool appKymeraScoStopForwarding(void)
     return TRUE;
 }
 
+/*! \brief Send the latest A2DP and/or SCO volume to the volume operators.
+
+    Any update still queued behind the lock is replaced, so only the latest
+    volume is applied.
+*/
+static void appKymeraVolumeSend(kymeraVolumePending pending)
+{
+    kymeraTaskData *theKymera = appGetKymera();
+
+    if (pending & KYMERA_VOLUME_PENDING_A2DP)
+    {
+        MAKE_KYMERA_MESSAGE(KYMERA_INTERNAL_A2DP_SET_VOL);
+        message->volume = theKymera->a2dp_volume;
+        MessageCancelAll(&theKymera->task, KYMERA_INTERNAL_A2DP_SET_VOL);
+        MessageSendConditionally(&theKymera->task, KYMERA_INTERNAL_A2DP_SET_VOL, message, &theKymera->lock);
+    }
+    if (pending & KYMERA_VOLUME_PENDING_SCO)
+    {
+        MAKE_KYMERA_MESSAGE(KYMERA_INTERNAL_SCO_SET_VOL);
+        message->volume = theKymera->sco_volume;
+        MessageCancelAll(&theKymera->task, KYMERA_INTERNAL_SCO_SET_VOL);
+        MessageSendConditionally(&theKymera->task, KYMERA_INTERNAL_SCO_SET_VOL, message, &theKymera->lock);
+    }
+}
+
+/*! \brief Request a volume update.
+
+    The first change is sent immediately, further changes within
+    #appConfigVolumeUpdateIntervalMs are merged and sent when the interval
+    expires. The volume operator ramps to each new gain.
+*/
+static void appKymeraVolumeRequest(kymeraVolumePending pending)
+{
+    kymeraTaskData *theKymera = appGetKymera();
+
+    if (MessagePendingFirst(&theKymera->task, KYMERA_INTERNAL_VOLUME_TICK, NULL))
+        theKymera->volume_pending |= pending;
+    else
+    {
+        appKymeraVolumeSend(pending);
+        MessageSendLater(&theKymera->task, KYMERA_INTERNAL_VOLUME_TICK, NULL, appConfigVolumeUpdateIntervalMs());
+    }
+}
+
+/*! \brief Send volume changes merged during the last interval. */
+static void appKymeraHandleInternalVolumeTick(void)
+{
+    kymeraTaskData *theKymera = appGetKymera();
+
+    if (theKymera->volume_pending)
+    {
+        appKymeraVolumeSend(theKymera->volume_pending);
+        theKymera->volume_pending = 0;
+        MessageSendLater(&theKymera->task, KYMERA_INTERNAL_VOLUME_TICK, NULL, appConfigVolumeUpdateIntervalMs());
+    }
+}
+
 void appKymeraA2dpSetVolume(uint16 volume)
 {
     kymeraTaskData *theKymera = appGetKymera();
 
     DEBUG_LOGF("appKymeraA2dpSetVolume msg, vol %u", volume);
 
-    MAKE_KYMERA_MESSAGE(KYMERA_INTERNAL_A2DP_SET_VOL);
-    message->volume = volume;
-
-    MessageSendConditionally(&theKymera->task, KYMERA_INTERNAL_A2DP_SET_VOL, message, &theKymera->lock);
+    theKymera->a2dp_volume = volume;
+    appKymeraVolumeRequest(KYMERA_VOLUME_PENDING_A2DP);
 }
 
 static void appKymeraScoStartHelper(Sink audio_sink, hfp_wbs_codec_mask codec, uint8 wesco,
@@ -2009,10 +2261,8 @@ void appKymeraScoSetVolume(uint8 volume)
 
     DEBUG_LOGF("appKymeraScoSetVolume msg, vol %u", volume);
 
-    MAKE_KYMERA_MESSAGE(KYMERA_INTERNAL_SCO_SET_VOL);
-    message->volume = volume;
-
-    MessageSendConditionally(&theKymera->task, KYMERA_INTERNAL_SCO_SET_VOL, message, &theKymera->lock);
+    theKymera->sco_volume = volume;
+    appKymeraVolumeRequest(KYMERA_VOLUME_PENDING_SCO);
 }
 
 void appKymeraScoMicMute(bool mute)
@@ -2066,6 +2316,18 @@ static void kymera_msg_handler(Task task, MessageId id, Message msg)
         }
         break;
 
+        case KYMERA_INTERNAL_FORWARDING_REPORT:
+            appKymeraHandleInternalForwardingReport();
+        break;
+
+        case PEER_SIG_MSG_CHANNEL_RX_IND:
+            appKymeraHandlePeerSigMsgChannelRxInd((const PEER_SIG_MSG_CHANNEL_RX_IND_T *)msg);
+        break;
+
+        case KYMERA_INTERNAL_VOLUME_TICK:
+            appKymeraHandleInternalVolumeTick();
+        break;
+
         case KYMERA_INTERNAL_SCO_START:
         {
             const KYMERA_INTERNAL_SCO_START_T *m = (const KYMERA_INTERNAL_SCO_START_T *)msg;
@@ -2157,7 +2419,18 @@ void appKymeraInit(void)
     theKymera->output_rate = 0;
     theKymera->lock = 0;
     theKymera->a2dp_seid = AV_SEID_INVALID;
+    theKymera->volume_pending = 0;
+    theKymera->volume_updates = 0;
+    theKymera->forwarding_quality = KYMERA_FORWARDING_QUALITY_NORMAL;
+    theKymera->forwarding_quality_changes = 0;
+    theKymera->forwarding_reports = 0;
+    theKymera->forwarding_robust_seen = FALSE;
+    theKymera->latency_mode = KYMERA_LATENCY_NORMAL;
+    theKymera->forwarding_sbc_params.bitpool_size = 0;
     appKymeraExternalAmpSetup();
+
+    /* Register a channel for forwarding link reports from the slave */
+    appPeerSigMsgChannelTaskRegister(&theKymera->task, PEER_SIG_MSG_CHANNEL_A2DP_FWD);
 #if defined(INCLUDE_SCOFWD) && defined(SFWD_USING_SQIF)
     UNUSED(bundle_config);
     ChainSetDownloadableCapabilityBundleConfig(NULL);
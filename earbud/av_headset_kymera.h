@@ -12,6 +12,7 @@
 #define AV_HEADSET_KYMERA_H
 
 #include <chain.h>
+#include <operators.h>
 #include <transform.h>
 
 #include "av_headset.h"
@@ -40,6 +41,28 @@ typedef enum app_kymera_states
 } appKymeraState;
 
 
+/*! \brief Quality of A2DP forwarded to the TWS slave, chosen by the master
+    from the peer link reports sent by the slave. */
+typedef enum
+{
+    /*! Forward with the negotiated bitpool and MTU, and the default packetiser timing. */
+    KYMERA_FORWARDING_QUALITY_NORMAL,
+    /*! Forward with a lower bitpool, smaller packets and more time to retransmit. */
+    KYMERA_FORWARDING_QUALITY_ROBUST,
+} kymeraForwardingQuality;
+
+/*! \brief Output latency of A2DP audio, choosing the TTP target, PCM
+    buffering and kick period. */
+typedef enum
+{
+    /*! TWS standard latency. */
+    KYMERA_LATENCY_NORMAL,
+    /*! Low latency, e.g. for gaming. */
+    KYMERA_LATENCY_LOW,
+    /*! Extra buffering, for congested RF. */
+    KYMERA_LATENCY_ROBUST,
+} kymeraLatencyMode;
+
 /*! \brief Kymera instance structure.
 
     This structure contains all the information for Kymera audio chains.
@@ -78,6 +101,33 @@ typedef struct
     /*! The current A2DP stream endpoint identifier. */
     uint8  a2dp_seid;
 
+    /*! The latest requested A2DP volume. */
+    uint16 a2dp_volume;
+    /*! The latest requested SCO volume. */
+    uint8  sco_volume;
+    /*! Volume updates waiting for #KYMERA_INTERNAL_VOLUME_TICK, see #kymeraVolumePending. */
+    unsigned volume_pending:2;
+    /*! Number of gain updates made to volume operators. */
+    uint16 volume_updates;
+
+    /*! Forwarding quality, see #kymeraForwardingQuality. */
+    unsigned forwarding_quality:1;
+    /*! Number of forwarding quality changes. */
+    uint16 forwarding_quality_changes;
+    /*! Number of peer link reports sent (slave) or received (master). */
+    uint16 forwarding_reports;
+    /*! Forwarding quality was robust at some point since A2DP started. */
+    unsigned forwarding_robust_seen:1;
+    /*! Output latency of the current A2DP stream, see #kymeraLatencyMode. */
+    unsigned latency_mode:2;
+    /*! SBC encoder parameters negotiated for forwarding, bitpool_size is zero
+        when not forwarding SBC. */
+    sbc_encoder_params_t forwarding_sbc_params;
+    /*! Peer link RSSI sum at the last report sent by the slave. */
+    int32 report_rssi_sum;
+    /*! Peer link RSSI sample count at the last report sent by the slave. */
+    uint16 report_rssi_samples;
+
 } kymeraTaskData;
 
 /*! \brief Internal message IDs */
@@ -107,8 +157,19 @@ enum app_kymera_internal_message_ids
     KYMERA_INTERNAL_SCOFWD_RX_STOP,
     /*! Internal tone play message. */
     KYMERA_INTERNAL_TONE_PLAY,
+    /*! Internal message to apply volume changes merged since the last update. */
+    KYMERA_INTERNAL_VOLUME_TICK,
+    /*! Internal message to send the TWS slave's peer link report to the master. */
+    KYMERA_INTERNAL_FORWARDING_REPORT,
 };
 
+/*! \brief Volume updates waiting to be sent to the volume operator. */
+typedef enum
+{
+    KYMERA_VOLUME_PENDING_A2DP = 1 << 0,
+    KYMERA_VOLUME_PENDING_SCO  = 1 << 1
+} kymeraVolumePending;
+
 /*! \brief External message IDs */
 typedef enum app_kymera_external_message_ids
 {
@@ -134,6 +195,9 @@ typedef struct
         proceeding to commence starting kymera. Starting will commence when received
         with value 0. Only applies to starting the master. */
     uint8 master_pre_start_delay;
+    /*! The output latency. Only applies to starting the master, the slave
+        plays at the time to play sent by the master. */
+    kymeraLatencyMode latency_mode;
 } KYMERA_INTERNAL_A2DP_START_T;
 
 
@@ -226,10 +290,24 @@ typedef struct
     want to be blocked by the starting of kymera. This delay is only applied
     when starting the 'master' (a non-TWS sink SEID).
 
+    \param latency_mode The output latency, see #kymeraLatencyMode.
+
     \note The client task will receive a #KYMERA_A2DP_START_CFM on kymera start completion.
 */
 void appKymeraA2dpStart(Task task, const a2dp_codec_settings *codec_settings,
-                        uint8 volume, uint8 master_pre_start_delay);
+                        uint8 volume, uint8 master_pre_start_delay,
+                        kymeraLatencyMode latency_mode);
+
+/*! \brief Get the A2DP output latency (time to play) of a latency mode.
+    \param latency_mode The output latency mode.
+    \return The latency in milliseconds.
+*/
+uint16 appKymeraA2dpLatencyMs(kymeraLatencyMode latency_mode);
+
+/*! \brief Check if A2DP forwarding needed robust quality since A2DP started.
+    \return TRUE if a peer link report chose robust forwarding.
+*/
+bool appKymeraA2dpForwardingWasRobust(void);
 
 /*! \brief Stop streaming A2DP audio.
     \param task The client task.
@@ -245,6 +323,16 @@ void appKymeraA2dpStop(Task task, uint8 seid, Source source);
 */
 void appKymeraA2dpSetVolume(uint16 volume);
 
+/*! \brief Handle a peer link report from the TWS slave.
+    \param rssi Average RSSI of the peer link measured by the slave since its
+           last report.
+
+    Chooses the forwarding quality, a change in bitpool is applied to the
+    running SBC encoder, packetiser timing and MTU apply from the next start
+    of forwarding.
+*/
+void appKymeraA2dpForwardingLinkReport(int8 rssi);
+
 /*! \brief Start SCO audio.
     \param audio_sink The SCO audio sink.
     \param codec WB-Speech codec bit masks.
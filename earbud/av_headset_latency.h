@@ -33,4 +33,10 @@ slave.
     amount of buffering required pre-decoder. */
 #define PRE_DECODER_BUFFER_MS (TWS_STANDARD_LATENCY_MS - PCM_LATENCY_BUFFER_MS)
 
+/*! The PCM buffer latency in low latency mode, used for gaming content. The
+    pre-decoder buffering is unchanged. */
+#define PCM_LOW_LATENCY_BUFFER_MS (100)
+/*! The PCM buffer latency in robust mode, used for congested RF. */
+#define PCM_ROBUST_LATENCY_BUFFER_MS (350)
+
 #endif // AV_HEADSET_LATENCY_H
@@ -22,6 +22,13 @@
  */
 #define MAKE_PRIM_C(TYPE) MESSAGE_MAKE(prim,TYPE##_T); prim->common.op_code = TYPE; prim->common.length = sizeof(TYPE##_T);
 
+/*! Link policy internal messages */
+enum
+{
+    LP_INTERNAL_TRAFFIC_TIMEOUT = INTERNAL_MESSAGE_BASE,  /*!< End of a traffic counting window */
+    LP_INTERNAL_ROLE_CHECK,                               /*!< Re-check link roles after deferring a role switch */
+};
+
 /*! Lower power table for A2DP */
 static const lp_power_table powertable_a2dp[]=
 {
@@ -98,6 +105,28 @@ static const lp_power_table powertable_avrcp[]=
     {lp_sniff,      48,           800,          2,       4,       0}   /* Enter sniff mode*/
 };
 
+/*! Power table for a link with a burst of control traffic */
+static const lp_power_table powertable_traffic_burst[]=
+{
+    /* mode,        min_interval, max_interval, attempt, timeout, duration */
+    {lp_active,     0,            0,            0,       0,       2},  /* Active mode for 2 seconds */
+    {lp_sniff,      48,           144,          4,       4,       0}   /* Enter sniff mode (30-90ms)*/
+};
+
+/*! Power table for a link that has been quiet for a while */
+static const lp_power_table powertable_traffic_quiet[]=
+{
+    /* mode,        min_interval, max_interval, attempt, timeout, duration */
+    {lp_sniff,      400,          800,          2,       2,       0}   /* Enter sniff mode (250-500ms)*/
+};
+
+/*! Power table for a link that has been quiet for a long time */
+static const lp_power_table powertable_traffic_idle[]=
+{
+    /* mode,        min_interval, max_interval, attempt, timeout, duration */
+    {lp_sniff,      800,          800,          1,       0,       0}   /* Enter sniff mode (500ms)*/
+};
+
 /*! \cond helper */
 #define ARRAY_AND_DIM(ARRAY) (ARRAY), ARRAY_DIM(ARRAY)
 /*! \endcond helper */
@@ -134,6 +163,37 @@ static const struct powertable_data powertables_twsplus[] = {
     [POWERTABLE_PEER_FORWARDING] =         {ARRAY_AND_DIM(powertable_a2dp_streaming_sink)},
 };
 
+/*! Array of structs used to store the traffic adapted power tables, the
+    normal level uses the standard or TWS+ table for the activity */
+static const struct powertable_data powertables_traffic[] = {
+    [LP_TRAFFIC_NORMAL] =                  {NULL, 0},
+    [LP_TRAFFIC_QUIET] =                   {ARRAY_AND_DIM(powertable_traffic_quiet)},
+    [LP_TRAFFIC_IDLE] =                    {ARRAY_AND_DIM(powertable_traffic_idle)},
+    [LP_TRAFFIC_BURST] =                   {ARRAY_AND_DIM(powertable_traffic_burst)},
+};
+
+/*! \brief Check if a power table has its sniff parameters adapted to traffic
+
+    Only links carrying signalling are adapted, streaming and SCO links
+    have their sniff parameters fixed by the audio traffic.
+*/
+static bool appLinkPolicyIsTrafficAdaptive(lpPowerTableIndex pt_index)
+{
+    return (pt_index == POWERTABLE_A2DP) ||
+           (pt_index == POWERTABLE_HFP) ||
+           (pt_index == POWERTABLE_AVRCP);
+}
+
+/*! \brief Start the traffic window timer if not already running */
+static void appLinkPolicyStartTrafficTimer(void)
+{
+    lpTaskData *theLp = appGetLp();
+
+    if (!MessagePendingFirst(&theLp->task, LP_INTERNAL_TRAFFIC_TIMEOUT, NULL))
+        MessageSendLater(&theLp->task, LP_INTERNAL_TRAFFIC_TIMEOUT, NULL,
+                         appConfigLinkPolicyTrafficWindowMs());
+}
+
 /* \brief Re-check and select link settings to reduce power consumption 
         where possible
 
@@ -214,24 +274,163 @@ void appLinkPolicyUpdatePowerTable(const bdaddr *bd_addr)
 #endif
 
     appConManagerGetLpState(bd_addr, &lp_state);
-    if ((pt_index != lp_state.pt_index) && sink && (pt_index < POWERTABLE_UNASSIGNED))
+    if (sink && (pt_index < POWERTABLE_UNASSIGNED))
     {
-        const struct powertable_data *selected = appDeviceIsTwsPlusHandset(bd_addr) ?
-                                                    &powertables_twsplus[pt_index] :
-                                                    &powertables_standard[pt_index];
-        ConnectionSetLinkPolicy(sink, selected->rows, selected->table);
-        if(appDeviceIsPeer(bd_addr))
+        lpTrafficLevel traffic;
+
+        /* Restart traffic tracking when the activity changes */
+        if (pt_index != lp_state.pt_index)
         {
-            DEBUG_LOGF("appLinkPolicyUpdatePowerTable for peer, index=%d, prev=%d", pt_index, lp_state.pt_index);
+            lp_state.traffic = LP_TRAFFIC_NORMAL;
+            lp_state.quiet_windows = 0;
         }
+        if (lp_state.active)
+            traffic = LP_TRAFFIC_BURST;
         else
+            traffic = appLinkPolicyIsTrafficAdaptive(pt_index) ? (lpTrafficLevel)lp_state.traffic : LP_TRAFFIC_NORMAL;
+
+        if ((pt_index != lp_state.pt_index) || (traffic != lp_state.applied))
         {
-            DEBUG_LOGF("appLinkPolicyUpdatePowerTable, index=%d, prev=%d", pt_index, lp_state.pt_index);
+            const struct powertable_data *selected;
+
+            if (traffic != LP_TRAFFIC_NORMAL)
+                selected = &powertables_traffic[traffic];
+            else
+                selected = appDeviceIsTwsPlusHandset(bd_addr) ?
+                                &powertables_twsplus[pt_index] :
+                                &powertables_standard[pt_index];
+            ConnectionSetLinkPolicy(sink, selected->rows, selected->table);
+            if(appDeviceIsPeer(bd_addr))
+            {
+                DEBUG_LOGF("appLinkPolicyUpdatePowerTable for peer, index=%d, prev=%d, traffic=%d",
+                           pt_index, lp_state.pt_index, traffic);
+            }
+            else
+            {
+                DEBUG_LOGF("appLinkPolicyUpdatePowerTable, index=%d, prev=%d, traffic=%d",
+                           pt_index, lp_state.pt_index, traffic);
+            }
+
+            lp_state.pt_index = pt_index;
+            lp_state.applied = traffic;
+            appConManagerSetLpState(bd_addr, &lp_state);
+
+            if (traffic != LP_TRAFFIC_IDLE && !lp_state.active && appLinkPolicyIsTrafficAdaptive(pt_index))
+                appLinkPolicyStartTrafficTimer();
         }
+    }
+}
 
-        lp_state.pt_index = pt_index;
-        appConManagerSetLpState(bd_addr, &lp_state);
+/*! \brief Report link traffic
+
+    Count the activity against the link, a burst of activity within a
+    traffic window switches the link to the burst power table immediately.
+    Activity on a link that has backed off returns it to the normal power
+    table.
+
+    \param handle    Connection manager handle of the link the traffic was for
+    \param activity  Source of the traffic
+*/
+void appLinkPolicyNotifyActivity(conManagerHandle handle, lpActivity activity)
+{
+    lpPerConnectionState lp_state;
+    lpTrafficLevel traffic;
+    bdaddr bd_addr;
+
+    if (!appConManagerIsConnectedByHandle(handle))
+        return;
+
+    appConManagerGetLpStateByHandle(handle, &lp_state);
+    if (lp_state.events < 0x3F)
+        lp_state.events++;
+    lp_state.quiet_windows = 0;
+
+    traffic = (lpTrafficLevel)lp_state.traffic;
+    if (lp_state.events >= appConfigLinkPolicyTrafficBurstEvents())
+        lp_state.traffic = LP_TRAFFIC_BURST;
+    else if (lp_state.traffic != LP_TRAFFIC_BURST)
+        lp_state.traffic = LP_TRAFFIC_NORMAL;
+    appConManagerSetLpStateByHandle(handle, &lp_state);
+
+    if (traffic != lp_state.traffic)
+    {
+        DEBUG_LOGF("appLinkPolicyNotifyActivity, activity=%d, traffic=%d", activity, lp_state.traffic);
+        if (appConManagerGetBdAddrByHandle(handle, &bd_addr))
+            appLinkPolicyUpdatePowerTable(&bd_addr);
     }
+
+    appLinkPolicyStartTrafficTimer();
+}
+
+/*! \brief Get the current traffic level of a link */
+lpTrafficLevel appLinkPolicyGetTrafficLevel(const bdaddr *bd_addr)
+{
+    lpPerConnectionState lp_state = {0};
+
+    appConManagerGetLpState(bd_addr, &lp_state);
+    return (lpTrafficLevel)lp_state.applied;
+}
+
+/*! \brief Update the traffic level of a link at the end of a traffic window
+
+    \param bd_addr   Bluetooth address of the device
+    \return TRUE if the link still needs the traffic window timer.
+*/
+static bool appLinkPolicyUpdateTraffic(const bdaddr *bd_addr)
+{
+    lpPerConnectionState lp_state;
+
+    if (!appConManagerIsConnected(bd_addr))
+        return FALSE;
+
+    appConManagerGetLpState(bd_addr, &lp_state);
+    if (!appLinkPolicyIsTrafficAdaptive(lp_state.pt_index))
+        return FALSE;
+
+    if (lp_state.events >= appConfigLinkPolicyTrafficBurstEvents())
+    {
+        lp_state.traffic = LP_TRAFFIC_BURST;
+    }
+    else if (lp_state.events)
+    {
+        lp_state.traffic = LP_TRAFFIC_NORMAL;
+    }
+    else if (lp_state.traffic == LP_TRAFFIC_BURST)
+    {
+        /* Burst is over */
+        lp_state.traffic = LP_TRAFFIC_NORMAL;
+    }
+    else if (lp_state.traffic != LP_TRAFFIC_IDLE &&
+             ++lp_state.quiet_windows >= appConfigLinkPolicyTrafficQuietWindows())
+    {
+        /* Back off to the next longer sniff interval */
+        lp_state.traffic++;
+        lp_state.quiet_windows = 0;
+    }
+    lp_state.events = 0;
+    appConManagerSetLpState(bd_addr, &lp_state);
+
+    appLinkPolicyUpdatePowerTable(bd_addr);
+    return lp_state.traffic != LP_TRAFFIC_IDLE;
+}
+
+/*! \brief Handle end of a traffic window
+
+    Update the traffic level of the handset and peer links, the timer
+    is stopped once all links have backed off to idle.
+*/
+static void appLinkPolicyHandleInternalTrafficTimeout(void)
+{
+    bdaddr bd_addr;
+    bool active = FALSE;
+
+    if (appDeviceGetHandsetBdAddr(&bd_addr))
+        active |= appLinkPolicyUpdateTraffic(&bd_addr);
+    if (appDeviceGetPeerBdAddr(&bd_addr))
+        active |= appLinkPolicyUpdateTraffic(&bd_addr);
+
+    if (active)
+        appLinkPolicyStartTrafficTimer();
 }
 
 /*! \brief Allow role switching 
@@ -266,6 +465,99 @@ void appLinkPolicyPreventRoleSwitch(const bdaddr *bd_addr)
     DEBUG_LOG("appLinkPolicyPreventRoleSwitch");
 }
 
+/*! \brief Schedule a re-check of the link roles
+
+    \param delay_ms  Time until the link roles are checked
+*/
+static void appLinkPolicyScheduleRoleCheck(uint32 delay_ms)
+{
+    lpTaskData *theLp = appGetLp();
+
+    if (!MessagePendingFirst(&theLp->task, LP_INTERNAL_ROLE_CHECK, NULL))
+        MessageSendLater(&theLp->task, LP_INTERNAL_ROLE_CHECK, NULL, delay_ms);
+}
+
+/*! \brief Make sure a link is active before a role switch
+
+    A role switch can't be performed in sniff mode, so switch the link to
+    the burst power table for the duration of the role switch, whichever
+    activity the link is used for.
+
+    \param bd_addr   Bluetooth address of the device
+*/
+static void appLinkPolicyEnterActive(const bdaddr *bd_addr)
+{
+    lpPerConnectionState lp_state;
+
+    appConManagerGetLpState(bd_addr, &lp_state);
+    if (!lp_state.active)
+    {
+        lp_state.active = TRUE;
+        appConManagerSetLpState(bd_addr, &lp_state);
+        appLinkPolicyUpdatePowerTable(bd_addr);
+    }
+}
+
+/*! \brief Return a link to the power table for its activity after a role switch
+
+    \param bd_addr   Bluetooth address of the device
+*/
+static void appLinkPolicyExitActive(const bdaddr *bd_addr)
+{
+    lpPerConnectionState lp_state;
+
+    appConManagerGetLpState(bd_addr, &lp_state);
+    if (lp_state.active)
+    {
+        lp_state.active = FALSE;
+        appConManagerSetLpState(bd_addr, &lp_state);
+        appLinkPolicyUpdatePowerTable(bd_addr);
+    }
+}
+
+/*! \brief Request a role switch
+
+    Role switches stall the ACL, so they are deferred whilst audio is
+    active unless the role is required for forwarding, and are not
+    requested whilst backing off from a device that has refused
+    previous role switches.
+
+    \param sink      Sink of the link to role switch
+    \param role      Role required
+    \param required  TRUE if the role is required for forwarding
+
+    \return TRUE if the role switch was requested.
+*/
+static bool appLinkPolicySetRole(Sink sink, hci_role role, bool required)
+{
+    lpTaskData *theLp = appGetLp();
+    tp_bdaddr tp_addr;
+    uint32 delay_ms;
+
+    if (!SinkGetBdAddr(sink, &tp_addr))
+        return FALSE;
+
+    if (!required && (appAvIsStreaming() || appHfpIsScoActive()))
+    {
+        DEBUG_LOG("appLinkPolicySetRole, deferred by audio");
+        appLinkPolicyScheduleRoleCheck(appConfigRoleSwitchDeferMs());
+        return FALSE;
+    }
+
+    if (!appConManagerIsRoleSwitchAllowed(&tp_addr.taddr.addr, &delay_ms))
+    {
+        DEBUG_LOGF("appLinkPolicySetRole, not allowed, delay %lu", delay_ms);
+        if (delay_ms)
+            appLinkPolicyScheduleRoleCheck(delay_ms);
+        return FALSE;
+    }
+
+    appLinkPolicyEnterActive(&tp_addr.taddr.addr);
+    appConManagerRoleSwitchRequested(&tp_addr.taddr.addr, role);
+    ConnectionSetRole(&theLp->task, sink, role);
+    return TRUE;
+}
+
 /*! \brief Check and update links
 
     This function checks the role of the individual links and attempts
@@ -296,8 +588,8 @@ static void appLinkPolicyCheckRole(void)
             else 
             {
                 DEBUG_LOG("appLinkPolicyCheckRole. Role switching ScoFwd link");
-                ConnectionSetRole(&theLp->task, appScoFwdGetSink(), hci_role_master);
-                theLp->scofwd_role = hci_role_master;
+                if (appLinkPolicySetRole(appScoFwdGetSink(), hci_role_master, TRUE))
+                    theLp->scofwd_role = hci_role_master;
             }
         }
     }
@@ -313,8 +605,8 @@ static void appLinkPolicyCheckRole(void)
             /* Try and be slave of AV link */
             if (theLp->av_sink_role != hci_role_slave)
             {
-                ConnectionSetRole(&theLp->task, appAvGetSink(tws_inst_sink), hci_role_slave);
-                theLp->av_sink_role = hci_role_slave;
+                if (appLinkPolicySetRole(appAvGetSink(tws_inst_sink), hci_role_slave, FALSE))
+                    theLp->av_sink_role = hci_role_slave;
             }
         }
     }
@@ -333,8 +625,8 @@ static void appLinkPolicyCheckRole(void)
                 /* Try and be master of both links */
                 if (theLp->av_source_role != hci_role_master)
                 {
-                    ConnectionSetRole(&theLp->task, appAvGetSink(av_inst_source), hci_role_master);
-                    theLp->av_source_role = hci_role_master;
+                    if (appLinkPolicySetRole(appAvGetSink(av_inst_source), hci_role_master, TRUE))
+                        theLp->av_source_role = hci_role_master;
                 }
 
                 /* Only attempt to set role of links if we are not streaming,
@@ -343,8 +635,8 @@ static void appLinkPolicyCheckRole(void)
                 {
                     if (theLp->av_sink_role != hci_role_master)
                     {
-                        ConnectionSetRole(&theLp->task, appAvGetSink(av_inst_sink), hci_role_master);
-                        theLp->av_sink_role = hci_role_master;
+                        if (appLinkPolicySetRole(appAvGetSink(av_inst_sink), hci_role_master, FALSE))
+                            theLp->av_sink_role = hci_role_master;
                     }
                 }
             }
@@ -368,8 +660,8 @@ static void appLinkPolicyCheckRole(void)
                         /* Try and be master of HFP link */
                         if (theLp->hfp_role != hci_role_master)
                         {
-                            ConnectionSetRole(&theLp->task, appHfpGetSink(), hci_role_master);
-                            theLp->hfp_role = hci_role_master;
+                            if (appLinkPolicySetRole(appHfpGetSink(), hci_role_master, FALSE))
+                                theLp->hfp_role = hci_role_master;
                         }
                     }
 
@@ -379,8 +671,8 @@ static void appLinkPolicyCheckRole(void)
                         /* Try and be master of AV link */
                         if (theLp->av_sink_role != hci_role_master)
                         {
-                            ConnectionSetRole(&theLp->task, appAvGetSink(av_inst_sink), hci_role_master);
-                            theLp->av_sink_role = hci_role_master;
+                            if (appLinkPolicySetRole(appAvGetSink(av_inst_sink), hci_role_master, FALSE))
+                                theLp->av_sink_role = hci_role_master;
                         }
                     }
                 }
@@ -507,9 +799,22 @@ void appLinkPolicyHandleClDmRoleConfirm(CL_DM_ROLE_CFM_T *cfm)
     
     if (SinkGetBdAddr(cfm->sink, &bd_addr))
     {
+        bool requested = appConManagerRoleSwitchComplete(&bd_addr.taddr.addr, cfm->role,
+                                                         cfm->status == hci_success);
+
+        if (requested)
+            appLinkPolicyExitActive(&bd_addr.taddr.addr);
         appLinkPolicyUpdateRole(&bd_addr.taddr.addr, cfm->role);
         if (cfm->status == hci_success)
             appLinkPolicyCheckRole();
+        else if (requested)
+        {
+            uint32 delay_ms;
+
+            /* Retry once the backoff for this device has expired */
+            appConManagerIsRoleSwitchAllowed(&bd_addr.taddr.addr, &delay_ms);
+            appLinkPolicyScheduleRoleCheck(delay_ms);
+        }
     }
 }
 
@@ -531,6 +836,7 @@ void appLinkPolicyHandleClDmRoleIndication(CL_DM_ROLE_IND_T *ind)
     else
         DEBUG_LOG("appLinkPolicyHandleClDmRoleIndication, slave");
 
+    appConManagerLinkStatsRoleChanged(&ind->bd_addr);
     appLinkPolicyUpdateRole(&ind->bd_addr, ind->role);
     appLinkPolicyCheckRole();
 }
@@ -550,6 +856,30 @@ void appLinkPolicyUpdateRoleFromSink(Sink sink)
     ConnectionGetRole(&theLp->task, sink);
 }
 
+/*! \brief Link policy manager message handler */
+static void appLinkPolicyHandleMessage(Task task, MessageId id, Message message)
+{
+    UNUSED(task);
+
+    switch (id)
+    {
+        case CL_DM_ROLE_CFM:
+            appLinkPolicyHandleClDmRoleConfirm((CL_DM_ROLE_CFM_T *)message);
+            return;
+
+        case LP_INTERNAL_TRAFFIC_TIMEOUT:
+            appLinkPolicyHandleInternalTrafficTimeout();
+            return;
+
+        case LP_INTERNAL_ROLE_CHECK:
+            appLinkPolicyCheckRole();
+            return;
+
+        default:
+            return;
+    }
+}
+
 /*! \brief Initialise link policy manager
 
     Call as startyp to initialise the link policy manager, set all
@@ -559,6 +889,8 @@ void appLinkPolicyInit(void)
 {
     lpTaskData *theLp = appGetLp();   
 
+    theLp->task.handler = appLinkPolicyHandleMessage;
+
 #ifdef INCLUDE_AV
     theLp->av_sink_role = hci_role_dont_care;
     theLp->av_source_role = hci_role_dont_care;
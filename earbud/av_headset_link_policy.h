@@ -45,10 +45,32 @@ typedef enum lp_power_table_index
     POWERTABLE_UNASSIGNED,
 } lpPowerTableIndex;
 
+/*! Traffic levels used to adapt the sniff parameters of idle signalling links */
+typedef enum lp_traffic_level
+{
+    LP_TRAFFIC_NORMAL,      /*!< Default power table for the activity */
+    LP_TRAFFIC_QUIET,       /*!< No traffic for a while, longer sniff interval */
+    LP_TRAFFIC_IDLE,        /*!< No traffic for a long time, longest sniff interval */
+    LP_TRAFFIC_BURST,       /*!< Burst of control traffic, stay active */
+} lpTrafficLevel;
+
+/*! Sources of traffic reported to the link policy manager */
+typedef enum lp_activity
+{
+    LP_ACTIVITY_AVRCP,              /*!< AVRCP command or response */
+    LP_ACTIVITY_HFP,                /*!< HFP AT command or call control */
+    LP_ACTIVITY_PEER_SIGNALLING,    /*!< Peer signalling message */
+} lpActivity;
+
 /*! Link policy state per ACL connection, stored for us by the connection manager. */
 typedef struct
 {
     lpPowerTableIndex pt_index;     /*!< Current powertable in use */
+    unsigned traffic:2;             /*!< Traffic level (#lpTrafficLevel) derived from recent activity */
+    unsigned applied:2;             /*!< Traffic level (#lpTrafficLevel) of the powertable in use */
+    unsigned events:6;              /*!< Activity events in the current traffic window */
+    unsigned quiet_windows:6;       /*!< Consecutive traffic windows without activity */
+    unsigned active:1;              /*!< Held active for a role switch, uses the burst powertable for any activity */
 } lpPerConnectionState;
 
 extern void appLinkPolicyInit(void);
@@ -57,6 +79,24 @@ extern void appLinkPolicyInit(void);
     @param bd_addr The Bluetooth address of the peer device.
 */
 extern void appLinkPolicyUpdatePowerTable(const bdaddr *bd_addr);
+
+/*! @brief Report link traffic to the link policy manager.
+
+    Bursts of activity switch the link to an active power table straight
+    away, whereas quiet links back off to longer sniff intervals.
+
+    @param handle Connection manager handle (#conManagerHandle) of the link the
+                  traffic was for, as cached by the profile when it connected.
+    @param activity The source of the traffic.
+*/
+extern void appLinkPolicyNotifyActivity(uint16 handle, lpActivity activity);
+
+/*! @brief Get the current traffic level of a link.
+    @param bd_addr The Bluetooth address of the device.
+    @return The traffic level of the link.
+*/
+extern lpTrafficLevel appLinkPolicyGetTrafficLevel(const bdaddr *bd_addr);
+
 extern void appLinkPolicyAllowRoleSwitch(const bdaddr *bd_addr);
 extern void appLinkPolicyPreventRoleSwitch(const bdaddr *bd_addr);
 extern void appLinkPolicyUpdateRoleFromSink(Sink sink);
@@ -12,6 +12,7 @@
 #include <ps.h>
 #include <string.h>
 #include <cryptovm.h>
+#include <vm.h>
 
 #include "av_headset.h"
 #include "av_headset_scan_manager.h"
@@ -45,6 +46,11 @@
 #define EIR_TYPE_UUID128_COMPLETE           (0x07)
 #define EIR_TYPE_MANUFACTURER_SPECIFIC      (0xFF)
 #define EIR_SIZE_MANUFACTURER_SPECIFIC      (10)  /* Doesn't include size field */
+#define EIR_SIZE_PAIRING_NONCE              (6)   /* Doesn't include size field */
+
+/*! \name Form factors used in manufacturer specific EIR data */
+#define EIR_FORM_FACTOR_PEER_ADDRESS        (0x20)
+#define EIR_FORM_FACTOR_PAIRING_NONCE       (0x21)
 
 /*
  * Function Prototypes
@@ -128,7 +134,7 @@ static void appPairingInitialiseEir(const uint8 *local_name, uint16 size_local_n
     *eir_ptr++ = EIR_TYPE_MANUFACTURER_SPECIFIC;
     *eir_ptr++ = (appConfigBtSigCompanyId() >> 0) & 0xFF;  /* LSB of CompanyID */
     *eir_ptr++ = (appConfigBtSigCompanyId() >> 8) & 0xFF;  /* MSB of CompanyID */
-    *eir_ptr++ = 0x20;                              /* Form factor for BD_ADDR */
+    *eir_ptr++ = EIR_FORM_FACTOR_PEER_ADDRESS;      /* Form factor for BD_ADDR */
     *eir_ptr++ = (peer_bdaddr.lap >>  0) & 0xFF;    /* LSB of LAP */
     *eir_ptr++ = (peer_bdaddr.lap >>  8) & 0xFF;
     *eir_ptr++ = (peer_bdaddr.lap >> 16) & 0xFF;    /* MSB of LAP */
@@ -137,6 +143,18 @@ static void appPairingInitialiseEir(const uint8 *local_name, uint16 size_local_n
     *eir_ptr++ = (peer_bdaddr.nap >>  8) & 0xFF;    /* MSB of NAP */
 #endif
 
+    /* Add pairing nonce, so that earbuds from the same set find each other */
+    if (appConfigPeerPairingNonce())
+    {
+        *eir_ptr++ = EIR_SIZE_PAIRING_NONCE;
+        *eir_ptr++ = EIR_TYPE_MANUFACTURER_SPECIFIC;
+        *eir_ptr++ = (appConfigBtSigCompanyId() >> 0) & 0xFF;
+        *eir_ptr++ = (appConfigBtSigCompanyId() >> 8) & 0xFF;
+        *eir_ptr++ = EIR_FORM_FACTOR_PAIRING_NONCE;
+        *eir_ptr++ = (appConfigPeerPairingNonce() >> 0) & 0xFF;
+        *eir_ptr++ = (appConfigPeerPairingNonce() >> 8) & 0xFF;
+    }
+
     /* Calculate space for local device name */
     eir_space = (eir_end - eir_ptr) - 3;  /* Take 3 extra from space for type and size fields and zero terminator */
 
@@ -268,18 +286,18 @@ static void appPairingEnterPeerInquiry(pairingTaskData *thePairing)
 {
     DEBUG_LOG("appPairingEnterPeerInquiry");
 
-    /* Reset address & peak RSSI value */
-    BdaddrSetZero(&thePairing->bd_addr[0]);
-    BdaddrSetZero(&thePairing->bd_addr[1]);
-    thePairing->inquiry_rssi[0] = thePairing->inquiry_rssi[1] = APP_PAIRING_MIN_RSSI;
+    /* Reset address & candidate list */
+    BdaddrSetZero(&thePairing->bd_addr);
+    memset(thePairing->candidates, 0, sizeof(thePairing->candidates));
+    thePairing->inquiry_start_ms = VmGetClock();
 
-    /* Set inquiry Tx power, RSSI mode and start periodic inquiry */
+    /* Set inquiry Tx power, EIR mode (includes RSSI) and start periodic inquiry */
     /*ConnectionWriteInquiryTx(-40);*/
-    ConnectionWriteInquiryMode(&thePairing->task, inquiry_mode_rssi);
+    ConnectionWriteInquiryMode(&thePairing->task, inquiry_mode_eir);
 
     /* Start inquiry */
     ConnectionInquire(&thePairing->task, 0x9E8B30, 20,
-                      5,
+                      appConfigPeerPairingInquiryTimeout(),
                       AUDIO_MAJOR_SERV_CLASS | RENDER_MAJOR_SERV_CLASS |
                       AV_MAJOR_DEVICE_CLASS | HEADSET_MINOR_DEVICE_CLASS);
 
@@ -360,7 +378,7 @@ static void appPairingEnterPeerSdpSearch(pairingTaskData *thePairing)
     DEBUG_LOG("appPairingEnterPeerSdpSearch");
 
     /* Perform SDP search */
-    ConnectionSdpServiceSearchAttributeRequest(&thePairing->task, &thePairing->bd_addr[0], 0x32,
+    ConnectionSdpServiceSearchAttributeRequest(&thePairing->task, &thePairing->bd_addr, 0x32,
                                                appSdpGetTwsSinkServiceSearchRequestSize(), appSdpGetTwsSinkServiceSearchRequest(),
                                                appSdpGetTwsSinkAttributeSearchRequestSize(), appSdpGetTwsSinkAttributeSearchRequest());
 }
@@ -371,7 +389,7 @@ static void appPairingEnterPeerSdpSearchAuthenticated(pairingTaskData *thePairin
     DEBUG_LOG("appPairingEnterPeerSdpSearchAuthenticated");
 
     /* Perform SDP search */
-    ConnectionSdpServiceSearchAttributeRequest(&thePairing->task, &thePairing->bd_addr[0], 0x32,
+    ConnectionSdpServiceSearchAttributeRequest(&thePairing->task, &thePairing->bd_addr, 0x32,
                                                appSdpGetTwsSinkServiceSearchRequestSize(), appSdpGetTwsSinkServiceSearchRequest(),
                                                appSdpGetTwsSinkAttributeSearchRequestSize(), appSdpGetTwsSinkAttributeSearchRequest());
 }
@@ -379,10 +397,10 @@ static void appPairingEnterPeerSdpSearchAuthenticated(pairingTaskData *thePairin
 
 static void appPairingEnterPeerAuthenticate(pairingTaskData *thePairing)
 {
-    DEBUG_LOGF("appPairingEnterPeerAuthenticate, authenticating %04x,%02x,%06lx", thePairing->bd_addr[0].nap, thePairing->bd_addr[0].uap, thePairing->bd_addr[0].lap);
+    DEBUG_LOGF("appPairingEnterPeerAuthenticate, authenticating %04x,%02x,%06lx", thePairing->bd_addr.nap, thePairing->bd_addr.uap, thePairing->bd_addr.lap);
 
     /* Device supports TWS+ service, so initiate pairing */
-    ConnectionSmAuthenticate(appGetAppTask(), &thePairing->bd_addr[0], 90);
+    ConnectionSmAuthenticate(appGetAppTask(), &thePairing->bd_addr, 90);
 }
 
 
@@ -429,7 +447,7 @@ static void appPairingEnterHandsetSdpSearchAuthenticated(pairingTaskData *thePai
     DEBUG_LOG("appPairingEnterHandsetSdpSearchAuthenticated");
     
     /* Perform SDP search */
-    ConnectionSdpServiceSearchAttributeRequest(&thePairing->task, &thePairing->bd_addr[0], 0x32,
+    ConnectionSdpServiceSearchAttributeRequest(&thePairing->task, &thePairing->bd_addr, 0x32,
                                                appSdpGetTwsSourceServiceSearchRequestSize(), appSdpGetTwsSourceServiceSearchRequest(),
                                                appSdpGetTwsSourceAttributeSearchRequestSize(), appSdpGetTwsSourceAttributeSearchRequest());
 }
@@ -561,14 +579,14 @@ static void appPairingPeerUpdate(pairingTaskData *thePairing)
     appDeviceInitAttributes(&attributes);
     attributes.type = DEVICE_TYPE_EARBUD;
     attributes.tws_version = thePairing->peer_tws_version;
-    appDeviceSetAttributes(&thePairing->bd_addr[0], &attributes);
+    appDeviceSetAttributes(&thePairing->bd_addr, &attributes);
 
     /* Request local name the response will cause EIR data to be updated */
     ConnectionReadLocalName(&thePairing->task);
 
     /* Mark device as a priority device, so that it never falls off
      * the bottom of the trusted device list */
-    ConnectionAuthSetPriorityDevice(&thePairing->bd_addr[0], TRUE);
+    ConnectionAuthSetPriorityDevice(&thePairing->bd_addr, TRUE);
 
     /* Update TWS+ service record */
     appPairingRegisterServiceRecord(thePairing);
@@ -655,7 +673,7 @@ static void appHandleClSdpRegisterCfm(pairingTaskData *thePairing,
                 thePairing->tws_sink_service_handle = cfm->service_handle;
 
                 /* Send confirmation to main task */
-                appPairingPeerComplete(thePairing, pairingSuccess, &thePairing->bd_addr[0], thePairing->peer_tws_version);
+                appPairingPeerComplete(thePairing, pairingSuccess, &thePairing->bd_addr, thePairing->peer_tws_version);
             }
             else
                 Panic();
@@ -761,7 +779,7 @@ static void appHandleClSdpServiceSearchAttributeCfm(pairingTaskData *thePairing,
 
         case PAIRING_STATE_HANDSET_SDP_SEARCH_AUTHENTICATED:
         {
-            if (BdaddrIsSame(&thePairing->bd_addr[0], &cfm->bd_addr))
+            if (BdaddrIsSame(&thePairing->bd_addr, &cfm->bd_addr))
             {
                 if (cfm->status == sdp_response_success)
                 {
@@ -1024,7 +1042,7 @@ void appPairingHandleClSmAuthenticateConfirm(const CL_SM_AUTHENTICATE_CFM_T *cfm
                 else
                 {
                     /* Store device address of authenticated earbud */
-                    thePairing->bd_addr[0] = cfm->bd_addr;
+                    thePairing->bd_addr = cfm->bd_addr;
 
                     /* Move to 'peer SDP search authenticated' state to start SDP search */
                     appPairingSetState(thePairing, PAIRING_STATE_PEER_SDP_SEARCH_AUTHENTICATED);
@@ -1043,7 +1061,7 @@ void appPairingHandleClSmAuthenticateConfirm(const CL_SM_AUTHENTICATE_CFM_T *cfm
             if (cfm->status == auth_status_success)
             {
                 /* Add attributes, set pre paired flag if this address is known */
-                if (BdaddrIsSame(&cfm->bd_addr, &thePairing->bd_addr[0]))
+                if (BdaddrIsSame(&cfm->bd_addr, &thePairing->bd_addr))
                     appPairingHandsetUpdate(&cfm->bd_addr, DEVICE_TWS_UNKNOWN, DEVICE_FLAGS_PRE_PAIRED_HANDSET);
                 else
                     appPairingHandsetUpdate(&cfm->bd_addr, DEVICE_TWS_UNKNOWN, 0);
@@ -1054,7 +1072,7 @@ void appPairingHandleClSmAuthenticateConfirm(const CL_SM_AUTHENTICATE_CFM_T *cfm
                     appPairingUpdateLinkMode(&cfm->bd_addr, cfm->key_type);
 
                     /* Wait for TWS version, store BT address of authenticated device */
-                    thePairing->bd_addr[0] = cfm->bd_addr;
+                    thePairing->bd_addr = cfm->bd_addr;
 #ifndef DISABLE_TWS_PLUS
                     appPairingSetState(thePairing, PAIRING_STATE_HANDSET_SDP_SEARCH_AUTHENTICATED);
 #else
@@ -1177,7 +1195,7 @@ bool appPairingHandleClSmAuthoriseIndication(const CL_SM_AUTHORISE_IND_T *ind)
         }
         else
         {
-            if (BdaddrIsSame(&thePairing->bd_addr[0], &ind->bd_addr))
+            if (BdaddrIsSame(&thePairing->bd_addr, &ind->bd_addr))
             {
                 /* Handset pairing in progress, address matches so handset is
                  * connecting quicker than our SDP search, allow connection */
@@ -1278,6 +1296,177 @@ void appPairingHandleClSmRemoteIoCapabilityIndication(const CL_SM_REMOTE_IO_CAPA
 
 
 /************************************************************************/
+/*! \brief Score the EIR of a device found during peer inquiry.
+
+    \param thePairing   Pairing task data.
+    \param eir          EIR data from the inquiry result.
+    \param size_eir     Size of the EIR data.
+    \param foreign      Set to TRUE if the device is paired with another earbud.
+    \param nonce        Set to TRUE if the device carries our pairing nonce.
+    \return Score to add to the RSSI of the device.
+*/
+static int16 appPairingPeerEirScore(const pairingTaskData *thePairing, const uint8 *eir, uint16 size_eir,
+                                    bool *foreign, bool *nonce)
+{
+    int16 score = 0;
+
+    *foreign = FALSE;
+    *nonce = FALSE;
+
+    /* Walk EIR structures, each is a length followed by type and data */
+    while (size_eir >= 2 && eir[0] && eir[0] < size_eir)
+    {
+        const uint8 len = eir[0];
+
+        if ((eir[1] == EIR_TYPE_MANUFACTURER_SPECIFIC) && (len >= 4) &&
+            (eir[2] == ((appConfigBtSigCompanyId() >> 0) & 0xFF)) &&
+            (eir[3] == ((appConfigBtSigCompanyId() >> 8) & 0xFF)))
+        {
+            if ((eir[4] == EIR_FORM_FACTOR_PEER_ADDRESS) && (len == EIR_SIZE_MANUFACTURER_SPECIFIC))
+            {
+                bdaddr addr;
+                addr.lap = (uint32)eir[5] | ((uint32)eir[6] << 8) | ((uint32)eir[7] << 16);
+                addr.uap = eir[8];
+                addr.nap = (uint16)eir[9] | ((uint16)eir[10] << 8);
+
+                /* Unpaired, or previously paired with us, is a good match.  Paired
+                   with a different earbud means it belongs to another set */
+                if (BdaddrIsZero(&addr) || BdaddrIsSame(&addr, &thePairing->local_addr))
+                    score += appConfigPeerPairingEirBonus();
+                else if (!BdaddrIsZero(&thePairing->local_addr))
+                    *foreign = TRUE;
+            }
+            else if ((eir[4] == EIR_FORM_FACTOR_PAIRING_NONCE) && (len == EIR_SIZE_PAIRING_NONCE))
+            {
+                const uint16 nonce_rx = (uint16)eir[5] | ((uint16)eir[6] << 8);
+                if (appConfigPeerPairingNonce() && (nonce_rx == appConfigPeerPairingNonce()))
+                    *nonce = TRUE;
+            }
+        }
+
+        size_eir -= len + 1;
+        eir += len + 1;
+    }
+
+    return score;
+}
+
+/*! \brief Add or update a device found during peer inquiry.
+
+    If the candidate list is full the lowest scoring entry is replaced,
+    provided the new device scores higher.
+*/
+static void appPairingUpdatePeerCandidate(pairingTaskData *thePairing, const bdaddr *addr,
+                                          int8 rssi, int16 score, bool nonce)
+{
+    pairingPeerCandidate *lowest = NULL;
+    int index;
+
+    for (index = 0; index < PAIRING_PEER_CANDIDATES; index++)
+    {
+        pairingPeerCandidate *candidate = &thePairing->candidates[index];
+
+        /* Already found, keep the peak values */
+        if (BdaddrIsSame(&candidate->addr, addr))
+        {
+            if (rssi > candidate->rssi)
+                candidate->rssi = rssi;
+            if (score > candidate->score)
+                candidate->score = score;
+            candidate->nonce |= nonce;
+            return;
+        }
+
+        /* Track first unused entry, otherwise the lowest scoring one */
+        if (!lowest || (!BdaddrIsZero(&lowest->addr) &&
+                        (BdaddrIsZero(&candidate->addr) || (candidate->score < lowest->score))))
+            lowest = candidate;
+    }
+
+    if (BdaddrIsZero(&lowest->addr) || (score > lowest->score))
+    {
+        lowest->addr = *addr;
+        lowest->rssi = rssi;
+        lowest->score = score;
+        lowest->nonce = nonce;
+    }
+}
+
+/*! \brief Check if one peer candidate ranks higher than another.
+
+    Devices carrying our pairing nonce rank above all others, after that
+    the highest score wins.
+*/
+static bool appPairingPeerCandidateIsBetter(const pairingPeerCandidate *a, const pairingPeerCandidate *b)
+{
+    if (a->nonce != b->nonce)
+        return a->nonce;
+    return a->score > b->score;
+}
+
+/*! \brief Select the best ranked peer candidate, if it is unambiguous.
+
+    Before the inquiry completes a candidate is only selected once results
+    have been collected for #appConfigPeerPairingMinWindowMs, unless it is
+    the only device carrying our pairing nonce. A lone candidate without the
+    nonce is never selected early, as the device it must be compared against
+    may not have responded yet.
+
+    \param thePairing   Pairing task data.
+    \param complete     TRUE if the inquiry has completed.
+    \return TRUE if a candidate was selected, its address is stored in bd_addr.
+*/
+static bool appPairingSelectPeerCandidate(pairingTaskData *thePairing, bool complete)
+{
+    const pairingPeerCandidate *best = NULL;
+    const pairingPeerCandidate *next = NULL;
+    const uint32 elapsed_ms = VmGetClock() - thePairing->inquiry_start_ms;
+    bool unambiguous;
+    int index;
+
+    for (index = 0; index < PAIRING_PEER_CANDIDATES; index++)
+    {
+        const pairingPeerCandidate *candidate = &thePairing->candidates[index];
+
+        if (BdaddrIsZero(&candidate->addr))
+            continue;
+
+        if (!best || appPairingPeerCandidateIsBetter(candidate, best))
+        {
+            next = best;
+            best = candidate;
+        }
+        else if (!next || appPairingPeerCandidateIsBetter(candidate, next))
+            next = candidate;
+    }
+
+    if (!best)
+        return FALSE;
+
+    /* Check if best is sufficiently higher than next */
+    if (best->nonce && !(next && next->nonce))
+        unambiguous = TRUE;
+    else
+        unambiguous = ((next ? next->score : APP_PAIRING_MIN_RSSI) - best->score) <= APP_PAIRING_MIN_RSSI_DELTA;
+
+    if (!unambiguous)
+        return FALSE;
+
+    if (!complete && !best->nonce && (!next || (elapsed_ms < appConfigPeerPairingMinWindowMs())))
+        return FALSE;
+
+    DEBUG_LOGF("appPairingSelectPeerCandidate, bdaddr %x,%x,%lx, rssi %d, score %d, next_score %d, elapsed %lu",
+               best->addr.nap, best->addr.uap, best->addr.lap, best->rssi, best->score,
+               next ? next->score : APP_PAIRING_MIN_RSSI, elapsed_ms);
+
+    thePairing->bd_addr = best->addr;
+    thePairing->discovery_stats.last_select_ms = (elapsed_ms > 0xFFFF) ? 0xFFFF : (uint16)elapsed_ms;
+    if (!complete)
+        thePairing->discovery_stats.early_selects++;
+
+    return TRUE;
+}
+
 static void appHandleClDmInquireResult(pairingTaskData *thePairing, const CL_DM_INQUIRE_RESULT_T *result)
 {
     switch (appPairingGetState(thePairing))
@@ -1286,83 +1475,73 @@ static void appHandleClDmInquireResult(pairingTaskData *thePairing, const CL_DM_
         {
             if (result->status == inquiry_status_result)
             {
-                DEBUG_LOGF("appHandleClDmInquireResult, bdaddr %04x,%02x,%06lx rssi %d cod %lx",
+                bool foreign, nonce;
+                const int16 score = appPairingPeerEirScore(thePairing, result->eir_data, result->size_eir_data,
+                                                           &foreign, &nonce);
+
+                DEBUG_LOGF("appHandleClDmInquireResult, bdaddr %04x,%02x,%06lx rssi %d cod %lx eir_score %d nonce %d",
                             result->bd_addr.nap,
                             result->bd_addr.uap,
                             result->bd_addr.lap,
                             result->rssi,
-                            result->dev_class);
+                            result->dev_class,
+                            score, nonce);
 
-                /* Cache result if RSSI is higher */
-                if (result->rssi > thePairing->inquiry_rssi[0])
+                if (foreign)
                 {
-                    /* Check if address is different from previous peak */
-                    if (!BdaddrIsSame(&result->bd_addr, &thePairing->bd_addr[0]))
-                    {
-                        /* Store previous peak RSSI */
-                        thePairing->inquiry_rssi[1] = thePairing->inquiry_rssi[0];
-                        thePairing->bd_addr[1] = thePairing->bd_addr[0];
-
-                        /* Store new address */
-                       thePairing->bd_addr[0] = result->bd_addr;
-                    }
-
-                    /* Store peak RSSI */
-                    thePairing->inquiry_rssi[0] = result->rssi;
+                    /* Device is paired with another earbud, don't consider it */
+                    thePairing->discovery_stats.rejected++;
                 }
-                else if (result->rssi > thePairing->inquiry_rssi[1])
+                else if (result->rssi > APP_PAIRING_MIN_RSSI)
                 {
-                    /* Check if address is different from peak */
-                    if (!BdaddrIsSame(&result->bd_addr, &thePairing->bd_addr[0]))
+                    appPairingUpdatePeerCandidate(thePairing, &result->bd_addr, (int8)result->rssi,
+                                                  result->rssi + score, nonce);
+
+                    /* Don't wait for inquiry to complete if there is already a clear winner */
+                    if (appPairingSelectPeerCandidate(thePairing, FALSE))
                     {
-                        /* Store next highest RSSI */
-                        thePairing->inquiry_rssi[1] = result->rssi;
+                        DEBUG_LOG("appHandleClDmInquireResult, early selection, performing SDP service search");
+
+                        /* Move to 'peer sdp search' state, this cancels the inquiry */
+                        appPairingSetState(thePairing, PAIRING_STATE_PEER_SDP_SEARCH);
                     }
                 }
             }
             else
             {
-                DEBUG_LOGF("appHandleClDmInquireResult, complete, status %d, bdaddr %x,%x,%lx, rssi %d, next_rssi %d",
-                            result->status,
-                            thePairing->bd_addr[0].nap,
-                            thePairing->bd_addr[0].uap,
-                            thePairing->bd_addr[0].lap,
-                            thePairing->inquiry_rssi[0],
-                            thePairing->inquiry_rssi[1]);
-
-                /* Attempt to connect to device with highest RSSI */
-                if (!BdaddrIsZero(&thePairing->bd_addr[0]))
+                DEBUG_LOGF("appHandleClDmInquireResult, complete, status %d", result->status);
+
+                /* Attempt to connect to device with highest rank */
+                if (appPairingSelectPeerCandidate(thePairing, TRUE))
                 {
-                    /* Check if RSSI peak is sufficently higher than next */
-                    if ((thePairing->inquiry_rssi[1] - thePairing->inquiry_rssi[0]) <= APP_PAIRING_MIN_RSSI_DELTA)
-                    {
-                        DEBUG_LOG("appHandleClDmInquireResult, performing SDP service search");
+                    DEBUG_LOG("appHandleClDmInquireResult, performing SDP service search");
 
-                        /* Move to 'peer sdp search' state */
-                        appPairingSetState(thePairing, PAIRING_STATE_PEER_SDP_SEARCH);
-                    }
+                    /* Move to 'peer sdp search' state */
+                    appPairingSetState(thePairing, PAIRING_STATE_PEER_SDP_SEARCH);
+                }
+                /* Candidates fill from the start of the list, so first entry is set if any were found */
+                else if (!BdaddrIsZero(&thePairing->candidates[0].addr))
+                {
+                    DEBUG_LOG("appHandleClDmInquireResult, Inquiry error, too many devices nearby or unable to create new instance");
+                    thePairing->discovery_stats.ambiguous++;
+
+                    /* Send confirmation with error to main task */
+                    if (thePairing->is_user_initiated)
+                        appPairingPeerComplete(thePairing, pairingNoPeerFound, NULL, 0x0000);
                     else
                     {
-                        DEBUG_LOG("appHandleClDmInquireResult, Inquiry error, too many devices nearby or unable to create new instance");
-
-                        /* Send confirmation with error to main task */
-                        if (thePairing->is_user_initiated)
-                            appPairingPeerComplete(thePairing, pairingNoPeerFound, NULL, 0x0000);
-                        else
-                        {
-                            /* Restart inquiry */
-                            ConnectionInquire(&thePairing->task, 0x9E8B30, 20,
-                                              5,
-                                              AUDIO_MAJOR_SERV_CLASS | RENDER_MAJOR_SERV_CLASS |
-                                              AV_MAJOR_DEVICE_CLASS | HEADSET_MINOR_DEVICE_CLASS);
-                        }
+                        /* Restart inquiry */
+                        ConnectionInquire(&thePairing->task, 0x9E8B30, 20,
+                                          appConfigPeerPairingInquiryTimeout(),
+                                          AUDIO_MAJOR_SERV_CLASS | RENDER_MAJOR_SERV_CLASS |
+                                          AV_MAJOR_DEVICE_CLASS | HEADSET_MINOR_DEVICE_CLASS);
                     }
                 }
                 else
                 {
                     /* Restart inquiry */
                     ConnectionInquire(&thePairing->task, 0x9E8B30, 20,
-                                      5,
+                                      appConfigPeerPairingInquiryTimeout(),
                                       AUDIO_MAJOR_SERV_CLASS | RENDER_MAJOR_SERV_CLASS |
                                       AV_MAJOR_DEVICE_CLASS | HEADSET_MINOR_DEVICE_CLASS);
                 }
@@ -1392,6 +1571,19 @@ static void appHandleClDmLocalNameComplete(CL_DM_LOCAL_NAME_COMPLETE_T *msg)
     appPairingInitialiseEir(msg->local_name, msg->size_local_name);
 }
 
+/*! \brief Handle local BT address.
+
+    Store the address so that inquiry results from earbuds advertising they
+    were paired with this earbud are recognised during peer pairing.
+*/
+static void appHandleClDmLocalBdAddrCfm(pairingTaskData *thePairing, const CL_DM_LOCAL_BD_ADDR_CFM_T *cfm)
+{
+    DEBUG_LOGF("appHandleClDmLocalBdAddrCfm, status %d", cfm->status);
+
+    if (cfm->status == success)
+        thePairing->local_addr = cfm->bd_addr;
+}
+
 
 
 static void appHandleInternalPeerPairRequest(pairingTaskData *thePairing, PAIR_REQ_T *req)
@@ -1450,7 +1642,7 @@ static void appHandleInternalHandsetPairRequest(pairingTaskData *thePairing, PAI
             thePairing->sdp_search_attempts = 0;
 
             /* Store address of handset to pair with, 0 we should go discoverable */
-            thePairing->bd_addr[0] = req->addr;
+            thePairing->bd_addr = req->addr;
 
             /* no address, go discoverable for inquiry process */
             if (BdaddrIsZero(&req->addr))
@@ -1807,6 +1999,10 @@ static void appPairingHandleMessage(Task task, MessageId id, Message message)
             appHandleClDmLocalNameComplete((CL_DM_LOCAL_NAME_COMPLETE_T *)message);
             return;
 
+        case CL_DM_LOCAL_BD_ADDR_CFM:
+            appHandleClDmLocalBdAddrCfm(thePairing, (CL_DM_LOCAL_BD_ADDR_CFM_T *)message);
+            return;
+
         case CL_DM_WRITE_INQUIRY_MODE_CFM:
         case CL_DM_WRITE_INQUIRY_ACCESS_CODE_CFM:
             return;
@@ -1887,6 +2083,11 @@ void appPairingInit(void)
     /* Get device name so that we can initialise EIR response */
     ConnectionReadLocalName(&thePairing->task);
 
+    /* Get local address so peers previously paired with us can be recognised */
+    BdaddrSetZero(&thePairing->local_addr);
+    ConnectionReadLocalAddr(&thePairing->task);
+    memset(&thePairing->discovery_stats, 0, sizeof(thePairing->discovery_stats));
+
     /* register with peer signalling for notification of handset
      * link key arrival, should the other earbud pair with a new handset */
     appPeerSigLinkKeyTaskRegister(&thePairing->task);
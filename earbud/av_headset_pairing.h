@@ -119,6 +119,35 @@ typedef struct
     bool is_user_initiated;
 } PAIR_REQ_T;
 
+/*! Number of devices tracked and ranked during peer inquiry */
+#define PAIRING_PEER_CANDIDATES (4)
+
+/*! Device found during peer inquiry */
+typedef struct
+{
+    /*! Address of the device, zero if the entry is unused */
+    bdaddr  addr;
+    /*! Peak RSSI of the device */
+    int8    rssi;
+    /*! Set if the device's EIR carried our pairing nonce */
+    bool    nonce:1;
+    /*! Ranking score, peak RSSI adjusted by the EIR content */
+    int16   score;
+} pairingPeerCandidate;
+
+/*! Peer discovery statistics */
+typedef struct
+{
+    /*! Time in milliseconds from inquiry start to selecting the last peer */
+    uint16  last_select_ms;
+    /*! Number of peers selected before the inquiry completed */
+    uint16  early_selects;
+    /*! Number of inquiries that completed without an unambiguous peer */
+    uint16  ambiguous;
+    /*! Number of inquiry results from earbuds already paired with another device */
+    uint16  rejected;
+} pairingPeerDiscoveryStats;
+
 /*! Pairing task structure */
 typedef struct
 {
@@ -134,11 +163,17 @@ typedef struct
     unsigned sdp_search_attempts:3;
     /*! The SDP service handle for TWS sink */
     uint32   tws_sink_service_handle;
-    /*! Peer pairing: BT address of the 2 'loudest' devices found during inquiry
+    /*! Peer pairing: BT address of the best ranked device found during inquiry
         Handset pairing: BT address of handset if pairing request by peer, 0 otherwise */
-    bdaddr   bd_addr[2];
-    /*! RSSI measurement of the 2 'loudest' devices */
-    int8     inquiry_rssi[2];
+    bdaddr   bd_addr;
+    /*! Devices found during peer inquiry, ranked by #pairingPeerCandidate::score */
+    pairingPeerCandidate candidates[PAIRING_PEER_CANDIDATES];
+    /*! Time (VM clock) the current peer inquiry started */
+    uint32   inquiry_start_ms;
+    /*! Local BT address, used to recognise peers advertising that they were paired with us */
+    bdaddr   local_addr;
+    /*! Peer discovery statistics */
+    pairingPeerDiscoveryStats discovery_stats;
     /*! The peer's TWS version */
     uint16   peer_tws_version;
     /*! The handset's TWS version (if applicable) */
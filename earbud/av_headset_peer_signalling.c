@@ -73,7 +73,8 @@
 */
 /*!@{ */
 #define AVRCP_PEER_CMD_STARTUP_SYNC                      0x40       /*!< Message ID */
-#define AVRCP_PEER_CMD_STARTUP_SYNC_SIZE                 15         /*!< Message length */
+#define AVRCP_PEER_CMD_STARTUP_SYNC_SIZE                 15         /*!< Message length, accepted by all peers */
+#define AVRCP_PEER_CMD_STARTUP_SYNC_EXTENDED_SIZE        17         /*!< Message length with SDP records version */
 #define AVRCP_PEER_CMD_STARTUP_SYNC_BATT_OFFSET          0
 #define AVRCP_PEER_CMD_STARTUP_SYNC_ADDR_TYPE_OFFSET     2
 #define AVRCP_PEER_CMD_STARTUP_SYNC_ADDR_OFFSET          3
@@ -82,6 +83,7 @@
 #define AVRCP_PEER_CMD_STARTUP_SYNC_PAIRING_OFFSET       12
 #define AVRCP_PEER_CMD_STARTUP_SYNC_TX_SEQNUM_OFFSET     13
 #define AVRCP_PEER_CMD_STARTUP_SYNC_RX_SEQNUM_OFFSET     14
+#define AVRCP_PEER_CMD_STARTUP_SYNC_SDP_VERSION_OFFSET   15
 
 #define AVRCP_PEER_CMD_STARTUP_SYNC_STATE_A2DP_CONNECTED    (1 << 0)
 #define AVRCP_PEER_CMD_STARTUP_SYNC_STATE_A2DP_STREAMING    (1 << 1)
@@ -94,6 +96,9 @@
 #define AVRCP_PEER_CMD_STARTUP_SYNC_PAIRING_HANDSET_COMPLETE    (1 << 0)
 #define AVRCP_PEER_CMD_STARTUP_SYNC_PAIRING_HANDSET_IN_PROGRESS (1 << 1)
 #define AVRCP_PEER_CMD_STARTUP_SYNC_RULES_IN_PROGRESS           (1 << 2)
+/*! Sender accepts the extended sync message, older peers only accept
+    #AVRCP_PEER_CMD_STARTUP_SYNC_SIZE octets and ignore this bit. */
+#define AVRCP_PEER_CMD_STARTUP_SYNC_EXTENDED_SUPPORTED          (1 << 3)
 /*!@} */
 
 /*! Definitions for Peer Signalling message channel packet format. */
@@ -152,6 +157,8 @@ static void appPeerSigEnterConnected(void)
 {
     DEBUG_LOG("appPeerSigEnterConnected");
 
+    appGetPeerSig()->acl_handle = appConManagerGetHandle(&appGetPeerSig()->peer_addr);
+
     /* Cancel any other startup requests */
     MessageCancelAll(&appGetPeerSig()->task, PEER_SIG_INTERNAL_STARTUP_REQ);
 
@@ -165,6 +172,8 @@ static void appPeerSigExitConnected(void)
 {
     DEBUG_LOG("appPeerSigExitConnected");
 
+    appGetPeerSig()->acl_handle = CON_MANAGER_HANDLE_INVALID;
+
     appPeerSigCancelInactivityTimer();
 }
 
@@ -182,6 +191,9 @@ static void appPeerSigEnterDisconnected(void)
     /* Clear peer address, as we use that to detect if we've previously reject a peer connection */
     BdaddrSetZero(&peer_sig->peer_addr);
 
+    /* Next peer may be running older firmware */
+    peer_sig->sync_extended = FALSE;
+
     /* If we have any clients inform them of peer signalling disconnection */
     appPeerSigMsgConnectionInd(peerSigStatusDisconnected);
 
@@ -772,7 +784,8 @@ static bool appPeerSigHandleSyncCommand(AV_AVRCP_VENDOR_PASSTHROUGH_IND_T *ind)
 {
     peerSigTaskData *peer_sig = appGetPeerSig();
 
-    if (ind->size_payload == AVRCP_PEER_CMD_STARTUP_SYNC_SIZE)
+    if ((ind->size_payload == AVRCP_PEER_CMD_STARTUP_SYNC_SIZE) ||
+        (ind->size_payload >= AVRCP_PEER_CMD_STARTUP_SYNC_EXTENDED_SIZE))
     {
         if (ind->payload[AVRCP_PEER_CMD_STARTUP_SYNC_ADDR_TYPE_OFFSET] ==
             AVRCP_PEER_CMD_ADD_LINK_KEY_ADDR_TYPE_BREDR)
@@ -800,6 +813,12 @@ static bool appPeerSigHandleSyncCommand(AV_AVRCP_VENDOR_PASSTHROUGH_IND_T *ind)
                 message->peer_rules_in_progress   = (pairing & AVRCP_PEER_CMD_STARTUP_SYNC_RULES_IN_PROGRESS) ? 1 : 0;
                 message->tx_seqnum                = ind->payload[AVRCP_PEER_CMD_STARTUP_SYNC_TX_SEQNUM_OFFSET];
                 message->rx_seqnum                = ind->payload[AVRCP_PEER_CMD_STARTUP_SYNC_RX_SEQNUM_OFFSET];
+                /* Peer accepts the extended message, send it from now on */
+                peer_sig->sync_extended = (pairing & AVRCP_PEER_CMD_STARTUP_SYNC_EXTENDED_SUPPORTED) ? 1 : 0;
+                if (ind->size_payload >= AVRCP_PEER_CMD_STARTUP_SYNC_EXTENDED_SIZE)
+                    message->sdp_records_version = appPeerSigReadUint16(&ind->payload[AVRCP_PEER_CMD_STARTUP_SYNC_SDP_VERSION_OFFSET]);
+                else
+                    message->sdp_records_version = 0;
 
                 DEBUG_LOGF("appPeerSigHandleSyncCommand, battery %u, bdaddr %04x,%02x,%06lx, version %u.%02u, state %x, peer_startup %u, peer_in_case %u, peer_in_ear %u",
                            message->battery_level, message->handset_addr.nap, message->handset_addr.uap, message->handset_addr.lap,
@@ -895,6 +914,7 @@ static void appPeerSigHandleAvAvrcpVendorPassthroughInd(AV_AVRCP_VENDOR_PASSTHRO
 
     /* Restart in-activity timer */
     appPeerSigStartInactivityTimer();
+    appLinkPolicyNotifyActivity(appGetPeerSig()->acl_handle, LP_ACTIVITY_PEER_SIGNALLING);
 
     /* Reply to the indication */
     appAvrcpVendorPassthroughResponse(ind->av_instance,
@@ -1077,7 +1097,10 @@ static void appPeerSigHandleInternalSyncRequest(PEER_SIG_INTERNAL_SYNC_REQ_T* re
     {
         case PEER_SIG_STATE_CONNECTED:
         {
-            uint8 message[AVRCP_PEER_CMD_PAIR_HANDSET_ADDRESS_SIZE];
+            peerSigTaskData *peer_sig = appGetPeerSig();
+            uint8 message[AVRCP_PEER_CMD_STARTUP_SYNC_EXTENDED_SIZE];
+            uint16 size = peer_sig->sync_extended ? AVRCP_PEER_CMD_STARTUP_SYNC_EXTENDED_SIZE :
+                                                    AVRCP_PEER_CMD_STARTUP_SYNC_SIZE;
             int index;
             const uint8 state = (req->sync_data.a2dp_connected  ? AVRCP_PEER_CMD_STARTUP_SYNC_STATE_A2DP_CONNECTED  : 0) +
                                 (req->sync_data.a2dp_streaming  ? AVRCP_PEER_CMD_STARTUP_SYNC_STATE_A2DP_STREAMING  : 0) +
@@ -1089,7 +1112,8 @@ static void appPeerSigHandleInternalSyncRequest(PEER_SIG_INTERNAL_SYNC_REQ_T* re
 
             const uint8 pairing = (req->sync_data.is_pairing           ? AVRCP_PEER_CMD_STARTUP_SYNC_PAIRING_HANDSET_IN_PROGRESS : 0) +
                                   (req->sync_data.have_handset_pairing ? AVRCP_PEER_CMD_STARTUP_SYNC_PAIRING_HANDSET_COMPLETE : 0) +
-                                  (req->sync_data.peer_rules_in_progress ? AVRCP_PEER_CMD_STARTUP_SYNC_RULES_IN_PROGRESS : 0);
+                                  (req->sync_data.peer_rules_in_progress ? AVRCP_PEER_CMD_STARTUP_SYNC_RULES_IN_PROGRESS : 0) +
+                                  AVRCP_PEER_CMD_STARTUP_SYNC_EXTENDED_SUPPORTED;
 
             DEBUG_LOGF("appPeerSigHandleInternalSyncReq, battery %u, bdaddr %04x,%02x,%06lx, version %u.%02u, state %x, startup %u, in_case %u, in_ear %u",
                        req->sync_data.battery_level, req->sync_data.handset_addr.nap, req->sync_data.handset_addr.uap, req->sync_data.handset_addr.lap,
@@ -1126,9 +1150,14 @@ static void appPeerSigHandleInternalSyncRequest(PEER_SIG_INTERNAL_SYNC_REQ_T* re
             message[AVRCP_PEER_CMD_STARTUP_SYNC_TX_SEQNUM_OFFSET] = req->sync_data.tx_seqnum;
             message[AVRCP_PEER_CMD_STARTUP_SYNC_RX_SEQNUM_OFFSET] = req->sync_data.rx_seqnum;
 
-            /* Send the sync data over AVRCP */
+            index = AVRCP_PEER_CMD_STARTUP_SYNC_SDP_VERSION_OFFSET;
+            message[index++] = req->sync_data.sdp_records_version & 0xFF;
+            message[index] = (req->sync_data.sdp_records_version >> 8) & 0xFF;
+
+            /* Send the sync data over AVRCP, the SDP records version is only
+               included once the peer has shown it accepts the extended message */
             appPeerSigVendorPassthroughRequest(req->client_task, AVRCP_PEER_CMD_STARTUP_SYNC,
-                                               AVRCP_PEER_CMD_STARTUP_SYNC_SIZE, message);
+                                               size, message);
         }
         break;
 
@@ -28,6 +28,9 @@ typedef enum
     /*! Channel ID for SCO Forwarding control messages. */
     PEER_SIG_MSG_CHANNEL_SCOFWD = 1UL << 0,
 
+    /*! Channel ID for A2DP forwarding link reports. */
+    PEER_SIG_MSG_CHANNEL_A2DP_FWD = 1UL << 1,
+
     /* force peerSigMsgChannel to be a 32-bit enum */
     PEER_SIG_MSG_CHANNEL_MAX    = 1UL << 30
 } peerSigMsgChannel;
@@ -75,6 +78,9 @@ typedef struct
     TaskList* msg_channel_tasks;         /*!< List of tasks and associated signalling channel. */
     peerSigMsgChannel current_msg_channel; /*!< Remember msg channel in use for TX confirmation msgs. */
 
+    bool sync_extended:1;           /*!< Peer accepts the startup sync message with SDP records version */
+    uint16 acl_handle;              /*!< Connection manager handle (#conManagerHandle) of the peer link whilst connected */
+
 } peerSigTaskData;
 
 /*! Enumeration of peer signalling status codes. */
@@ -213,6 +219,7 @@ typedef struct
     bool peer_rules_in_progress:1;  /*!< Peer has rules in progress. */
     uint8 tx_seqnum;                /*!< Peer sync TX sequence number. */
     uint8 rx_seqnum;                /*!< Last received peer sync message sequence number */
+    uint16 sdp_records_version;     /*!< Peer's SDP records version, 0 if not sent by peer */
 } PEER_SIG_SYNC_IND_T;
 
 /*! Internal messages used by peer signalling. */
@@ -280,6 +287,7 @@ typedef struct
     bool peer_rules_in_progress:1;  /*!< Peer has rules in progress. */
     uint8 tx_seqnum;                /*!< Peer sync TX sequence number. */
     uint8 rx_seqnum;                /*!< Last received peer sync message sequence number */
+    uint16 sdp_records_version;     /*!< Version of the local SDP records */
 } peerSigSyncReqData;
 
 /*! Structure used to request synchronisation of peer information 
@@ -89,6 +89,37 @@ static void appPhyStateHandleBadState(phyState phy_state)
     Panic();
 }
 
+/*! \brief Select the proximity sensor measurement rate from the physical
+           state and motion. */
+static void appPhyStateUpdateProximityRate(phyStateTaskData *phy_state)
+{
+    proximityRateProfile profile;
+
+    switch (phy_state->state)
+    {
+        case PHY_STATE_IN_CASE:
+            /* Nothing to measure in the case while charging */
+            profile = phy_state->fusion.charger ? proximity_rate_profile_off :
+                                                  proximity_rate_profile_rest;
+            break;
+
+        case PHY_STATE_OUT_OF_EAR_AT_REST:
+            profile = proximity_rate_profile_rest;
+            break;
+
+        case PHY_STATE_OUT_OF_EAR:
+            /* Likely to be put in the ear soon */
+            profile = phy_state->in_motion ? proximity_rate_profile_motion :
+                                             proximity_rate_profile_normal;
+            break;
+
+        default:
+            profile = proximity_rate_profile_normal;
+            break;
+    }
+    appProximitySetRateProfile(profile);
+}
+
 /*! \brief Handle notification that Earbud is now in the case. */
 static void appPhyStateHandleInternalInCaseEvent(void)
 {
@@ -227,6 +258,7 @@ static void appPhyStateHandleInternalMotionEvent(void)
 
     /* Save motion state to use in determining state on further events */
     phy_state->in_motion = TRUE;
+    appPhyStateUpdateProximityRate(phy_state);
 
     switch (phy_state->state)
     {
@@ -257,6 +289,7 @@ static void appPhyStateHandleInternalNotInMotionEvent(void)
     phyStateTaskData *phy_state = appGetPhyState();
     /* Save motion state to use in determining state on further events */
     phy_state->in_motion = FALSE;
+    appPhyStateUpdateProximityRate(phy_state);
 
     switch (phy_state->state)
     {
@@ -281,10 +314,112 @@ static void appPhyStateHandleInternalNotInMotionEvent(void)
     }
 }
 
+/*! \brief Compute the confidence the earbud is in the ear from the raw
+           sensor states. */
+static uint8 appPhyStateFusionConfidence(phyStateTaskData *phy_state)
+{
+    uint8 confidence = 0;
+
+    /* In the case the earbud cannot be in the ear */
+    if (phy_state->fusion.charger)
+        return 0;
+
+    if (phy_state->fusion.proximity)
+        confidence += appConfigPhyStateProximityConfidence();
+    if (phy_state->fusion.motion)
+        confidence += appConfigPhyStateMotionConfidence();
+
+    return confidence > 100 ? 100 : confidence;
+}
+
+/*! \brief Send the in/out of ear event for a fused decision. */
+static void appPhyStateFusionApply(phyStateTaskData *phy_state, bool in_ear)
+{
+    DEBUG_LOGF("appPhyStateFusionApply in_ear %d", in_ear);
+
+    phy_state->fusion.valid = TRUE;
+    phy_state->fusion.in_ear = in_ear;
+    phy_state->fusion.transitions++;
+    if (in_ear)
+        appPhyStateInEarEvent();
+    else
+        appPhyStateOutOfEarEvent();
+}
+
+/*! \brief Get the dwell time for a fused decision, shorter whilst moving. */
+static uint32 appPhyStateFusionDwellMs(phyStateTaskData *phy_state, uint32 dwell_ms)
+{
+    if (phy_state->fusion.motion)
+        return (dwell_ms * appConfigPhyStateMotionDwellPercent()) / 100;
+    return dwell_ms;
+}
+
+/*! \brief Re-evaluate the fused in-ear decision after a raw sensor change.
+
+    The first decision is made immediately once the proximity sensor has
+    reported, or the charger is attached, as the decision can't be made
+    without them. Thereafter a change is only made once the confidence has
+    crossed the threshold for the dwell time, so a short sensor glitch
+    does not reach clients.
+*/
+static void appPhyStateFusionUpdate(phyStateTaskData *phy_state)
+{
+    uint8 confidence = appPhyStateFusionConfidence(phy_state);
+    bool pending = MessagePendingFirst(&phy_state->task, PHY_STATE_INTERNAL_FUSION_TIMEOUT, NULL);
+    bool in_ear = confidence >= appConfigPhyStateInEarThreshold();
+
+    if (!phy_state->fusion.proximity_known && !phy_state->fusion.charger)
+    {
+        return;
+    }
+    else if (!phy_state->fusion.valid)
+    {
+        appPhyStateFusionApply(phy_state, in_ear);
+    }
+    else if (!phy_state->fusion.in_ear && in_ear)
+    {
+        if (!pending)
+        {
+            MessageSendLater(&phy_state->task, PHY_STATE_INTERNAL_FUSION_TIMEOUT, NULL,
+                             appPhyStateFusionDwellMs(phy_state, appConfigPhyStateInEarDwellMs()));
+        }
+    }
+    else if (phy_state->fusion.in_ear && confidence <= appConfigPhyStateOutOfEarThreshold())
+    {
+        if (!pending)
+        {
+            MessageSendLater(&phy_state->task, PHY_STATE_INTERNAL_FUSION_TIMEOUT, NULL,
+                             appPhyStateFusionDwellMs(phy_state, appConfigPhyStateOutOfEarDwellMs()));
+        }
+    }
+    else if (pending)
+    {
+        /* Confidence returned before the dwell time elapsed */
+        MessageCancelAll(&phy_state->task, PHY_STATE_INTERNAL_FUSION_TIMEOUT);
+        phy_state->fusion.suppressed++;
+        DEBUG_LOGF("appPhyStateFusionUpdate suppressed, confidence %d", confidence);
+    }
+}
+
+/*! \brief The dwell time has elapsed with the confidence past threshold. */
+static void appPhyStateHandleInternalFusionTimeout(phyStateTaskData *phy_state)
+{
+    uint8 confidence = appPhyStateFusionConfidence(phy_state);
+
+    if (!phy_state->fusion.in_ear && confidence >= appConfigPhyStateInEarThreshold())
+    {
+        appPhyStateFusionApply(phy_state, TRUE);
+    }
+    else if (phy_state->fusion.in_ear && confidence <= appConfigPhyStateOutOfEarThreshold())
+    {
+        appPhyStateFusionApply(phy_state, FALSE);
+    }
+}
+
 /*! \brief Physical State module message handler. */
 static void appPhyStateHandleMessage(Task task, MessageId id, Message message)
 {
-    UNUSED(task);
+    phyStateTaskData *phy_state = (phyStateTaskData *)task;
     UNUSED(message);
 
     switch (id)
@@ -308,24 +443,40 @@ static void appPhyStateHandleMessage(Task task, MessageId id, Message message)
             appPhyStateHandleInternalNotInMotionEvent();
             break;
 
+        case PHY_STATE_INTERNAL_FUSION_TIMEOUT:
+            appPhyStateHandleInternalFusionTimeout(phy_state);
+            break;
+
         case CHARGER_MESSAGE_ATTACHED:
+            phy_state->fusion.charger = TRUE;
             appPhyStateInCaseEvent();
+            appPhyStateFusionUpdate(phy_state);
             break;
         case CHARGER_MESSAGE_DETACHED:
+            phy_state->fusion.charger = FALSE;
             appPhyStateOutOfCaseEvent();
+            appPhyStateFusionUpdate(phy_state);
             break;
 
         case ACCELEROMETER_MESSAGE_IN_MOTION:
+            phy_state->fusion.motion = TRUE;
             appPhyStateMotionEvent();
+            appPhyStateFusionUpdate(phy_state);
             break;
         case ACCELEROMETER_MESSAGE_NOT_IN_MOTION:
+            phy_state->fusion.motion = FALSE;
             appPhyStateNotInMotionEvent();
+            appPhyStateFusionUpdate(phy_state);
             break;
         case PROXIMITY_MESSAGE_IN_PROXIMITY:
-            appPhyStateInEarEvent();
+            phy_state->fusion.proximity = TRUE;
+            phy_state->fusion.proximity_known = TRUE;
+            appPhyStateFusionUpdate(phy_state);
             break;
         case PROXIMITY_MESSAGE_NOT_IN_PROXIMITY:
-            appPhyStateOutOfEarEvent();
+            phy_state->fusion.proximity = FALSE;
+            phy_state->fusion.proximity_known = TRUE;
+            appPhyStateFusionUpdate(phy_state);
             break;
 
         default:
@@ -350,6 +501,7 @@ void appPhyStateRegisterClient(Task client_task)
         phy_state->client_tasks = appTaskListInit();
         phy_state->in_motion = FALSE;
         phy_state->in_proximity = FALSE;
+        memset(&phy_state->fusion, 0, sizeof(phy_state->fusion));
 
 /* Not registering as a client of the charger means no charger state messages
    will be received. This means the in-case state can never be entered */
@@ -454,6 +606,7 @@ void appPhyStateSetState(phyStateTaskData* phy_state, phyState new_state)
             break;
     }
 
+    appPhyStateUpdateProximityRate(phy_state);
 }
 
 /*! \brief Get the current physical state of the device.
@@ -465,6 +618,21 @@ phyState appPhyStateGetState(void)
     return phy_state->state;
 }
 
+uint8 appPhyStateGetInEarConfidence(void)
+{
+    return appPhyStateFusionConfidence(appGetPhyState());
+}
+
+uint16 appPhyStateGetSuppressedTransitions(void)
+{
+    return appGetPhyState()->fusion.suppressed;
+}
+
+uint16 appPhyStateGetFusedTransitions(void)
+{
+    return appGetPhyState()->fusion.transitions;
+}
+
 /*! \brief Handle notification that Earbud is now in the case. */
 void appPhyStateInCaseEvent(void)
 {
@@ -78,6 +78,27 @@ typedef struct
     bool in_motion;
     /*! Stores the proximity state */
     bool in_proximity;
+    /*! Sensor fusion state, filters the raw sensor reports into in/out of
+        ear events */
+    struct
+    {
+        /*! Latest raw proximity sensor state */
+        bool proximity;
+        /*! Latest raw motion state */
+        bool motion;
+        /*! Latest charger state */
+        bool charger;
+        /*! TRUE once the proximity sensor has reported */
+        bool proximity_known;
+        /*! TRUE once a fused in/out of ear decision has been made */
+        bool valid;
+        /*! The last fused decision */
+        bool in_ear;
+        /*! Number of fused in/out of ear transitions */
+        uint16 transitions;
+        /*! Number of raw transitions rejected by the dwell filter */
+        uint16 suppressed;
+    } fusion;
 } phyStateTaskData;
 
 /*! \brief Messages which may be sent by the Physical State module. */
@@ -103,6 +124,7 @@ typedef enum
     PHY_STATE_INTERNAL_OUT_OF_EAR_EVENT,
     PHY_STATE_INTERNAL_MOTION,
     PHY_STATE_INTERNAL_NOT_IN_MOTION,
+    PHY_STATE_INTERNAL_FUSION_TIMEOUT,
 };
 
 /*! \brief Register a task for notification of changes in state.
@@ -138,6 +160,22 @@ extern void appPhyStateMotionEvent(void);
 /*! \brief Handle notification that Earbud is now not moving. */
 extern void appPhyStateNotInMotionEvent(void);
 
+/*! \brief Get the sensor fusion in-ear confidence.
+    \return The confidence the earbud is in the ear, 0-100.
+*/
+extern uint8 appPhyStateGetInEarConfidence(void);
+
+/*! \brief Get the number of raw sensor transitions rejected by the sensor
+           fusion dwell filter.
+    \return The number of suppressed transitions.
+*/
+extern uint16 appPhyStateGetSuppressedTransitions(void);
+
+/*! \brief Get the number of in/out of ear transitions made by the sensor fusion.
+    \return The number of fused transitions.
+*/
+extern uint16 appPhyStateGetFusedTransitions(void);
+
 /*! \brief Tell the phy state module to prepare for entry to dormant.
            Phy state unregisters itself as a client of all sensors which (if
            phy state is the only remaining client), will cause the sensors to
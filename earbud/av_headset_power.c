@@ -96,6 +96,13 @@ void appPowerPerformanceProfileRelinquish(void)
 
 #ifdef INCLUDE_POWER_CONTROL
 
+/*! \brief Idle power statistics kept in PS, so they survive dormant */
+typedef struct
+{
+    uint16 idle_mean_secs[APP_POWER_IDLE_CONTEXTS]; /*!< Average length of idle periods in each context */
+    uint16 dormant_context;                         /*!< Context dormant was entered from, or #APP_POWER_IDLE_CONTEXTS */
+} powerIdlePsData;
+
 /*! \brief Query if power is going to dormant mode */
 #define appPowerGoingToDormant() (appSmIsSleepy() && \
                                   APP_POWER_LOW_POWER_MODE_DORMANT \
@@ -131,6 +138,121 @@ void appPowerEnterAsleep(void)
      MessageSendLater(appGetPowerTask(), APP_POWER_INTERNAL_POWER_OFF_TIMEOUT, NULL, APP_POWER_OFF_DORMANT_RETRY_MS);
 }
 
+/*! \brief Get the idle context from the physical state */
+static appPowerIdleContext appPowerGetIdleContext(void)
+{
+    switch (appPhyStateGetState())
+    {
+        case PHY_STATE_IN_CASE:
+            return APP_POWER_IDLE_CONTEXT_IN_CASE;
+
+        case PHY_STATE_OUT_OF_EAR_AT_REST:
+            return APP_POWER_IDLE_CONTEXT_AT_REST;
+
+        default:
+            return APP_POWER_IDLE_CONTEXT_OUT_OF_EAR;
+    }
+}
+
+/*! \brief Add the length of an idle period to the average for its context */
+static void appPowerIdleUpdateMean(appPowerIdleContext context, uint32 idle_secs)
+{
+    uint16 *mean = &appGetPowerControl()->idle_mean_secs[context];
+
+    if (idle_secs > 0xFFFF)
+        idle_secs = 0xFFFF;
+
+    if (*mean)
+        *mean = (uint16)((3UL * *mean + idle_secs) / 4);
+    else
+        *mean = (uint16)idle_secs;
+
+    DEBUG_LOGF("appPowerIdleUpdateMean, context %d, idle %lu, mean %u", context, idle_secs, *mean);
+}
+
+/*! \brief End the current idle period (if any) and record its length */
+static void appPowerIdleEnd(void)
+{
+    powerTaskData *thePower = appGetPowerControl();
+
+    if (thePower->idle_active)
+    {
+        appPowerIdleUpdateMean(thePower->idle_context,
+                               (VmGetClock() - thePower->idle_start_ms) / 1000);
+        thePower->idle_active = FALSE;
+        thePower->idle_blocked = FALSE;
+    }
+}
+
+/*! \brief Get the idle timeout for a context
+
+    Entering dormant costs a reboot and reconnection, which is only worth
+    it if the idle period is expected to last much longer than the
+    equivalent time awake. Otherwise stay awake for the default timeout.
+*/
+static uint32 appPowerGetIdleTimeoutForContext(appPowerIdleContext context)
+{
+    if (appGetPowerControl()->idle_mean_secs[context] > 2 * appConfigPowerDormantWakeCostSecs())
+        return appConfigPowerIdlePredictiveTimeoutSecs();
+
+    return APP_AUTO_POWER_OFF_TIMEOUT;
+}
+
+uint32 appPowerGetIdleTimeout(void)
+{
+    return appPowerGetIdleTimeoutForContext(appPowerGetIdleContext());
+}
+
+/*! \brief Re-check idle power down if it was blocked
+
+    Called when a condition that may have blocked idle power down
+    changes, so that power down happens as soon as it is allowed rather
+    than after another idle period.
+*/
+static void appPowerIdleRecheck(void)
+{
+    powerTaskData *thePower = appGetPowerControl();
+
+    if (   thePower->idle_active && thePower->idle_blocked
+        && (!thePower->allow_powerdown_fn || (*thePower->allow_powerdown_fn)()))
+    {
+        DEBUG_LOG("appPowerIdleRecheck, no longer blocked");
+        MessageCancelFirst(appGetPowerTask(), APP_POWER_INTERNAL_AUTO_POWER_OFF);
+        MessageSend(appGetPowerTask(), APP_POWER_INTERNAL_AUTO_POWER_OFF, NULL);
+    }
+}
+
+/*! \brief Store the idle statistics before entering dormant */
+static void appPowerIdleStoreForDormant(void)
+{
+    powerTaskData *thePower = appGetPowerControl();
+    powerIdlePsData ps_data;
+
+    memcpy(ps_data.idle_mean_secs, thePower->idle_mean_secs, sizeof(ps_data.idle_mean_secs));
+    ps_data.dormant_context = thePower->idle_active ? thePower->idle_context : APP_POWER_IDLE_CONTEXTS;
+    PsStore(PS_POWER_IDLE, &ps_data, sizeof(ps_data));
+}
+
+/*! \brief Restore the idle statistics, accounting for any time in dormant */
+static void appPowerIdleRestore(void)
+{
+    powerTaskData *thePower = appGetPowerControl();
+    powerIdlePsData ps_data;
+
+    if (PsRetrieve(PS_POWER_IDLE, &ps_data, sizeof(ps_data)) != sizeof(ps_data))
+        return;
+
+    memcpy(thePower->idle_mean_secs, ps_data.idle_mean_secs, sizeof(thePower->idle_mean_secs));
+    if (ps_data.dormant_context < APP_POWER_IDLE_CONTEXTS)
+    {
+        appPowerIdleUpdateMean(ps_data.dormant_context, appConfigPowerDormantAssumedIdleSecs());
+
+        /* Only account for the dormant period once */
+        ps_data.dormant_context = APP_POWER_IDLE_CONTEXTS;
+        PsStore(PS_POWER_IDLE, &ps_data, sizeof(ps_data));
+    }
+}
+
 void appPowerOffTimerRestart(void)
 {
     powerTaskData *thePower = appGetPowerControl();
@@ -138,12 +260,17 @@ void appPowerOffTimerRestart(void)
     DEBUG_LOGF("appPowerOffTimerRestart. Flags 0x%X",thePower->power_events_mask);
 
     MessageCancelFirst(appGetPowerTask(), APP_POWER_INTERNAL_AUTO_POWER_OFF);
+    appPowerIdleEnd();
 
     /* Check if any events are active */
     if (APP_POWER_EVENT_NONE == thePower->power_events_mask)
     {
         /* (Re)start timer if all logged activity ceases */
-        MessageSendLater(appGetPowerTask(), APP_POWER_INTERNAL_AUTO_POWER_OFF, 0, D_SEC(APP_AUTO_POWER_OFF_TIMEOUT));
+        thePower->idle_context = appPowerGetIdleContext();
+        thePower->idle_start_ms = VmGetClock();
+        thePower->idle_active = TRUE;
+        MessageSendLater(appGetPowerTask(), APP_POWER_INTERNAL_AUTO_POWER_OFF, 0,
+                         D_SEC(appPowerGetIdleTimeoutForContext(thePower->idle_context)));
     }
 }
 
@@ -227,7 +354,11 @@ void appPowerHandleIdleTimer(void)
         && !(*thePower->allow_powerdown_fn)())
     {
         DEBUG_LOGF("Idle PowerDown aborted as not allowed (state:%d, phystate:%d)",appGetState(),appPhyStateGetState());
-        appPowerOffTimerRestart();
+
+        /* Stay idle and re-check, sooner if the blocking condition clears */
+        thePower->idle_blocked = TRUE;
+        MessageSendLater(appGetPowerTask(), APP_POWER_INTERNAL_AUTO_POWER_OFF, 0,
+                         D_SEC(appConfigPowerIdleRecheckSecs()));
         return;
     }
 
@@ -277,6 +408,8 @@ static void appPowerControlEnterDormantMode(bool extended_wakeup_events)
 
     appPhyStatePrepareToEnterDormant();
 
+    appPowerIdleStoreForDormant();
+
     /* An active charge module blocks dormant, regardless of whether
        it has power */
     appChargerForceDisable();
@@ -402,6 +535,10 @@ static void appPowerHandlePhyStateChanged(const PHY_STATE_CHANGED_IND_T *message
     {
         appPowerOffTimerRestart();
     }
+    else
+    {
+        appPowerIdleRecheck();
+    }
 }
 
 /*! \brief Handle the charger state changing
@@ -434,6 +571,7 @@ static void appPowerHandleChargerStateChanged(void)
     else
     {
         event = RULES_EVENT_CHARGER_DISCONNECTED;
+        appPowerIdleRecheck();
     }
 
     appConnRulesSetEvent(appGetPowerTask(), event);
@@ -547,6 +685,8 @@ void appPowerControlInit(void)
     thePower->performance_req_count = 0;
     VmRequestRunTimeProfile(VM_BALANCED);
 
+    appPowerIdleRestore();
+
     appPhyStateRegisterClient(appGetPowerTask());
 
     appChargerClientRegister(appGetPowerTask());
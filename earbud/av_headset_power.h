@@ -27,6 +27,15 @@ typedef enum power_powerdown_modes
     APP_POWER_LOW_POWER_MODE_OFF        /*!< Attempting to power off */
 } appPowerPowerdownType;
 
+/*! \brief Contexts in which idle periods are tracked separately */
+typedef enum power_idle_contexts
+{
+    APP_POWER_IDLE_CONTEXT_IN_CASE,     /*!< In the case without a charger */
+    APP_POWER_IDLE_CONTEXT_AT_REST,     /*!< Out of the ear and not moving, e.g. on a table */
+    APP_POWER_IDLE_CONTEXT_OUT_OF_EAR,  /*!< Out of the ear, may be moving */
+    APP_POWER_IDLE_CONTEXTS             /*!< Number of idle contexts */
+} appPowerIdleContext;
+
 /*! \brief Function type used to get permission for reducing the power mode.
 
     Should be used in conjunction with \ref appPowerRegisterPowerDownCheck()
@@ -45,6 +54,11 @@ typedef struct
     bool                    allow_dormant;          /*!< Flag that can be modified during testing to disable dormant */
     bool                    cancel_dormant;         /*!< Flag set during dormant transition to abandon it */
     uint32                  performance_req_count;  /*!< Counts the number of requestors for VM_PERFORMANCE profile */
+    uint32                  idle_start_ms;          /*!< Time (VmGetClock) the current idle period started */
+    bool                    idle_active;            /*!< Flag set while an idle period is in progress */
+    bool                    idle_blocked;           /*!< Flag set when idle power down was blocked by the power down check */
+    appPowerIdleContext     idle_context;           /*!< Context of the current idle period */
+    uint16                  idle_mean_secs[APP_POWER_IDLE_CONTEXTS]; /*!< Average length of idle periods in each context */
 } powerTaskData;
 
 
@@ -196,6 +210,15 @@ extern void appPowerPerformanceProfileRelinquish(void);
 
 extern void appPowerRuntimeProfileWithdrawRequest(vm_runtime_profile profile);
 
+/*! \brief Get the idle timeout for the current context.
+
+    Contexts where idle periods are typically long enough to outweigh the
+    cost of a dormant-then-wake cycle use a shorter idle timeout.
+
+    \return The idle timeout in seconds.
+*/
+extern uint32 appPowerGetIdleTimeout(void);
+
 
 #endif /* INCLUDE_POWER_CONTROL */
 
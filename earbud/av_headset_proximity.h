@@ -22,6 +22,20 @@ enum proximity_messages
     PROXIMITY_MESSAGE_NOT_IN_PROXIMITY,
 };
 
+/*! Measurement rate profiles. The sensor type specific config maps each
+    profile to a measurement rate. */
+typedef enum
+{
+    /*! Measurements stopped, no IR LED pulses */
+    proximity_rate_profile_off,
+    /*! Very slow measurements, when at rest out of the ear */
+    proximity_rate_profile_rest,
+    /*! Default measurement rate */
+    proximity_rate_profile_normal,
+    /*! Fast measurements, after motion is detected out of the ear */
+    proximity_rate_profile_motion,
+} proximityRateProfile;
+
 /*! Forward declaration of a config structure (type dependent) */
 struct __proximity_config;
 /*! Proximity config incomplete type */
@@ -46,6 +60,8 @@ typedef struct
     proximityState *state;
     /*! The config */
     const proximityConfig *config;
+    /*! The current measurement rate profile */
+    proximityRateProfile profile;
 } proximityTaskData;
 
 /*! \brief Register with proximity to receive notifications.
@@ -70,4 +86,15 @@ extern void appProximityClientUnregister(Task task);
 #define appProximityClientUnregister(task) ((void)task)
 #endif
 
+/*! \brief Select the proximity measurement rate profile.
+    \param profile The new profile.
+    The profile is reset to #proximity_rate_profile_normal when the sensor is
+    enabled. Changing profile also recalibrates the thresholds if no object is
+    in proximity. */
+#if defined(INCLUDE_PROXIMITY)
+extern void appProximitySetRateProfile(proximityRateProfile profile);
+#else
+#define appProximitySetRateProfile(profile) ((void)profile)
+#endif
+
 #endif // AV_HEADSET_PROXIMITY_H
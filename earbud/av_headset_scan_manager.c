@@ -13,6 +13,18 @@
 
 #include <connection.h>
 
+/*! @brief Slow page scan parameters for each decay level. */
+static const struct
+{
+    uint16 interval;
+    uint16 window;
+} scan_man_page_decay[SCAN_MAN_PAGESCAN_DECAY_LEVELS] =
+{
+    {SCAN_MAN_PAGESCAN_INTERVAL_SLOW,  SCAN_MAN_PAGESCAN_WINDOW_SLOW},
+    {SCAN_MAN_PAGESCAN_INTERVAL_DECAY, SCAN_MAN_PAGESCAN_WINDOW_DECAY},
+    {SCAN_MAN_PAGESCAN_INTERVAL_IDLE,  SCAN_MAN_PAGESCAN_WINDOW_IDLE},
+};
+
 /*! @brief Determine which scan type to use when enabling a specified scan type. */
 static hci_scan_enable appScanManagerEnableType(scanManagerTaskData* scanning,
                                                 hci_scan_enable requested_type)
@@ -72,11 +84,12 @@ static void appScanManagerChangeInqParams(scanManagerTaskData* scanning,
 static void appScanManagerChangePageParams(scanManagerTaskData* scanning,
                                            scanParamsType page_type)
 {
-    DEBUG_LOGF("SCANMAN Page scan params changed to %d", page_type);
+    DEBUG_LOGF("SCANMAN Page scan params changed to %d, decay %d, boost %d",
+               page_type, scanning->page_decay, scanning->page_boost);
 
-    if (page_type == SCAN_MAN_PARAMS_TYPE_SLOW)
-        ConnectionWritePagescanActivity(SCAN_MAN_PAGESCAN_INTERVAL_SLOW,
-                                        SCAN_MAN_PAGESCAN_WINDOW_SLOW);
+    if (page_type == SCAN_MAN_PARAMS_TYPE_SLOW && !scanning->page_boost)
+        ConnectionWritePagescanActivity(scan_man_page_decay[scanning->page_decay].interval,
+                                        scan_man_page_decay[scanning->page_decay].window);
     else
         ConnectionWritePagescanActivity(SCAN_MAN_PAGESCAN_INTERVAL_FAST,
                                         SCAN_MAN_PAGESCAN_WINDOW_FAST);
@@ -85,6 +98,115 @@ static void appScanManagerChangePageParams(scanManagerTaskData* scanning,
     scanning->current_page_scan_params = page_type;
 }
 
+/*! @brief Re-apply slow page scan parameters after a change in decay or boost. */
+static void appScanManagerRefreshPageParams(scanManagerTaskData* scanning)
+{
+    if (scanning->current_page_scan_params == SCAN_MAN_PARAMS_TYPE_SLOW)
+        appScanManagerChangePageParams(scanning, SCAN_MAN_PARAMS_TYPE_SLOW);
+}
+
+/*! @brief Restart page scan decay from the slow parameters. */
+static void appScanManagerRestartPageDecay(scanManagerTaskData* scanning)
+{
+    scanning->page_decay = 0;
+    MessageCancelAll(&scanning->task, SCAN_MAN_INTERNAL_DECAY_TIMEOUT);
+    MessageSendLater(&scanning->task, SCAN_MAN_INTERNAL_DECAY_TIMEOUT, NULL,
+                     appConfigScanManagerDecayStepMs());
+}
+
+/*! @brief Handle page scan decay timer, move to the next decay level. */
+static void appScanManagerHandleInternalDecayTimeout(scanManagerTaskData* scanning)
+{
+    if (scanning->page_decay < SCAN_MAN_PAGESCAN_DECAY_LEVELS - 1)
+    {
+        scanning->page_decay++;
+        appScanManagerRefreshPageParams(scanning);
+    }
+
+    if (scanning->page_decay < SCAN_MAN_PAGESCAN_DECAY_LEVELS - 1)
+        MessageSendLater(&scanning->task, SCAN_MAN_INTERNAL_DECAY_TIMEOUT, NULL,
+                         appConfigScanManagerDecayStepMs());
+}
+
+/*! @brief Handle end of page scan boost. */
+static void appScanManagerHandleInternalBoostTimeout(scanManagerTaskData* scanning)
+{
+    scanning->page_boost = FALSE;
+    appScanManagerRestartPageDecay(scanning);
+    appScanManagerRefreshPageParams(scanning);
+}
+
+/*! @brief Handle change in physical state.
+
+    Leaving the case, being picked up or put in the ear all predict that
+    the handset will connect shortly.
+ */
+static void appScanManagerHandlePhyStateChangedInd(scanManagerTaskData* scanning,
+                                                   const PHY_STATE_CHANGED_IND_T *ind)
+{
+    switch (ind->new_state)
+    {
+        case PHY_STATE_OUT_OF_EAR:
+        case PHY_STATE_IN_EAR:
+            appScanManagerBoostPageScan();
+            break;
+
+        default:
+            appScanManagerRestartPageDecay(scanning);
+            appScanManagerRefreshPageParams(scanning);
+            break;
+    }
+}
+
+/*! @brief Handle change in connection status.
+
+    A link loss means the device will most likely try to reconnect, any
+    other disconnection restarts the page scan decay.
+ */
+static void appScanManagerHandleConManagerConnectionInd(scanManagerTaskData* scanning,
+                                                        const CON_MANAGER_CONNECTION_IND_T *ind)
+{
+    if (ind->connected)
+        return;
+
+    if (ind->reason == hci_error_conn_timeout)
+        appScanManagerBoostPageScan();
+    else if (!scanning->page_boost)
+    {
+        appScanManagerRestartPageDecay(scanning);
+        appScanManagerRefreshPageParams(scanning);
+    }
+}
+
+/*! @brief Scan manager message handler. */
+static void appScanManagerHandleMessage(Task task, MessageId id, Message message)
+{
+    scanManagerTaskData* scanning = appGetScanning();
+    UNUSED(task);
+
+    switch (id)
+    {
+        case PHY_STATE_CHANGED_IND:
+            appScanManagerHandlePhyStateChangedInd(scanning, (const PHY_STATE_CHANGED_IND_T *)message);
+            break;
+
+        case CON_MANAGER_CONNECTION_IND:
+            appScanManagerHandleConManagerConnectionInd(scanning, (const CON_MANAGER_CONNECTION_IND_T *)message);
+            break;
+
+        case SCAN_MAN_INTERNAL_DECAY_TIMEOUT:
+            appScanManagerHandleInternalDecayTimeout(scanning);
+            break;
+
+        case SCAN_MAN_INTERNAL_BOOST_TIMEOUT:
+            appScanManagerHandleInternalBoostTimeout(scanning);
+            break;
+
+        default:
+            break;
+    }
+}
+
 /*! @brief Find the highest priority scan parameters for a specified scan type. */
 static scanParamsType appScanManagerHiPriParams(scanManagerTaskData* scanning,
                                                 hci_scan_enable type)
@@ -132,6 +254,12 @@ void appScanManagerInit(void)
     /* setup scan type of interlaced for both inquiry and page scans */
     ConnectionWritePageScanType(hci_scan_type_interlaced);
     ConnectionWriteInquiryScanType(hci_scan_type_interlaced);
+
+    /* adapt page scan duty cycle to events that predict an incoming connection */
+    scanning->task.handler = appScanManagerHandleMessage;
+    appPhyStateRegisterClient(&scanning->task);
+    appConManagerRegisterConnectionsClient(&scanning->task);
+    appScanManagerRestartPageDecay(scanning);
 }
 
 /*! @brief Enable inquiry scanning for a specifc user, with requested parameters. */
@@ -288,3 +416,36 @@ bool appScanManagerIsPageScanEnabledForUser(scanManagerUser user)
     scanManagerTaskData* scanning = appGetScanning();
     return ((scanning->page_scan_state & user) == user);
 }
+
+/*! @brief Temporarily raise the page scan duty cycle. */
+void appScanManagerBoostPageScan(void)
+{
+    scanManagerTaskData* scanning = appGetScanning();
+
+    DEBUG_LOG("SCANMAN Boost Page Scan");
+
+    scanning->page_boost = TRUE;
+    scanning->page_decay = 0;
+    MessageCancelAll(&scanning->task, SCAN_MAN_INTERNAL_DECAY_TIMEOUT);
+    MessageCancelAll(&scanning->task, SCAN_MAN_INTERNAL_BOOST_TIMEOUT);
+    MessageSendLater(&scanning->task, SCAN_MAN_INTERNAL_BOOST_TIMEOUT, NULL,
+                     appConfigScanManagerBoostMs());
+    appScanManagerRefreshPageParams(scanning);
+}
+
+/*! @brief Get the page scan parameters currently configured. */
+void appScanManagerGetPageScanActivity(uint16 *interval, uint16 *window)
+{
+    scanManagerTaskData* scanning = appGetScanning();
+
+    if (scanning->current_page_scan_params == SCAN_MAN_PARAMS_TYPE_SLOW && !scanning->page_boost)
+    {
+        *interval = scan_man_page_decay[scanning->page_decay].interval;
+        *window = scan_man_page_decay[scanning->page_decay].window;
+    }
+    else
+    {
+        *interval = SCAN_MAN_PAGESCAN_INTERVAL_FAST;
+        *window = SCAN_MAN_PAGESCAN_WINDOW_FAST;
+    }
+}
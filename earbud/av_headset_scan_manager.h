@@ -28,6 +28,19 @@
 /*! Slow page scan window. */
 #define SCAN_MAN_PAGESCAN_WINDOW_SLOW        210
 
+/*! Decayed page scan interval, used once no connection has been expected for a while. */
+#define SCAN_MAN_PAGESCAN_INTERVAL_DECAY     1280
+/*! Decayed page scan window. */
+#define SCAN_MAN_PAGESCAN_WINDOW_DECAY       36
+
+/*! Fully decayed page scan interval, the longest interval that keeps page scan mode R1. */
+#define SCAN_MAN_PAGESCAN_INTERVAL_IDLE      2048
+/*! Fully decayed page scan window. */
+#define SCAN_MAN_PAGESCAN_WINDOW_IDLE        18
+
+/*! Number of page scan decay levels, slow parameters are the first level. */
+#define SCAN_MAN_PAGESCAN_DECAY_LEVELS       3
+
 /*! Number of scan manager users. */
 #define SCAN_MAN_NUM_USERS  3
 
@@ -71,6 +84,9 @@ typedef enum
 /*! @brief Scan Manager state. */
 typedef struct
 {
+    /*! Scan manager task, receives physical state and connection indications. */
+    TaskData task;
+
     /*! Register of active inquiry scan users. */
     scanManagerUser inq_scan_state;
 
@@ -88,8 +104,26 @@ typedef struct
 
     /*! Currently configured page scan parameters. */
     scanParamsType  current_page_scan_params;
+
+    /*! Decay level applied to slow page scan parameters, increases with
+        time since the last event that predicts an incoming connection. */
+    unsigned page_decay:2;
+
+    /*! Flag indicating slow page scan is temporarily using fast parameters,
+        as an incoming connection is expected. */
+    bool page_boost:1;
 } scanManagerTaskData;
 
+/*! @brief Scan manager internal messages. */
+enum
+{
+    /*! Time to move to the next page scan decay level. */
+    SCAN_MAN_INTERNAL_DECAY_TIMEOUT = INTERNAL_MESSAGE_BASE,
+
+    /*! End of a page scan boost. */
+    SCAN_MAN_INTERNAL_BOOST_TIMEOUT,
+};
+
 /*! @brief Initialse the scan manager data structure. */
 void appScanManagerInit(void);
 
@@ -143,6 +177,21 @@ void appScanManagerDisablePageScan(scanManagerUser user);
 */
 void appScanManagerDisableInquiryPageScan(scanManagerUser user);
 
+/*! @brief Temporarily raise the page scan duty cycle.
+
+    Called on events that predict an incoming connection. Slow page scan
+    uses fast parameters for #appConfigScanManagerBoostMs and then decays
+    again from the slow parameters.
+ */
+void appScanManagerBoostPageScan(void);
+
+/*! @brief Get the page scan parameters currently configured.
+
+    @param interval [OUT] Page scan interval in slots.
+    @param window [OUT] Page scan window in slots.
+ */
+void appScanManagerGetPageScanActivity(uint16 *interval, uint16 *window);
+
 /*! @brief Determine if page scan is enabled.
     @param user [IN] User type to check if is enabled.
     @return bool TRUE page scan is enabled, FALSE page scan is not enabled.
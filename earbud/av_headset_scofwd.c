@@ -1130,7 +1130,18 @@ static void appScoFwdKickProcessing(void)
 static void appScoFwdHandleLinkConnectReq(void)
 {
     if (appScoFwdStateCanConnect())
-        appScoFwdSetState(SFWD_STATE_SDP_SEARCH);
+    {
+        scoFwdTaskData *theScoFwd = appGetScoFwd();
+        bdaddr peer_bd_addr;
+
+        /* Skip the SDP search if the peer's PSM is already known */
+        theScoFwd->remote_psm_cached = appDeviceGetPeerBdAddr(&peer_bd_addr) &&
+                                       appDeviceGetSdpScoFwdPsm(&peer_bd_addr, &theScoFwd->remote_psm);
+        if (theScoFwd->remote_psm_cached)
+            appScoFwdSetState(SFWD_STATE_CONNECTING_MASTER);
+        else
+            appScoFwdSetState(SFWD_STATE_SDP_SEARCH);
+    }
 }
 
 static void appScoFwdHandleLinkDisconnectReq(void)
@@ -1225,7 +1236,18 @@ static void appScoFwdHandleL2capConnectCfm(const CL_L2CAP_CONNECT_CFM_T *cfm)
             }
             else
             {
-                if (appScoFwdGetState() == SFWD_STATE_CONNECTING_MASTER)
+                if (appScoFwdGetState() == SFWD_STATE_CONNECTING_MASTER && theScoFwd->remote_psm_cached)
+                {
+                    bdaddr peer_bd_addr;
+
+                    /* Cached PSM may be stale, discard it and search again */
+                    DEBUG_LOG("appScoFwdHandleL2capConnectCfm, failed with cached psm, searching");
+                    if (appDeviceGetPeerBdAddr(&peer_bd_addr))
+                        appDeviceSetSdpScoFwdPsm(&peer_bd_addr, 0);
+                    theScoFwd->remote_psm_cached = FALSE;
+                    appScoFwdSetState(SFWD_STATE_SDP_SEARCH);
+                }
+                else if (appScoFwdGetState() == SFWD_STATE_CONNECTING_MASTER)
                 {
                     DEBUG_LOG("appScoFwdHandleL2capConnectCfm, failed, retrying connection");
                     appScoFwdRetryConnect();
@@ -1332,6 +1354,7 @@ static void appScoFwdHandleClSdpServiceSearchAttributeCfm(const CL_SDP_SERVICE_S
                                          &theScoFwd->remote_psm, saProtocolDescriptorList))
                 {
                     DEBUG_LOGF("appHandleClSdpServiceSearchAttributeCfm, peer psm %u", theScoFwd->remote_psm);
+                    appDeviceSetSdpScoFwdPsm(&cfm->bd_addr, theScoFwd->remote_psm);
 
                     appScoFwdSetState(SFWD_STATE_CONNECTING_MASTER);
                 }
@@ -1745,6 +1768,7 @@ void appScoFwdInit(void)
 
     /* Initialise state */
     theScoFwd->state = SFWD_STATE_NULL;
+    theScoFwd->remote_psm_cached = FALSE;
     appScoFwdSetState(SFWD_STATE_INITIALISING);
 
     /* Want to know about HFP calls */
@@ -82,6 +82,7 @@ typedef struct
     scoFwdState     state;                      /*!< Current state of the state machine */
     uint16          local_psm;                  /*!< L2CAP PSM registered */
     uint16          remote_psm;                 /*!< L2CAP PSM registered by peer device */
+    bool            remote_psm_cached;          /*!< remote_psm was taken from the SDP cache */
     Sink            link_sink;                  /*!< The sink of the L2CAP link */
     Source          link_source;                /*!< The source of the L2CAP link */
     Source          source;                     /*!< The audio source */
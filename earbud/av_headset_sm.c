@@ -24,6 +24,7 @@
 #include <connection.h>
 #include <ps.h>
 #include <boot.h>
+#include <vm.h>
 
 static void appSmHandleInternalDeleteHandsets(void);
 
@@ -746,11 +747,80 @@ appState appGetState(void)
 }
 
 
+/*! \brief Start tracing a locally initiated handset connection.
+
+    \param profiles The profiles being connected.
+*/
+static void appSmHandsetConnectTraceStart(uint8 profiles)
+{
+    smHandsetConnectTrace *trace = &appGetSm()->handset_connect_trace;
+
+    trace->start_ms = VmGetClock();
+    trace->acl_ms = 0;
+    trace->hfp_ms = 0;
+    trace->a2dp_ms = 0;
+    trace->avrcp_ms = 0;
+    /* AVRCP is connected along with A2DP */
+    trace->profiles = (profiles & DEVICE_PROFILE_A2DP) ? (profiles | DEVICE_PROFILE_AVRCP) : profiles;
+    trace->active = TRUE;
+}
+
+/*! \brief Record completion of a phase of a traced handset connection.
+
+    \param bd_addr Address of the device the phase completed for.
+    \param phase_ms The phase in the trace to record.
+*/
+static void appSmHandsetConnectTraceMark(const bdaddr *bd_addr, uint16 *phase_ms)
+{
+    smHandsetConnectTrace *trace = &appGetSm()->handset_connect_trace;
+
+    if (trace->active && (*phase_ms == 0) && appDeviceIsHandset(bd_addr))
+    {
+        uint32 elapsed = VmGetClock() - trace->start_ms;
+
+        /* 0 is reserved for incomplete phases */
+        *phase_ms = (elapsed > 0xFFFF) ? 0xFFFF : (elapsed ? (uint16)elapsed : 1);
+
+        DEBUG_LOGF("appSmHandsetConnectTraceMark, acl %u, hfp %u, a2dp %u, avrcp %u",
+                   trace->acl_ms, trace->hfp_ms, trace->a2dp_ms, trace->avrcp_ms);
+
+        /* Stop tracing once all requested profiles are connected */
+        if (   (trace->hfp_ms || !(trace->profiles & DEVICE_PROFILE_HFP))
+            && (trace->a2dp_ms || !(trace->profiles & DEVICE_PROFILE_A2DP))
+            && (trace->avrcp_ms || !(trace->profiles & DEVICE_PROFILE_AVRCP)))
+        {
+            DEBUG_LOG("appSmHandsetConnectTraceMark, complete");
+            trace->active = FALSE;
+        }
+    }
+}
+
+/*! \brief Stop tracing a handset connection that failed.
+
+    A failed attempt would otherwise leave the trace active, so a later
+    connection would be timed from the start of the failed attempt.
+
+    \param bd_addr Address of the device the connection failed to.
+*/
+static void appSmHandsetConnectTraceFailed(const bdaddr *bd_addr)
+{
+    smHandsetConnectTrace *trace = &appGetSm()->handset_connect_trace;
+
+    if (trace->active && appDeviceIsHandset(bd_addr))
+    {
+        DEBUG_LOG("appSmHandsetConnectTraceFailed");
+        trace->active = FALSE;
+    }
+}
+
 /*! \brief Handle notification of (dis)connections. */
 static void appSmHandleConManagerConnectionInd(CON_MANAGER_CONNECTION_IND_T* ind)
 {
     DEBUG_LOGF("appSmHandleConManagerConnectionInd connected:%d", ind->connected);
 
+    if (ind->connected)
+        appSmHandsetConnectTraceMark(&ind->bd_addr, &appGetSm()->handset_connect_trace.acl_ms);
+
     switch (appGetState())
     {
         case APP_STATE_FACTORY_RESET:
@@ -1042,6 +1112,10 @@ static void appSmHandleConnRulesConnectHandset(CONN_RULES_CONNECT_HANDSET_T* crc
 {
     DEBUG_LOGF("appSmHandleConnRulesConnectHandset profiles:%u", crch->profiles);
 
+    /* HFP and A2DP connections both wait on the same ACL and start together
+       once it is up, AVRCP follows A2DP signalling */
+    appSmHandsetConnectTraceStart(crch->profiles);
+
     if (crch->profiles & DEVICE_PROFILE_HFP)
     {
         /* Connect HFP to handset */
@@ -1375,6 +1449,8 @@ static void appSmHandleAvA2dpConnectedInd(const AV_A2DP_CONNECTED_IND_T *ind)
 
     DEBUG_LOG("appSmHandleAvA2dpConnectedInd");
 
+    appSmHandsetConnectTraceMark(&ind->bd_addr, &sm->handset_connect_trace.a2dp_ms);
+
     if (appDeviceIsHandset(&ind->bd_addr))
     {
         /* Peer sync information we sent is now out of date */
@@ -1394,6 +1470,9 @@ static void appSmHandleAvA2dpDisconnectedInd(const AV_A2DP_DISCONNECTED_IND_T *i
 
     DEBUG_LOGF("appSmHandleAvA2dpDisconnectedInd, reason %u inst %x", ind->reason, ind->av_instance);
 
+    if (ind->reason == AV_A2DP_CONNECT_FAILED)
+        appSmHandsetConnectTraceFailed(&ind->bd_addr);
+
     switch (appGetState())
     {
         case APP_STATE_FACTORY_RESET:
@@ -1442,6 +1521,8 @@ static void appSmHandleAvAvrcpConnectedInd(const AV_AVRCP_CONNECTED_IND_T *ind)
 
     DEBUG_LOG("appSmHandleAvAvrcpConnectedInd");
 
+    appSmHandsetConnectTraceMark(&ind->bd_addr, &sm->handset_connect_trace.avrcp_ms);
+
     if (appDeviceIsHandset(&ind->bd_addr))
     {
         /* Peer sync information we sent is now out of date */
@@ -1550,6 +1631,8 @@ static void appSmHandleHfpConnectedInd(APP_HFP_CONNECTED_IND_T *ind)
 
     DEBUG_LOG("appSmHandleHfpConnectedInd");
 
+    appSmHandsetConnectTraceMark(&ind->bd_addr, &sm->handset_connect_trace.hfp_ms);
+
     if (appDeviceIsHandset(&ind->bd_addr))
     {
         /* Peer sync information we sent is now out of date */
@@ -1569,6 +1652,9 @@ static void appSmHandleHfpDisconnectedInd(APP_HFP_DISCONNECTED_IND_T *ind)
 
     DEBUG_LOGF("appSmHandleHfpDisconnectedInd, reason %u", ind->reason);
 
+    if (ind->reason == APP_HFP_CONNECT_FAILED)
+        appSmHandsetConnectTraceFailed(&ind->bd_addr);
+
     switch (appGetState())
     {
         case APP_STATE_FACTORY_RESET:
@@ -2205,6 +2291,9 @@ void appSmInit(void)
     sm->peer_sync_tx_seqnum = 0xFF;
     sm->peer_sync_rx_seqnum = 0xFF;
 
+    sm->handset_connect_trace.start_ms = 0;
+    sm->handset_connect_trace.active = FALSE;
+
     /* register with connection manager to get notification of (dis)connections */
     appConManagerRegisterConnectionsClient(&sm->task);
 
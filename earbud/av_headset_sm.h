@@ -160,6 +160,22 @@ typedef enum sm_peer_sync_states
     SM_PEER_SYNC_COMPLETE   = 3
 } smPeerSyncState;
 
+/*! \brief Trace of a locally initiated handset connection.
+
+    Each phase is the time it completed, in milliseconds from the start of
+    the connection, or 0 if it has not completed.
+*/
+typedef struct
+{
+    uint32 start_ms;                    /*!< Time the connection was started */
+    uint16 acl_ms;                      /*!< ACL connected */
+    uint16 hfp_ms;                      /*!< HFP SLC connected */
+    uint16 a2dp_ms;                     /*!< A2DP signalling connected */
+    uint16 avrcp_ms;                    /*!< AVRCP connected */
+    uint8 profiles;                     /*!< Profiles being connected */
+    bool active:1;                      /*!< Connection is being traced */
+} smHandsetConnectTrace;
+
 /*! \brief Main application state machine task data. */
 typedef struct
 {
@@ -184,6 +200,7 @@ typedef struct
     uint16 peer_sync_sending;
     uint8 peer_sync_tx_seqnum;
     uint8 peer_sync_rx_seqnum;
+    smHandsetConnectTrace handset_connect_trace; /*!< Trace of the last handset connection */
 } smTaskData;
 
 /*! \brief Change application state.
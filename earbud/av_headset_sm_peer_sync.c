@@ -207,6 +207,7 @@ void appSmSendPeerSync(bool response)
         sync_data.have_handset_pairing = !BdaddrIsZero(&handset_addr);
         sync_data.tx_seqnum = sm->peer_sync_tx_seqnum;
         sync_data.rx_seqnum = sm->peer_sync_rx_seqnum;
+        sync_data.sdp_records_version = appConfigSdpRecordsVersion();
 
         /* Attempt to send sync message to peer */
         appPeerSigSyncRequest(&sm->task, &peer_addr, &sync_data);
@@ -287,6 +288,14 @@ void appSmHandlePeerSigSyncIndication(PEER_SIG_SYNC_IND_T *ind)
     sm->peer_has_handset_pairing = ind->peer_has_handset_pairing;
     sm->peer_rules_in_progress = ind->peer_rules_in_progress;
 
+    /* Discard cached service search results if the peer's SDP records have changed */
+    if (ind->sdp_records_version)
+    {
+        bdaddr peer_addr;
+        if (appDeviceGetPeerBdAddr(&peer_addr))
+            appDeviceSetSdpRecordsVersion(&peer_addr, ind->sdp_records_version);
+    }
+
     /* update state that may generate events to the rules engine */
     appSmUpdatePeerInCase(ind->peer_in_case);
     appSmUpdatePeerInEar(ind->peer_in_ear);
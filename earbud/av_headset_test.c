@@ -39,6 +39,161 @@ void appTestSetBatteryVoltage(uint16 new_level)
     MessageSend(&appGetBattery()->task, MESSAGE_BATTERY_PROCESS_READING, NULL);
 }
 
+uint32 appTestGetBatteryWakeupsPerHour(void)
+{
+    return appBatteryGetWakeupsPerHour();
+}
+
+uint32 appTestGetChargerWakeupsPerHour(void)
+{
+    return appChargerGetWakeupsPerHour();
+}
+
+uint16 appTestGetHandsetLinkTrafficLevel(void)
+{
+    bdaddr bd_addr;
+
+    if (appDeviceGetHandsetBdAddr(&bd_addr))
+        return appLinkPolicyGetTrafficLevel(&bd_addr);
+    return LP_TRAFFIC_NORMAL;
+}
+
+void appTestGetPageScanActivity(uint16 *interval, uint16 *window)
+{
+    DEBUG_LOG("appTestGetPageScanActivity");
+    appScanManagerGetPageScanActivity(interval, window);
+}
+
+bool appTestGetPageCounts(const bdaddr *bd_addr, uint16 *pages, uint16 *failures)
+{
+    DEBUG_LOG("appTestGetPageCounts");
+    return appConManagerGetPageCounts(bd_addr, pages, failures);
+}
+
+void appTestGetSdpCacheCounts(uint16 *hits, uint16 *misses)
+{
+    deviceTaskData *theDevice = appGetDevice();
+    DEBUG_LOG("appTestGetSdpCacheCounts");
+    *hits = theDevice->sdp_cache_hits;
+    *misses = theDevice->sdp_cache_misses;
+}
+
+void appTestGetVolumeCounts(uint16 *operator_updates, uint16 *avrcp_msgs)
+{
+    DEBUG_LOG("appTestGetVolumeCounts");
+    *operator_updates = appGetKymera()->volume_updates;
+    *avrcp_msgs = appGetAv()->volume_avrcp_msgs;
+}
+
+void appTestGetA2dpSeidCacheCounts(uint16 *hits, uint16 *misses, uint16 *rejects)
+{
+    avTaskData *theAv = appGetAv();
+    DEBUG_LOG("appTestGetA2dpSeidCacheCounts");
+    *hits = theAv->seid_cache_hits;
+    *misses = theAv->seid_cache_misses;
+    *rejects = theAv->seid_cache_rejects;
+}
+
+bool appTestGetAacForwarding(uint16 *switches)
+{
+    DEBUG_LOG("appTestGetAacForwarding");
+    *switches = appGetAv()->aac_forwarding_switches;
+    return appAvAacForwardingIsPassthrough();
+}
+
+void appTestGetAvrcpPassthroughStats(avrcpPassthroughStats *stats)
+{
+    DEBUG_LOG("appTestGetAvrcpPassthroughStats");
+    *stats = appGetAv()->avrcp_passthrough_stats;
+}
+
+bool appTestAvSwitchHandset(uint16 *switches)
+{
+    DEBUG_LOG("appTestAvSwitchHandset");
+    *switches = appGetAv()->handset_switches;
+    return appAvSwitchHandset();
+}
+
+void appTestGetA2dpSilenceStats(uint16 *suspends, uint32 *suspended_ms)
+{
+    DEBUG_LOG("appTestGetA2dpSilenceStats");
+    *suspends = appGetAv()->silence_suspends;
+    *suspended_ms = appGetAv()->silence_suspended_ms;
+}
+
+void appTestKymeraForwardingLinkReport(int8 rssi)
+{
+    DEBUG_LOGF("appTestKymeraForwardingLinkReport, rssi %d", rssi);
+    appKymeraA2dpForwardingLinkReport(rssi);
+}
+
+void appTestGetKymeraForwardingQuality(uint16 *quality, uint16 *changes, uint16 *reports)
+{
+    kymeraTaskData *theKymera = appGetKymera();
+    DEBUG_LOG("appTestGetKymeraForwardingQuality");
+    *quality = theKymera->forwarding_quality;
+    *changes = theKymera->forwarding_quality_changes;
+    *reports = theKymera->forwarding_reports;
+}
+
+bool appTestA2dpSetLowLatency(const bdaddr *bd_addr, bool low_latency)
+{
+    DEBUG_LOGF("appTestA2dpSetLowLatency, low latency %u", low_latency);
+    return appA2dpSetLowLatency(bd_addr, low_latency);
+}
+
+bool appTestGetA2dpLatency(const bdaddr *bd_addr, uint16 *latency_ms, uint16 *congestion)
+{
+    appDeviceAttributes attributes;
+    DEBUG_LOG("appTestGetA2dpLatency");
+
+    *latency_ms = appKymeraA2dpLatencyMs(appGetKymera()->latency_mode);
+    if (!appDeviceFindBdAddrAttributes(bd_addr, &attributes))
+        return FALSE;
+
+    *congestion = attributes.a2dp_congestion;
+    return TRUE;
+}
+
+bool appTestGetA2dpStartStats(const bdaddr *bd_addr, a2dpStartStats *stats)
+{
+    DEBUG_LOG("appTestGetA2dpStartStats");
+    return appA2dpGetStartStats(bd_addr, stats);
+}
+
+void appTestGetPeerDiscoveryStats(pairingPeerDiscoveryStats *stats)
+{
+    DEBUG_LOG("appTestGetPeerDiscoveryStats");
+    *stats = appGetPairing()->discovery_stats;
+}
+
+bool appTestGetHandsetConnectTrace(smHandsetConnectTrace *trace)
+{
+    smTaskData *sm = appGetSm();
+    DEBUG_LOG("appTestGetHandsetConnectTrace");
+    *trace = sm->handset_connect_trace;
+    return sm->handset_connect_trace.start_ms != 0;
+}
+
+bool appTestGetHfpAtCmdLatency(hfpAtCmdType type, hfpAtCmdLatency *latency)
+{
+    DEBUG_LOG("appTestGetHfpAtCmdLatency");
+    return appHfpGetAtCmdLatency(type, latency);
+}
+
+bool appTestGetLinkStats(const bdaddr *bd_addr, conManagerLinkStats *stats,
+                         uint16 *supervision_timeouts)
+{
+    DEBUG_LOG("appTestGetLinkStats");
+    return appConManagerGetLinkStats(bd_addr, stats, supervision_timeouts);
+}
+
+bool appTestGetRoleSwitchCounts(const bdaddr *bd_addr, uint16 *attempts, uint16 *failures)
+{
+    DEBUG_LOG("appTestGetRoleSwitchCounts");
+    return appConManagerGetRoleSwitchCounts(bd_addr, attempts, failures);
+}
+
 
 /*! \brief Put Earbud into Handset Pairing mode
 */
@@ -630,6 +785,16 @@ void appTestPowerAllowDormant(bool enable)
 #endif
 }
 
+uint32 appTestPowerGetIdleTimeout(void)
+{
+#ifdef INCLUDE_POWER_CONTROL
+    return appPowerGetIdleTimeout();
+#else
+    DEBUG_LOG("appTestPowerGetIdleTimeout: Power Control/Dormant is not in this build.");
+    return 0;
+#endif
+}
+
 /*! \brief Test the generation of link kets */
 extern void TestLinkkeyGen(void)
 {
@@ -760,6 +925,16 @@ void appTestPhyStateNotInMotionEvent(void)
     appPhyStateNotInMotionEvent();
 }
 
+uint16 appTestPhyStateGetSuppressedTransitions(void)
+{
+    return appPhyStateGetSuppressedTransitions();
+}
+
+uint16 appTestPhyStateGetFusedTransitions(void)
+{
+    return appPhyStateGetFusedTransitions();
+}
+
 #define ATTRIBUTE_BASE_PSKEY_INDEX  100
 #define TDL_BASE_PSKEY_INDEX        142
 #define TDL_INDEX_PSKEY             141
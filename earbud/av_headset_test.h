@@ -34,6 +34,202 @@ uint16 appTestGetBatteryVoltage(void);
  */
 void appTestSetBatteryVoltage(uint16 new_level);
 
+/*! \brief Returns the number of VM wakeups per hour made to take battery
+    measurements.
+ */
+uint32 appTestGetBatteryWakeupsPerHour(void);
+
+/*! \brief Returns the number of VM wakeups per hour made to poll the charger.
+ */
+uint32 appTestGetChargerWakeupsPerHour(void);
+
+/*! \brief Returns the traffic level of the handset link, as used to
+    adapt its sniff parameters.
+
+    \return #lpTrafficLevel of the handset link, #LP_TRAFFIC_NORMAL if
+            there is no handset.
+ */
+uint16 appTestGetHandsetLinkTrafficLevel(void);
+
+/*! \brief Get the page scan parameters currently configured
+
+    \param interval  Pointer to the page scan interval in slots
+    \param window    Pointer to the page scan window in slots
+ */
+void appTestGetPageScanActivity(uint16 *interval, uint16 *window);
+
+/*! \brief Get the page counters for a device
+
+    \param bd_addr   Address of the device
+    \param pages     Pointer to the number of times the device has been paged
+    \param failures  Pointer to the number of pages that failed
+
+    \return TRUE if the device has been connected or paged recently
+ */
+bool appTestGetPageCounts(const bdaddr *bd_addr, uint16 *pages, uint16 *failures);
+
+/*! \brief Get the SDP cache counters
+
+    \param hits      Pointer to the number of service searches skipped using
+                     cached results
+    \param misses    Pointer to the number of service searches required as
+                     there was no valid cached result
+ */
+void appTestGetSdpCacheCounts(uint16 *hits, uint16 *misses);
+
+/*! \brief Get the volume update counters
+
+    Use to check the number of updates made for a burst of volume changes,
+    e.g. a volume key repeat or handset slider drag.
+
+    \param operator_updates  Pointer to the number of gain updates made to
+                             volume operators
+    \param avrcp_msgs        Pointer to the number of AVRCP volume commands and
+                             notifications sent
+ */
+void appTestGetVolumeCounts(uint16 *operator_updates, uint16 *avrcp_msgs);
+
+/*! \brief Get the A2DP SEID cache counters
+
+    \param hits     Pointer to the number of handset media opens requested with
+                    a cached SEID
+    \param misses   Pointer to the number of handset media opens needing full
+                    negotiation
+    \param rejects  Pointer to the number of cached SEIDs rejected by a handset
+ */
+void appTestGetA2dpSeidCacheCounts(uint16 *hits, uint16 *misses, uint16 *rejects);
+
+/*! \brief Get the AAC forwarding mode
+
+    \param switches Pointer to the number of AAC forwarding mode changes
+
+    \return TRUE if AAC is forwarded to the peer without transcoding
+ */
+bool appTestGetAacForwarding(uint16 *switches);
+
+/*! \brief Get the AVRCP passthrough command statistics
+
+    Shows how many remote control commands were coalesced or dropped by the
+    passthrough queue and the time from queueing to confirmation.
+
+    \param stats    Pointer to the statistics
+ */
+void appTestGetAvrcpPassthroughStats(avrcpPassthroughStats *stats);
+
+/*! \brief Switch audio to the other connected handset
+
+    Only possible if both handsets are streaming, see appAvSwitchHandset().
+
+    \param switches Pointer to the number of times audio switched between handsets
+
+    \return TRUE if a switch was requested
+ */
+bool appTestAvSwitchHandset(uint16 *switches);
+
+/*! \brief Get statistics for streams suspended while the handset was silent
+
+    \param suspends     Pointer to the number of streams suspended
+    \param suspended_ms Pointer to the total time streams were suspended, an
+                        estimate of the time the DSP and radio were saved
+ */
+void appTestGetA2dpSilenceStats(uint16 *suspends, uint32 *suspended_ms);
+
+/*! \brief Inject a peer link report, as if sent by the TWS slave
+
+    Used to simulate a poor peer link on the master, see
+    appKymeraA2dpForwardingLinkReport().
+
+    \param rssi Average RSSI of the peer link
+ */
+void appTestKymeraForwardingLinkReport(int8 rssi);
+
+/*! \brief Get the A2DP forwarding quality
+
+    \param quality  Pointer to the current #kymeraForwardingQuality
+    \param changes  Pointer to the number of forwarding quality changes
+    \param reports  Pointer to the number of peer link reports sent or received
+ */
+void appTestGetKymeraForwardingQuality(uint16 *quality, uint16 *changes, uint16 *reports);
+
+/*! \brief Mark a handset as needing low latency audio, e.g. for gaming
+
+    \param bd_addr     Address of the handset
+    \param low_latency TRUE for low latency
+
+    \return TRUE if the handset is known
+ */
+bool appTestA2dpSetLowLatency(const bdaddr *bd_addr, bool low_latency);
+
+/*! \brief Get the A2DP output latency
+
+    \param bd_addr     Address of the handset
+    \param latency_ms  Pointer to the latency of the current stream
+    \param congestion  Pointer to the handset's count of recent streams that
+                       needed robust forwarding
+
+    \return TRUE if the handset is known
+ */
+bool appTestGetA2dpLatency(const bdaddr *bd_addr, uint16 *latency_ms, uint16 *congestion);
+
+/*! \brief Get the A2DP media start statistics for a device
+
+    Each phase of a remotely initiated media start is timed from the
+    A2DP_MEDIA_START_IND, see #a2dpStartPhase.
+
+    \param bd_addr   Address of the device
+    \param stats     Pointer to the statistics
+
+    \return TRUE if statistics exist for the device
+ */
+bool appTestGetA2dpStartStats(const bdaddr *bd_addr, a2dpStartStats *stats);
+
+/*! \brief Get the peer pairing discovery statistics
+
+    \param stats     Pointer to the statistics, see #pairingPeerDiscoveryStats
+ */
+void appTestGetPeerDiscoveryStats(pairingPeerDiscoveryStats *stats);
+
+/*! \brief Get the trace of the last locally initiated handset connection
+
+    The time to audio ready is the later of the HFP and A2DP phases.
+
+    \param trace     Pointer to the connection trace
+
+    \return TRUE if a handset connection has been traced, FALSE otherwise
+ */
+bool appTestGetHandsetConnectTrace(smHandsetConnectTrace *trace);
+
+/*! \brief Get the round-trip latency of an HFP AT command type
+
+    \param type      The AT command type, \ref hfpAtCmdType
+    \param latency   Pointer to the latency statistics for the type
+
+    \return TRUE if the type is valid, FALSE otherwise
+ */
+bool appTestGetHfpAtCmdLatency(hfpAtCmdType type, hfpAtCmdLatency *latency);
+
+/*! \brief Get the statistics for the ACL to a device
+
+    \param bd_addr   Address of the device
+    \param stats     Pointer to the link statistics
+    \param supervision_timeouts Pointer to the number of ACLs to the device
+                     lost to a supervision timeout
+
+    \return TRUE if there is an ACL to the device, FALSE otherwise
+ */
+bool appTestGetLinkStats(const bdaddr *bd_addr, conManagerLinkStats *stats,
+                         uint16 *supervision_timeouts);
+
+/*! \brief Get the role switch counters for the ACL to a device
+
+    \param bd_addr   Address of the device
+    \param attempts  Pointer to the number of role switches requested
+    \param failures  Pointer to the number of role switches that failed
+
+    \return TRUE if there is an ACL to the device, FALSE otherwise
+ */
+bool appTestGetRoleSwitchCounts(const bdaddr *bd_addr, uint16 *attempts, uint16 *failures);
+
 /*! \brief Put Earbud into Handset Pairing mode
 */
 void appTestPairHandset(void);
@@ -359,6 +555,13 @@ void appTestAvVolumeSetDb(int8 gain);
 */
 void appTestPowerAllowDormant(bool enable);
 
+/*! \brief Get the idle timeout the earbud would use in its current context.
+
+    \return The idle timeout in seconds, 0 if power control is not in
+            this build.
+*/
+uint32 appTestPowerGetIdleTimeout(void);
+
 /*! \brief Generate event that Earbud is now in the case. */
 void appTestPhyStateInCaseEvent(void);
 
@@ -377,6 +580,22 @@ void appTestPhyStateMotionEvent(void);
 /*! \brief Generate event that Earbud is now not moving. */
 void appTestPhyStateNotInMotionEvent(void);
 
+/*! \brief Get the number of raw in/out of ear sensor transitions that were
+           rejected by the physical state sensor fusion.
+
+    \return The number of suppressed transitions since the physical state
+            module was initialised.
+*/
+uint16 appTestPhyStateGetSuppressedTransitions(void);
+
+/*! \brief Get the number of in/out of ear transitions made by the physical
+           state sensor fusion.
+
+    \return The number of fused transitions since the physical state
+            module was initialised.
+*/
+uint16 appTestPhyStateGetFusedTransitions(void);
+
 /*! \brief Generate event that Earbud is now (going) off. */
 void appTestPhyStateOffEvent(void);
 
@@ -47,7 +47,7 @@ static void appHandleClDmModeChangeEvent(CL_DM_MODE_CHANGE_EVENT_T *evt)
     MessageSend(&testTask,CL_DM_MODE_CHANGE_EVENT,fwd);
 #endif
 
-    UNUSED(evt);
+    appConManagerHandleClDmModeChangeEvent(evt);
 }
 
 /*! \brief Handle subsystem event report. */
@@ -158,6 +158,57 @@ static bool vncl3020ReadProximityResult(bitserial_handle handle, uint16 *proximi
     return result;
 }
 
+/*! \brief Get the sensor rate for a profile */
+static enum vncl3020_proximity_rates vncl3020GetProfileRate(const proximityConfig *config,
+                                                            proximityRateProfile profile)
+{
+    switch (profile)
+    {
+        case proximity_rate_profile_rest:
+            return config->rate_rest;
+        case proximity_rate_profile_motion:
+            return config->rate_motion;
+        default:
+            return config->rate;
+    }
+}
+
+/*! \brief Update the threshold calibration from the current measurement.
+    Only called when no object is in proximity, so the measurement is the
+    sensor's baseline (mostly cover glass crosstalk). */
+static void vncl3020Calibrate(proximityTaskData *proximity)
+{
+    const proximityConfig *config = proximity->config;
+    proximityState *state = proximity->state;
+    uint16 measurement;
+    int32 offset;
+
+    if (!vncl3020ReadProximityResult(proximity->handle, &measurement) || measurement == 0)
+    {
+        return;
+    }
+
+    /* Filter the baseline, the first measurement seeds the filter */
+    if (state->baseline == 0)
+        state->baseline = measurement;
+    else
+        state->baseline = (uint16)(((uint32)state->baseline * 3 + measurement) / 4);
+
+    offset = (int32)state->baseline - (int32)config->baseline;
+    if (offset > (int32)config->max_calibration_offset)
+        offset = config->max_calibration_offset;
+    else if (offset < -(int32)config->max_calibration_offset)
+        offset = -(int32)config->max_calibration_offset;
+
+    state->threshold_high = (uint16)(config->threshold_high + offset);
+    state->threshold_low = (uint16)(config->threshold_low + offset);
+    DEBUG_LOGF("vncl3020Calibrate baseline %d, thresholds %d %d",
+               state->baseline, state->threshold_low, state->threshold_high);
+
+    /* Only the high threshold is active when not in proximity */
+    PanicFalse(vncl3020SetHighThreshold(proximity->handle, state->threshold_high));
+}
+
 /*! \brief Handle the proximity interrupt */
 static void vncl3020InterruptHandler(Task task, MessageId id, Message msg)
 {
@@ -183,7 +234,7 @@ static void vncl3020InterruptHandler(Task task, MessageId id, Message msg)
                         /* Set high threshold to max to avoid further interrupts */
                         PanicFalse(vncl3020SetHighThreshold(proximity->handle, 0xffff));
                         /* Reinstate low threshold */
-                        PanicFalse(vncl3020SetLowThreshold(proximity->handle, config->threshold_low));
+                        PanicFalse(vncl3020SetLowThreshold(proximity->handle, proximity->state->threshold_low));
                         /* Inform clients */
                         appTaskListMessageSendId(proximity->clients, PROXIMITY_MESSAGE_IN_PROXIMITY);
                     }
@@ -194,7 +245,7 @@ static void vncl3020InterruptHandler(Task task, MessageId id, Message msg)
                         /* Set low threshold to min to avoid further interrupts */
                         PanicFalse(vncl3020SetLowThreshold(proximity->handle, 0));
                         /* Reinstate high threshold */
-                        PanicFalse(vncl3020SetHighThreshold(proximity->handle, config->threshold_high));
+                        PanicFalse(vncl3020SetHighThreshold(proximity->handle, proximity->state->threshold_high));
                         /* Inform clients */
                         appTaskListMessageSendId(proximity->clients, PROXIMITY_MESSAGE_NOT_IN_PROXIMITY);
                     }
@@ -311,6 +362,10 @@ bool appProximityClientRegister(Task task)
         prox->config = config;
         prox->state = PanicUnlessNew(proximityState);
         prox->state->proximity = proximity_state_unknown;
+        prox->state->baseline = 0;
+        prox->state->threshold_high = config->threshold_high;
+        prox->state->threshold_low = config->threshold_low;
+        prox->profile = proximity_rate_profile_normal;
         prox->clients = appTaskListInit();
 
         prox->handle = vncl3020Enable(config);
@@ -351,6 +406,32 @@ bool appProximityClientRegister(Task task)
     return appTaskListAddTask(prox->clients, task);
 }
 
+void appProximitySetRateProfile(proximityRateProfile profile)
+{
+    proximityTaskData *prox = appGetProximity();
+
+    if (NULL == prox->clients || prox->profile == profile)
+    {
+        return;
+    }
+
+    DEBUG_LOGF("appProximitySetRateProfile %d -> %d", prox->profile, profile);
+
+    /* The rate can only be changed with measurements stopped */
+    PanicFalse(vncl3020StopReading(prox->handle));
+
+    if (profile != proximity_rate_profile_off)
+    {
+        if (prox->state->proximity == proximity_state_not_in_proximity)
+        {
+            vncl3020Calibrate(prox);
+        }
+        PanicFalse(vncl3020SetRate(prox->handle, vncl3020GetProfileRate(prox->config, profile)));
+        PanicFalse(vncl3020SetPeriodic(prox->handle));
+    }
+    prox->profile = profile;
+}
+
 void appProximityClientUnregister(Task task)
 {
     proximityTaskData *prox = appGetProximity();
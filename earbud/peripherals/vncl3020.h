@@ -213,8 +213,19 @@ struct __proximity_config
     /*! The number of measurements above/below the threshold before the sensor
         generates an interrupt */
     enum vncl_threshold_counts threshold_counts;
-    /*! The number of measurements per second */
+    /*! The number of measurements per second (#proximity_rate_profile_normal) */
     enum vncl3020_proximity_rates rate;
+    /*! The number of measurements per second when at rest out of the ear
+        (#proximity_rate_profile_rest) */
+    enum vncl3020_proximity_rates rate_rest;
+    /*! The number of measurements per second after motion is detected
+        (#proximity_rate_profile_motion) */
+    enum vncl3020_proximity_rates rate_motion;
+    /*! The expected measurement with no object in proximity. The thresholds
+        are offset by the difference between this and the measured baseline. */
+    uint16 baseline;
+    /*! The maximum offset applied to the thresholds by calibration */
+    uint16 max_calibration_offset;
     /*! The PIOs used to control/communicate with the sensor */
     struct
     {
@@ -242,6 +253,13 @@ struct __proximity_state
 {
     /*! The sensor proximity state */
     enum proximity_states proximity;
+    /*! Filtered measurement with no object in proximity, zero until the
+        first measurement */
+    uint16 baseline;
+    /*! The calibrated high threshold */
+    uint16 threshold_high;
+    /*! The calibrated low threshold */
+    uint16 threshold_low;
 };
 
 #endif /* HAVE_VNCL3020 */